@@ -0,0 +1,252 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <new>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+// Аллокатор на malloc/free, умеющий менять размер уже выделенного буфера (reallocate).
+// Vector использует reallocate для тривиально перемещаемых типов, поэтому рост не требует второго буфера и копирования.
+// Крупные буферы на Linux выделяются напрямую через mmap и растут через mremap: ядро переставляет страницы,
+// а не копирует данные, и пиковое потребление памяти не удваивается
+template <typename T>
+class MallocAllocator {
+public:
+    using value_type = T;
+
+    // Буферы начиная с этого размера обслуживаются через mmap/mremap
+    static constexpr size_t MMAP_THRESHOLD = size_t{1} << 21;
+
+    static_assert(alignof(T) <= alignof(std::max_align_t), "malloc does not support over-aligned types");
+
+    MallocAllocator() = default;
+
+    template <typename U>
+    MallocAllocator(const MallocAllocator<U>& /*other*/) noexcept {
+    }
+
+    T* allocate(size_t n) {
+        if (n > std::allocator_traits<MallocAllocator>::max_size(*this)) {
+            throw std::bad_array_new_length();
+        }
+
+        const size_t bytes = n * sizeof(T);
+        void* buf = IsMapped(bytes) ? Map(bytes) : std::malloc(bytes);
+        if (buf == nullptr) {
+            throw std::bad_alloc();
+        }
+        return static_cast<T*>(buf);
+    }
+
+    void deallocate(T* buf, size_t n) noexcept {
+        const size_t bytes = n * sizeof(T);
+        if (IsMapped(bytes)) {
+            Unmap(buf, bytes);
+        } else {
+            std::free(buf);
+        }
+    }
+
+    // Меняет размер буфера buf с old_n на new_n элементов, сохраняя байты общей части.
+    // Адрес может измениться; при исключении buf остаётся действительным и нетронутым
+    T* reallocate(T* buf, size_t old_n, size_t new_n) {
+        if (buf == nullptr) {
+            return allocate(new_n);
+        }
+
+        const size_t old_bytes = old_n * sizeof(T);
+        const size_t new_bytes = new_n * sizeof(T);
+
+        if (!IsMapped(old_bytes) && !IsMapped(new_bytes)) {
+            if (new_n > std::allocator_traits<MallocAllocator>::max_size(*this)) {
+                throw std::bad_array_new_length();
+            }
+            void* new_buf = std::realloc(static_cast<void*>(buf), new_bytes);
+            if (new_buf == nullptr) {
+                throw std::bad_alloc();
+            }
+            return static_cast<T*>(new_buf);
+        }
+
+#ifdef __linux__
+        if (IsMapped(old_bytes) && IsMapped(new_bytes)) {
+            void* new_buf = mremap(buf, RoundToPages(old_bytes), RoundToPages(new_bytes), MREMAP_MAYMOVE);
+            if (new_buf == MAP_FAILED) {
+                throw std::bad_alloc();
+            }
+            return static_cast<T*>(new_buf);
+        }
+#endif
+
+        // Буфер переходит через порог mmap: копирование неизбежно, но происходит только один раз
+        T* new_buf = allocate(new_n);
+        std::memcpy(static_cast<void*>(new_buf), static_cast<const void*>(buf), std::min(old_bytes, new_bytes));
+        deallocate(buf, old_n);
+        return new_buf;
+    }
+
+    template <typename U>
+    bool operator==(const MallocAllocator<U>& /*other*/) const noexcept {
+        return true;
+    }
+
+private:
+    static bool IsMapped(size_t bytes) noexcept {
+#ifdef __linux__
+        return bytes >= MMAP_THRESHOLD;
+#else
+        (void)bytes;
+        return false;
+#endif
+    }
+
+#ifdef __linux__
+    static size_t RoundToPages(size_t bytes) noexcept {
+        static const size_t page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        return (bytes + page_size - 1) / page_size * page_size;
+    }
+
+    static void* Map(size_t bytes) noexcept {
+        void* buf = mmap(nullptr, RoundToPages(bytes), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        return buf == MAP_FAILED ? nullptr : buf;
+    }
+
+    static void Unmap(void* buf, size_t bytes) noexcept {
+        munmap(buf, RoundToPages(bytes));
+    }
+#else
+    static void* Map(size_t bytes) noexcept {
+        return std::malloc(bytes);
+    }
+
+    static void Unmap(void* buf, size_t /*bytes*/) noexcept {
+        std::free(buf);
+    }
+#endif
+};
+
+// Аллокатор, выравнивающий буфер не меньше чем по Alignment байт (и не меньше alignof(T)):
+// 64 - кэш-линия и загрузки AVX-512, 32 - AVX. Память выделяется выровненным operator new.
+// При HugePages буферы от HUGE_PAGE_SIZE на Linux выделяются через mmap с выравниванием по 2 МиБ
+// и помечаются MADV_HUGEPAGE: ядро подкладывает прозрачные огромные страницы, и длинные проходы по памяти
+// не упираются в промахи TLB. Если THP выключены, остаются обычные страницы
+template <typename T, size_t Alignment = alignof(T), bool HugePages = false>
+class AlignedAllocator {
+public:
+    using value_type = T;
+
+    static constexpr size_t ALIGNMENT = std::max(Alignment, alignof(T));
+    static constexpr size_t HUGE_PAGE_SIZE = size_t{1} << 21;
+
+    static_assert(std::has_single_bit(Alignment), "Alignment must be a power of two");
+    static_assert(!HugePages || ALIGNMENT <= HUGE_PAGE_SIZE, "Huge page buffers are aligned to HUGE_PAGE_SIZE only");
+
+    // Параметры-значения не подставляются allocator_traits автоматически
+    template <typename U>
+    struct rebind {
+        using other = AlignedAllocator<U, Alignment, HugePages>;
+    };
+
+    AlignedAllocator() = default;
+
+    template <typename U>
+    AlignedAllocator(const AlignedAllocator<U, Alignment, HugePages>& /*other*/) noexcept {
+    }
+
+    T* allocate(size_t n) {
+        if (n > std::allocator_traits<AlignedAllocator>::max_size(*this)) {
+            throw std::bad_array_new_length();
+        }
+
+        const size_t bytes = n * sizeof(T);
+        if (IsHuge(bytes)) {
+            void* buf = MapHuge(bytes);
+            if (buf == nullptr) {
+                throw std::bad_alloc();
+            }
+            return static_cast<T*>(buf);
+        }
+        return static_cast<T*>(::operator new(bytes, std::align_val_t{ALIGNMENT}));
+    }
+
+    void deallocate(T* buf, size_t n) noexcept {
+        const size_t bytes = n * sizeof(T);
+        if (IsHuge(bytes)) {
+            UnmapHuge(buf, bytes);
+        } else {
+            ::operator delete(buf, bytes, std::align_val_t{ALIGNMENT});
+        }
+    }
+
+    template <typename U>
+    bool operator==(const AlignedAllocator<U, Alignment, HugePages>& /*other*/) const noexcept {
+        return true;
+    }
+
+private:
+    static bool IsHuge(size_t bytes) noexcept {
+#ifdef __linux__
+        return HugePages && bytes >= HUGE_PAGE_SIZE;
+#else
+        (void)bytes;
+        return false;
+#endif
+    }
+
+#ifdef __linux__
+    static size_t RoundToHugePages(size_t bytes) noexcept {
+        return (bytes + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+    }
+
+    static void* MapHuge(size_t bytes) noexcept {
+        const size_t size = RoundToHugePages(bytes);
+        // Запас в одну огромную страницу позволяет выбрать выровненный участок, а обрезки сразу возвращаются ядру
+        void* raw = mmap(nullptr, size + HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (raw == MAP_FAILED) {
+            return nullptr;
+        }
+
+        const auto address = reinterpret_cast<uintptr_t>(raw);
+        const uintptr_t aligned = (address + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1);
+        if (aligned > address) {
+            munmap(raw, aligned - address);
+        }
+        const size_t tail = HUGE_PAGE_SIZE - (aligned - address);
+        if (tail > 0) {
+            munmap(reinterpret_cast<void*>(aligned + size), tail);
+        }
+
+        void* buf = reinterpret_cast<void*>(aligned);
+        madvise(buf, size, MADV_HUGEPAGE);
+        return buf;
+    }
+
+    static void UnmapHuge(void* buf, size_t bytes) noexcept {
+        munmap(buf, RoundToHugePages(bytes));
+    }
+#else
+    static void* MapHuge(size_t /*bytes*/) noexcept {
+        return nullptr;
+    }
+
+    static void UnmapHuge(void* /*buf*/, size_t /*bytes*/) noexcept {
+    }
+#endif
+};
+
+// Буфер по границе кэш-линии: соседние векторы не делят линии, а SIMD-загрузки выровнены
+template <typename T>
+using CacheAlignedAllocator = AlignedAllocator<T, 64>;
+
+// Как CacheAlignedAllocator, но большие буферы лежат на прозрачных огромных страницах
+template <typename T>
+using HugePageAllocator = AlignedAllocator<T, 64, true>;
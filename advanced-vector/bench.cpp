@@ -0,0 +1,660 @@
+#include "vector.h"
+
+#include <benchmark/benchmark.h>
+
+#include <malloc.h>
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <new>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Сравнение Vector и std::vector на типовых операциях.
+// Кроме времени для каждого замера выводятся число и объём аллокаций на итерацию, пик живой кучи и пиковый RSS.
+// Размеры по умолчанию ограничены примерно 1 ГиБ данных на тип, предел меняется переменной окружения BENCH_MAX_SIZE.
+// Отдельные операции выбираются стандартным --benchmark_filter, например --benchmark_filter='PushBack/int/'
+
+namespace {
+
+// Счётчики глобального operator new: подменяются ниже и видят аллокации обоих контейнеров
+struct AllocationStats {
+    std::atomic<size_t> count = 0;
+    std::atomic<size_t> bytes = 0;
+    std::atomic<size_t> live = 0;
+    std::atomic<size_t> peak = 0;
+};
+
+AllocationStats allocation_stats;
+
+void* CountedAllocate(size_t bytes, size_t alignment) {
+    void* buf = nullptr;
+    if (alignment <= alignof(std::max_align_t)) {
+        buf = std::malloc(bytes == 0 ? 1 : bytes);
+    } else if (posix_memalign(&buf, alignment, bytes == 0 ? 1 : bytes) != 0) {
+        buf = nullptr;
+    }
+    if (buf == nullptr) {
+        throw std::bad_alloc();
+    }
+
+    const size_t usable = malloc_usable_size(buf);
+    allocation_stats.count.fetch_add(1, std::memory_order_relaxed);
+    allocation_stats.bytes.fetch_add(bytes, std::memory_order_relaxed);
+    const size_t live = allocation_stats.live.fetch_add(usable, std::memory_order_relaxed) + usable;
+    size_t peak = allocation_stats.peak.load(std::memory_order_relaxed);
+    while (live > peak && !allocation_stats.peak.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {
+    }
+    return buf;
+}
+
+void CountedFree(void* buf) noexcept {
+    if (buf != nullptr) {
+        allocation_stats.live.fetch_sub(malloc_usable_size(buf), std::memory_order_relaxed);
+        std::free(buf);
+    }
+}
+
+} // namespace
+
+void* operator new(size_t bytes) {
+    return CountedAllocate(bytes, 0);
+}
+
+void* operator new[](size_t bytes) {
+    return CountedAllocate(bytes, 0);
+}
+
+void* operator new(size_t bytes, std::align_val_t alignment) {
+    return CountedAllocate(bytes, static_cast<size_t>(alignment));
+}
+
+void* operator new[](size_t bytes, std::align_val_t alignment) {
+    return CountedAllocate(bytes, static_cast<size_t>(alignment));
+}
+
+void operator delete(void* buf) noexcept {
+    CountedFree(buf);
+}
+
+void operator delete[](void* buf) noexcept {
+    CountedFree(buf);
+}
+
+void operator delete(void* buf, size_t /*bytes*/) noexcept {
+    CountedFree(buf);
+}
+
+void operator delete[](void* buf, size_t /*bytes*/) noexcept {
+    CountedFree(buf);
+}
+
+void operator delete(void* buf, std::align_val_t /*alignment*/) noexcept {
+    CountedFree(buf);
+}
+
+void operator delete[](void* buf, std::align_val_t /*alignment*/) noexcept {
+    CountedFree(buf);
+}
+
+void operator delete(void* buf, size_t /*bytes*/, std::align_val_t /*alignment*/) noexcept {
+    CountedFree(buf);
+}
+
+void operator delete[](void* buf, size_t /*bytes*/, std::align_val_t /*alignment*/) noexcept {
+    CountedFree(buf);
+}
+
+namespace {
+
+using benchmark::Counter;
+using benchmark::State;
+
+// Сбрасывает пиковый RSS процесса (VmHWM), чтобы каждый замер видел только свой пик. Доступно в Linux 4.0+
+void ResetPeakRss() {
+    std::ofstream clear_refs("/proc/self/clear_refs");
+    clear_refs << "5";
+}
+
+size_t PeakRssBytes() {
+    std::ifstream status("/proc/self/status");
+    std::string key;
+    while (status >> key) {
+        if (key == "VmHWM:") {
+            size_t kib = 0;
+            status >> kib;
+            return kib * 1024;
+        }
+    }
+
+    // Без procfs остаётся пик за всё время работы процесса
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    return static_cast<size_t>(usage.ru_maxrss) * 1024;
+}
+
+// Снимает показания аллокаций за один замер. Создаётся до подготовки данных, чтобы пики учитывали их,
+// а Start() вызывается перед циклом замера, чтобы аллокации подготовки не попали в счётчики на итерацию
+class AllocationMeter {
+public:
+    explicit AllocationMeter(State& state)
+        : state_(state) {
+        ResetPeakRss();
+        allocation_stats.peak.store(allocation_stats.live.load());
+    }
+
+    AllocationMeter(const AllocationMeter&) = delete;
+    AllocationMeter& operator=(const AllocationMeter&) = delete;
+
+    ~AllocationMeter() {
+        const double count = static_cast<double>(allocation_stats.count.load() - count_);
+        const double bytes = static_cast<double>(allocation_stats.bytes.load() - bytes_);
+        const double peak_heap = static_cast<double>(allocation_stats.peak.load());
+
+        state_.counters["allocs"] = Counter(count, Counter::kAvgIterations);
+        state_.counters["alloc_bytes"] = Counter(bytes, Counter::kAvgIterations, Counter::kIs1024);
+        state_.counters["peak_heap"] = Counter(peak_heap, Counter::kDefaults, Counter::kIs1024);
+        state_.counters["peak_rss"] = Counter(static_cast<double>(PeakRssBytes()), Counter::kDefaults, Counter::kIs1024);
+    }
+
+    void Start() noexcept {
+        count_ = allocation_stats.count.load();
+        bytes_ = allocation_stats.bytes.load();
+    }
+
+    // Выполняет setup вне замера: ни время, ни аллокации внутри него не попадают в результаты
+    template <typename Setup>
+    void Untimed(Setup setup) {
+        state_.PauseTiming();
+        const size_t count = allocation_stats.count.load();
+        const size_t bytes = allocation_stats.bytes.load();
+        setup();
+        count_ += allocation_stats.count.load() - count;
+        bytes_ += allocation_stats.bytes.load() - bytes;
+        state_.ResumeTiming();
+    }
+
+private:
+    State& state_;
+    size_t count_ = 0;
+    size_t bytes_ = 0;
+};
+
+// Типы элементов
+
+struct Pod {
+    int64_t a = 0;
+    int64_t b = 0;
+    int64_t c = 0;
+    int64_t d = 0;
+};
+
+using MoveOnly = std::unique_ptr<int>;
+
+// Для каждого типа: имя в отчёте, примерный расход памяти на элемент, создание значений и "вес" для обхода
+template <typename T>
+struct ElementTraits;
+
+template <>
+struct ElementTraits<int> {
+    static constexpr const char* NAME = "int";
+    static constexpr size_t FOOTPRINT = sizeof(int);
+
+    static int Make(size_t i) {
+        return static_cast<int>(i);
+    }
+
+    template <typename Emplace>
+    static void EmplaceWith(Emplace emplace, size_t i) {
+        emplace(static_cast<int>(i));
+    }
+
+    static int64_t Weight(int value) {
+        return value;
+    }
+};
+
+template <>
+struct ElementTraits<Pod> {
+    static constexpr const char* NAME = "pod";
+    static constexpr size_t FOOTPRINT = sizeof(Pod);
+
+    static Pod Make(size_t i) {
+        const auto value = static_cast<int64_t>(i);
+        return {value, value, value, value};
+    }
+
+    template <typename Emplace>
+    static void EmplaceWith(Emplace emplace, size_t i) {
+        emplace(Make(i));
+    }
+
+    static int64_t Weight(const Pod& value) {
+        return value.a;
+    }
+};
+
+template <>
+struct ElementTraits<std::string> {
+    static constexpr const char* NAME = "string";
+    // Строки длиннее SSO-буфера, поэтому каждая владеет блоком в куче
+    static constexpr size_t LENGTH = 32;
+    static constexpr size_t FOOTPRINT = sizeof(std::string) + 48;
+
+    static std::string Make(size_t i) {
+        return std::string(LENGTH, static_cast<char>('a' + i % 26));
+    }
+
+    template <typename Emplace>
+    static void EmplaceWith(Emplace emplace, size_t i) {
+        emplace(LENGTH, static_cast<char>('a' + i % 26));
+    }
+
+    static int64_t Weight(const std::string& value) {
+        return static_cast<int64_t>(value.size());
+    }
+};
+
+template <>
+struct ElementTraits<MoveOnly> {
+    static constexpr const char* NAME = "move_only";
+    static constexpr size_t FOOTPRINT = sizeof(MoveOnly) + 32;
+
+    static MoveOnly Make(size_t i) {
+        return std::make_unique<int>(static_cast<int>(i));
+    }
+
+    template <typename Emplace>
+    static void EmplaceWith(Emplace emplace, size_t i) {
+        emplace(new int(static_cast<int>(i)));
+    }
+
+    static int64_t Weight(const MoveOnly& value) {
+        return *value;
+    }
+};
+
+// Источник вставляемых значений: копируемые типы вставляются копией заранее созданного образца,
+// move-only типы создаются заново на каждую вставку
+template <typename T>
+class Sample {
+public:
+    decltype(auto) Get([[maybe_unused]] size_t i) const {
+        if constexpr (std::is_copy_constructible_v<T>) {
+            return (value_);
+        } else {
+            return ElementTraits<T>::Make(i);
+        }
+    }
+
+private:
+    T value_ = ElementTraits<T>::Make(1);
+};
+
+// Единый интерфейс к сравниваемым контейнерам
+
+template <typename T>
+struct StdVectorOps {
+    using Container = std::vector<T>;
+    static constexpr const char* NAME = "std::vector";
+
+    template <typename U>
+    static void PushBack(Container& c, U&& value) {
+        c.push_back(std::forward<U>(value));
+    }
+
+    template <typename... Args>
+    static void EmplaceBack(Container& c, Args&&... args) {
+        c.emplace_back(std::forward<Args>(args)...);
+    }
+
+    template <typename U>
+    static void Insert(Container& c, size_t index, U&& value) {
+        c.insert(c.begin() + index, std::forward<U>(value));
+    }
+
+    static void Erase(Container& c, size_t index) {
+        c.erase(c.begin() + index);
+    }
+
+    static void Reserve(Container& c, size_t capacity) {
+        c.reserve(capacity);
+    }
+
+    static void ShrinkToFit(Container& c) {
+        c.shrink_to_fit();
+    }
+
+    static void Resize(Container& c, size_t size) {
+        c.resize(size);
+    }
+
+    static size_t Size(const Container& c) {
+        return c.size();
+    }
+
+    static const T* Data(const Container& c) {
+        return c.data();
+    }
+};
+
+template <typename T>
+struct VectorOps {
+    using Container = Vector<T>;
+    static constexpr const char* NAME = "Vector";
+
+    template <typename U>
+    static void PushBack(Container& c, U&& value) {
+        c.PushBack(std::forward<U>(value));
+    }
+
+    template <typename... Args>
+    static void EmplaceBack(Container& c, Args&&... args) {
+        c.EmplaceBack(std::forward<Args>(args)...);
+    }
+
+    template <typename U>
+    static void Insert(Container& c, size_t index, U&& value) {
+        c.Insert(c.begin() + index, std::forward<U>(value));
+    }
+
+    static void Erase(Container& c, size_t index) {
+        c.Erase(c.begin() + index);
+    }
+
+    static void Reserve(Container& c, size_t capacity) {
+        c.Reserve(capacity);
+    }
+
+    static void ShrinkToFit(Container& c) {
+        c.ShrinkToFit();
+    }
+
+    static void Resize(Container& c, size_t size) {
+        c.Resize(size);
+    }
+
+    static size_t Size(const Container& c) {
+        return c.Size();
+    }
+
+    static const T* Data(const Container& c) {
+        return c.begin();
+    }
+};
+
+template <typename Ops, typename T>
+typename Ops::Container MakeFilled(size_t size) {
+    typename Ops::Container c;
+    Ops::Reserve(c, size);
+    for (size_t i = 0; i < size; ++i) {
+        Ops::PushBack(c, ElementTraits<T>::Make(i));
+    }
+    return c;
+}
+
+enum class Position { FRONT, MIDDLE, BACK };
+
+size_t IndexAt(Position position, size_t size) {
+    switch (position) {
+        case Position::FRONT:
+            return 0;
+        case Position::MIDDLE:
+            return size / 2;
+        case Position::BACK:
+            break;
+    }
+    return size;
+}
+
+// Замеры. Каждый получает размер n и сообщает число обработанных элементов, чтобы отчёт показывал пропускную способность
+
+template <typename Ops, typename T>
+void BM_PushBack(State& state, size_t n) {
+    AllocationMeter meter(state);
+    const Sample<T> sample;
+    meter.Start();
+    for (auto _ : state) {
+        typename Ops::Container c;
+        for (size_t i = 0; i < n; ++i) {
+            Ops::PushBack(c, sample.Get(i));
+        }
+        benchmark::DoNotOptimize(Ops::Data(c));
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * n));
+}
+
+template <typename Ops, typename T>
+void BM_EmplaceBack(State& state, size_t n) {
+    AllocationMeter meter(state);
+    meter.Start();
+    for (auto _ : state) {
+        typename Ops::Container c;
+        for (size_t i = 0; i < n; ++i) {
+            ElementTraits<T>::EmplaceWith([&c](auto&&... args) {
+                Ops::EmplaceBack(c, std::forward<decltype(args)>(args)...);
+            }, i);
+        }
+        benchmark::DoNotOptimize(Ops::Data(c));
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * n));
+}
+
+// Одна вставка на итерацию в вектор из n..2n элементов; по достижении 2n размер возвращается к n вне замера
+template <typename Ops, typename T, Position position>
+void BM_Insert(State& state, size_t n) {
+    AllocationMeter meter(state);
+    auto c = MakeFilled<Ops, T>(n);
+    const Sample<T> sample;
+    meter.Start();
+    size_t i = 0;
+    for (auto _ : state) {
+        Ops::Insert(c, IndexAt(position, Ops::Size(c)), sample.Get(i++));
+        if (Ops::Size(c) >= 2 * n) {
+            meter.Untimed([&c, n] {
+                Ops::Resize(c, n);
+            });
+        }
+    }
+    benchmark::DoNotOptimize(Ops::Data(c));
+    state.SetItemsProcessed(state.iterations());
+}
+
+// Одно удаление на итерацию; опустевший вектор заполняется заново вне замера
+template <typename Ops, typename T, Position position>
+void BM_Erase(State& state, size_t n) {
+    AllocationMeter meter(state);
+    auto c = MakeFilled<Ops, T>(n);
+    meter.Start();
+    for (auto _ : state) {
+        if (Ops::Size(c) == 0) {
+            meter.Untimed([&c, n] {
+                c = MakeFilled<Ops, T>(n);
+            });
+        }
+        Ops::Erase(c, IndexAt(position, Ops::Size(c) - 1));
+    }
+    benchmark::DoNotOptimize(Ops::Data(c));
+    state.SetItemsProcessed(state.iterations());
+}
+
+// Перенос n элементов в вдвое больший буфер и обратно: ShrinkToFit возвращает вектор в исходное состояние,
+// чтобы каждая итерация Reserve действительно перевыделяла память
+template <typename Ops, typename T>
+void BM_Reserve(State& state, size_t n) {
+    AllocationMeter meter(state);
+    auto c = MakeFilled<Ops, T>(n);
+    meter.Start();
+    for (auto _ : state) {
+        Ops::Reserve(c, 2 * n);
+        Ops::ShrinkToFit(c);
+        benchmark::DoNotOptimize(Ops::Data(c));
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * n * 2));
+}
+
+// Создание и разрушение n элементов в пределах уже выделенной ёмкости
+template <typename Ops, typename T>
+void BM_Resize(State& state, size_t n) {
+    AllocationMeter meter(state);
+    auto c = MakeFilled<Ops, T>(n);
+    meter.Start();
+    for (auto _ : state) {
+        Ops::Resize(c, 2 * n);
+        Ops::Resize(c, n);
+        benchmark::DoNotOptimize(Ops::Data(c));
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * n));
+}
+
+template <typename Ops, typename T>
+void BM_CopyAssign(State& state, size_t n) {
+    AllocationMeter meter(state);
+    const auto source = MakeFilled<Ops, T>(n);
+    typename Ops::Container c;
+    meter.Start();
+    for (auto _ : state) {
+        c = source;
+        benchmark::DoNotOptimize(Ops::Data(c));
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * n));
+}
+
+template <typename Ops, typename T>
+void BM_MoveAssign(State& state, size_t n) {
+    AllocationMeter meter(state);
+    auto a = MakeFilled<Ops, T>(n);
+    typename Ops::Container b;
+    meter.Start();
+    for (auto _ : state) {
+        b = std::move(a);
+        a = std::move(b);
+        benchmark::DoNotOptimize(Ops::Data(a));
+    }
+    state.SetItemsProcessed(state.iterations() * 2);
+}
+
+template <typename Ops, typename T>
+void BM_Iterate(State& state, size_t n) {
+    AllocationMeter meter(state);
+    const auto c = MakeFilled<Ops, T>(n);
+    meter.Start();
+    for (auto _ : state) {
+        int64_t sum = 0;
+        for (const T& value : c) {
+            sum += ElementTraits<T>::Weight(value);
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * n));
+}
+
+// Регистрация: для каждой операции, типа и размера замеры std::vector и Vector идут подряд
+
+constexpr size_t MAX_SIZE = 100'000'000;
+constexpr size_t MAX_BYTES_PER_TYPE = size_t{1} << 30;
+
+size_t MaxSizeFromEnv() {
+    if (const char* value = std::getenv("BENCH_MAX_SIZE")) {
+        return std::strtoull(value, nullptr, 10);
+    }
+    return MAX_SIZE;
+}
+
+template <typename T>
+std::vector<size_t> SizesFor(size_t max_size) {
+    max_size = std::min(max_size, MAX_BYTES_PER_TYPE / ElementTraits<T>::FOOTPRINT);
+
+    std::vector<size_t> sizes;
+    for (size_t size = 8; size <= max_size && size < MAX_SIZE; size *= 8) {
+        sizes.push_back(size);
+    }
+    if (MAX_SIZE <= max_size) {
+        sizes.push_back(MAX_SIZE);
+    }
+    return sizes;
+}
+
+// bench(ops, state, n) вызывается с пустым объектом StdVectorOps<T> или VectorOps<T>, тип которого выбирает контейнер
+template <typename T, typename Bench>
+void RegisterPair(const char* operation, const std::vector<size_t>& sizes, Bench bench) {
+    for (size_t n : sizes) {
+        const std::string prefix = std::string(operation) + "/" + ElementTraits<T>::NAME + "/" + std::to_string(n) + "/";
+        benchmark::RegisterBenchmark((prefix + StdVectorOps<T>::NAME).c_str(), [bench, n](State& state) {
+            bench(StdVectorOps<T>{}, state, n);
+        })->Unit(benchmark::kMicrosecond);
+        benchmark::RegisterBenchmark((prefix + VectorOps<T>::NAME).c_str(), [bench, n](State& state) {
+            bench(VectorOps<T>{}, state, n);
+        })->Unit(benchmark::kMicrosecond);
+    }
+}
+
+template <typename T>
+void RegisterType(size_t max_size) {
+    const std::vector<size_t> sizes = SizesFor<T>(max_size);
+
+    RegisterPair<T>("PushBack", sizes, []<typename Ops>(Ops, State& state, size_t n) {
+        BM_PushBack<Ops, T>(state, n);
+    });
+    RegisterPair<T>("EmplaceBack", sizes, []<typename Ops>(Ops, State& state, size_t n) {
+        BM_EmplaceBack<Ops, T>(state, n);
+    });
+    RegisterPair<T>("InsertFront", sizes, []<typename Ops>(Ops, State& state, size_t n) {
+        BM_Insert<Ops, T, Position::FRONT>(state, n);
+    });
+    RegisterPair<T>("InsertMiddle", sizes, []<typename Ops>(Ops, State& state, size_t n) {
+        BM_Insert<Ops, T, Position::MIDDLE>(state, n);
+    });
+    RegisterPair<T>("InsertBack", sizes, []<typename Ops>(Ops, State& state, size_t n) {
+        BM_Insert<Ops, T, Position::BACK>(state, n);
+    });
+    RegisterPair<T>("EraseFront", sizes, []<typename Ops>(Ops, State& state, size_t n) {
+        BM_Erase<Ops, T, Position::FRONT>(state, n);
+    });
+    RegisterPair<T>("EraseMiddle", sizes, []<typename Ops>(Ops, State& state, size_t n) {
+        BM_Erase<Ops, T, Position::MIDDLE>(state, n);
+    });
+    RegisterPair<T>("Reserve", sizes, []<typename Ops>(Ops, State& state, size_t n) {
+        BM_Reserve<Ops, T>(state, n);
+    });
+    RegisterPair<T>("Resize", sizes, []<typename Ops>(Ops, State& state, size_t n) {
+        BM_Resize<Ops, T>(state, n);
+    });
+    if constexpr (std::is_copy_constructible_v<T>) {
+        RegisterPair<T>("CopyAssign", sizes, []<typename Ops>(Ops, State& state, size_t n) {
+            BM_CopyAssign<Ops, T>(state, n);
+        });
+    }
+    RegisterPair<T>("MoveAssign", sizes, []<typename Ops>(Ops, State& state, size_t n) {
+        BM_MoveAssign<Ops, T>(state, n);
+    });
+    RegisterPair<T>("Iterate", sizes, []<typename Ops>(Ops, State& state, size_t n) {
+        BM_Iterate<Ops, T>(state, n);
+    });
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+        return 1;
+    }
+
+    const size_t max_size = MaxSizeFromEnv();
+    RegisterType<int>(max_size);
+    RegisterType<Pod>(max_size);
+    RegisterType<std::string>(max_size);
+    RegisterType<MoveOnly>(max_size);
+
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
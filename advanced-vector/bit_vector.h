@@ -0,0 +1,716 @@
+#pragma once
+
+#include "vector.h"
+
+#include <algorithm>
+#include <bit>
+#include <compare>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+// Плотно упакованные массивы мелких значений поверх Vector<uint64_t>: BitVector хранит по биту на флаг,
+// PackedVector<Bits> - по Bits бит на число. Память и время полного прохода уменьшаются в 8 раз для флагов
+// (по сравнению с байтом на bool) и в 32 / Bits раза для индексов, которые иначе лежали бы в uint32_t.
+// В обоих классах биты за последним элементом всегда нулевые, поэтому сравнение, подсчёт и поиск работают
+// целыми словами без маски хвоста
+
+namespace detail {
+
+inline constexpr size_t BITS_PER_WORD = 64;
+
+// Сколько слов нужно под bits бит
+constexpr size_t WordCount(size_t bits) noexcept {
+    return (bits + BITS_PER_WORD - 1) / BITS_PER_WORD;
+}
+
+// Обнуляет биты последнего слова с номерами от used_bits и дальше
+inline void ClearTailBits(uint64_t* words, size_t used_bits) noexcept {
+    if (const size_t tail = used_bits % BITS_PER_WORD; tail != 0) {
+        words[used_bits / BITS_PER_WORD] &= (uint64_t{1} << tail) - 1;
+    }
+}
+
+// Наименьший беззнаковый тип, вмещающий Bits бит
+template <unsigned Bits>
+using PackedValue = std::conditional_t<
+    Bits <= 8, uint8_t,
+    std::conditional_t<Bits <= 16, uint16_t, std::conditional_t<Bits <= 32, uint32_t, uint64_t>>>;
+
+}  // namespace detail
+
+// Вектор флагов по биту на элемент. Кроме доступа по индексу умеет то, что по одному bool делать долго:
+// Count (popcount по словам), поиск первого установленного или сброшенного бита начиная с позиции,
+// обход установленных битов и побитовые &=, |=, ^=, AndNot над векторами одного размера. Массовые операции - простые
+// циклы по массиву uint64_t, которые компилятор векторизует
+//     BitVector used(slots);
+//     size_t free_slot = used.FindFirstZero();
+//     used.Set(free_slot);
+template <typename Allocator = std::allocator<uint64_t>>
+class BitVector {
+public:
+    using Word = uint64_t;
+    using value_type = bool;
+    using allocator_type = Allocator;
+
+    static constexpr size_t NPOS = static_cast<size_t>(-1);
+
+    // Ссылка на бит для v[i] = value
+    class Reference {
+    public:
+        Reference(const Reference&) = default;
+
+        Reference& operator=(bool value) noexcept {
+            if (value) {
+                *word_ |= mask_;
+            } else {
+                *word_ &= ~mask_;
+            }
+            return *this;
+        }
+
+        Reference& operator=(const Reference& other) noexcept {
+            return *this = static_cast<bool>(other);
+        }
+
+        operator bool() const noexcept {
+            return (*word_ & mask_) != 0;
+        }
+
+        void Flip() noexcept {
+            *word_ ^= mask_;
+        }
+
+    private:
+        friend class BitVector;
+
+        Reference(Word* word, Word mask) noexcept
+            : word_(word)
+            , mask_(mask) {
+        }
+
+        Word* word_;
+        Word mask_;
+    };
+
+    BitVector() = default;
+
+    // Аллокатор не выводится из аргумента, иначе BitVector bits(n) вывел бы Allocator = size_t
+    explicit BitVector(const std::type_identity_t<Allocator>& alloc) noexcept
+        : words_(alloc) {
+    }
+
+    explicit BitVector(size_t size, bool value = false, const Allocator& alloc = Allocator())
+        : words_(detail::WordCount(size), value ? ~Word{0} : Word{0}, alloc)
+        , size_(size) {
+        detail::ClearTailBits(words_.Data(), size_);
+    }
+
+    BitVector(std::initializer_list<bool> values, const Allocator& alloc = Allocator())
+        : words_(detail::WordCount(values.size()), alloc)
+        , size_(values.size()) {
+        size_t index = 0;
+        for (bool value : values) {
+            Set(index++, value);
+        }
+    }
+
+    allocator_type GetAllocator() const noexcept {
+        return words_.GetAllocator();
+    }
+
+    size_t Size() const noexcept {
+        return size_;
+    }
+
+    size_t Capacity() const noexcept {
+        return words_.Capacity() * detail::BITS_PER_WORD;
+    }
+
+    void Reserve(size_t new_capacity) {
+        words_.Reserve(detail::WordCount(new_capacity));
+    }
+
+    // Новые биты получают значение value
+    void Resize(size_t new_size, bool value = false) {
+        words_.Resize(detail::WordCount(new_size));
+        const size_t old_size = std::exchange(size_, new_size);
+        if (new_size > old_size) {
+            Fill(old_size, new_size, value);
+        } else {
+            detail::ClearTailBits(words_.Data(), size_);
+        }
+    }
+
+    void ShrinkToFit() {
+        words_.ShrinkToFit();
+    }
+
+    void Clear() noexcept {
+        words_.Clear();
+        size_ = 0;
+    }
+
+    bool operator[](size_t index) const noexcept {
+        return Test(index);
+    }
+
+    Reference operator[](size_t index) noexcept {
+        ADVANCED_VECTOR_CHECK_BOUNDS(index < size_);
+        return Reference(WordOf(index), MaskOf(index));
+    }
+
+    bool Test(size_t index) const noexcept {
+        ADVANCED_VECTOR_CHECK_BOUNDS(index < size_);
+        return (words_.Data()[index / detail::BITS_PER_WORD] & MaskOf(index)) != 0;
+    }
+
+    // Доступ с проверкой индекса при любом уровне проверок
+    bool At(size_t index) const {
+        if (index >= size_) [[unlikely]] {
+            throw std::out_of_range("BitVector index out of range");
+        }
+        return Test(index);
+    }
+
+    void Set(size_t index, bool value = true) noexcept {
+        (*this)[index] = value;
+    }
+
+    void Reset(size_t index) noexcept {
+        Set(index, false);
+    }
+
+    void Flip(size_t index) noexcept {
+        (*this)[index].Flip();
+    }
+
+    // Инвертирует все биты
+    void Flip() noexcept {
+        Word* words = words_.Data();
+        for (size_t i = 0; i < words_.Size(); ++i) {
+            words[i] = ~words[i];
+        }
+        detail::ClearTailBits(words, size_);
+    }
+
+    void SetAll() noexcept {
+        Fill(0, size_, true);
+    }
+
+    void ResetAll() noexcept {
+        Fill(0, size_, false);
+    }
+
+    // Присваивает value битам [first, last): частичные слова по маске, остальные целиком
+    void Fill(size_t first, size_t last, bool value) noexcept {
+        ADVANCED_VECTOR_CHECK_BOUNDS(first <= last && last <= size_);
+        Word* words = words_.Data();
+        while (first < last) {
+            const size_t offset = first % detail::BITS_PER_WORD;
+            const size_t count = std::min(detail::BITS_PER_WORD - offset, last - first);
+            const Word mask = (count == detail::BITS_PER_WORD ? ~Word{0} : (Word{1} << count) - 1) << offset;
+            Word& word = words[first / detail::BITS_PER_WORD];
+            word = value ? word | mask : word & ~mask;
+            first += count;
+        }
+    }
+
+    bool Front() const noexcept {
+        return Test(0);
+    }
+
+    bool Back() const noexcept {
+        ADVANCED_VECTOR_CHECK_BOUNDS(size_ != 0);
+        return Test(size_ - 1);
+    }
+
+    void PushBack(bool value) {
+        if (size_ % detail::BITS_PER_WORD == 0) {
+            words_.PushBack(Word{0});
+        }
+        ++size_;
+        Set(size_ - 1, value);
+    }
+
+    void PopBack() noexcept {
+        ADVANCED_VECTOR_CHECK_BOUNDS(size_ != 0);
+        Reset(size_ - 1);
+        --size_;
+        if (size_ % detail::BITS_PER_WORD == 0) {
+            words_.PopBack();
+        }
+    }
+
+    // Число установленных битов
+    size_t Count() const noexcept {
+        const Word* words = words_.Data();
+        size_t count = 0;
+        for (size_t i = 0; i < words_.Size(); ++i) {
+            count += std::popcount(words[i]);
+        }
+        return count;
+    }
+
+    bool Any() const noexcept {
+        return std::ranges::any_of(Words(), [](Word word) {
+            return word != 0;
+        });
+    }
+
+    bool None() const noexcept {
+        return !Any();
+    }
+
+    bool All() const noexcept {
+        return Count() == size_;
+    }
+
+    // Позиция первого установленного бита не раньше from или NPOS
+    size_t FindFirst(size_t from = 0) const noexcept {
+        return Find<false>(from);
+    }
+
+    // Позиция первого сброшенного бита не раньше from или NPOS
+    size_t FindFirstZero(size_t from = 0) const noexcept {
+        return Find<true>(from);
+    }
+
+    // Вызывает f(index) для каждого установленного бита по возрастанию: пустые слова пропускаются целиком,
+    // а внутри слова биты перебираются через countr_zero без проверки каждого
+    template <typename F>
+    void ForEachSet(F f) const {
+        const Word* words = words_.Data();
+        for (size_t i = 0; i < words_.Size(); ++i) {
+            for (Word word = words[i]; word != 0; word &= word - 1) {
+                f(i * detail::BITS_PER_WORD + std::countr_zero(word));
+            }
+        }
+    }
+
+    // Побитовые операции с вектором того же размера. Хвостовые нули сохраняются сами собой
+    BitVector& operator&=(const BitVector& rhs) noexcept {
+        Combine(rhs, [](Word lhs, Word rhs) { return lhs & rhs; });
+        return *this;
+    }
+
+    BitVector& operator|=(const BitVector& rhs) noexcept {
+        Combine(rhs, [](Word lhs, Word rhs) { return lhs | rhs; });
+        return *this;
+    }
+
+    BitVector& operator^=(const BitVector& rhs) noexcept {
+        Combine(rhs, [](Word lhs, Word rhs) { return lhs ^ rhs; });
+        return *this;
+    }
+
+    // Сбрасывает биты, установленные в rhs (*this &= ~rhs без временного вектора)
+    BitVector& AndNot(const BitVector& rhs) noexcept {
+        Combine(rhs, [](Word lhs, Word rhs) { return lhs & ~rhs; });
+        return *this;
+    }
+
+    // Слова с битами: бит i лежит в слове i / 64 на позиции i % 64
+    std::span<const Word> Words() const noexcept {
+        return {words_.Data(), words_.Size()};
+    }
+
+    void Swap(BitVector& other) noexcept {
+        words_.Swap(other.words_);
+        std::swap(size_, other.size_);
+    }
+
+    friend bool operator==(const BitVector& lhs, const BitVector& rhs) noexcept {
+        return lhs.size_ == rhs.size_ && std::ranges::equal(lhs.Words(), rhs.Words());
+    }
+
+private:
+    Vector<Word, Allocator> words_;
+    size_t size_ = 0;
+
+    static Word MaskOf(size_t index) noexcept {
+        return Word{1} << (index % detail::BITS_PER_WORD);
+    }
+
+    Word* WordOf(size_t index) noexcept {
+        return words_.Data() + index / detail::BITS_PER_WORD;
+    }
+
+    template <bool Zero>
+    size_t Find(size_t from) const noexcept {
+        if (from >= size_) {
+            return NPOS;
+        }
+        const Word* words = words_.Data();
+        size_t i = from / detail::BITS_PER_WORD;
+        Word word = (Zero ? ~words[i] : words[i]) & (~Word{0} << (from % detail::BITS_PER_WORD));
+        while (word == 0) {
+            if (++i == words_.Size()) {
+                return NPOS;
+            }
+            word = Zero ? ~words[i] : words[i];
+        }
+        // Инвертированный хвост состоит из единиц: найденный в нём бит - за концом вектора
+        const size_t pos = i * detail::BITS_PER_WORD + std::countr_zero(word);
+        return pos < size_ ? pos : NPOS;
+    }
+
+    template <typename Operation>
+    void Combine(const BitVector& rhs, Operation op) noexcept {
+        ADVANCED_VECTOR_CHECK_BOUNDS(size_ == rhs.size_);
+        Word* words = words_.Data();
+        const Word* other = rhs.words_.Data();
+        for (size_t i = 0; i < words_.Size(); ++i) {
+            words[i] = op(words[i], other[i]);
+        }
+    }
+};
+
+// Вектор беззнаковых чисел по Bits бит каждое (1 <= Bits <= 64), записанных подряд в массив слов без промежутков:
+// например, идентификаторы меньше 2^20 занимают 20 бит вместо 32. Get/Set по индексу - сдвиг и маска одного слова
+// или, если число пересекает границу слов, двух соседних; при Bits, делящем 64, второго слова не бывает.
+// Последовательный проход лучше делать через ForEach, который сдвигается по словам без умножения на индекс.
+// Изменение элемента - Set или v[i] = value; итераторы только читают
+//     PackedVector<20> ids;
+//     ids.PushBack(node_id);
+//     ids.ForEach([&](uint32_t id) { ++degree[id]; });
+template <unsigned Bits, typename Allocator = std::allocator<uint64_t>>
+class PackedVector {
+    static_assert(Bits >= 1 && Bits <= detail::BITS_PER_WORD, "PackedVector element must fit in one word");
+
+    using Word = uint64_t;
+
+    // Элементы не пересекают границу слов
+    static constexpr bool ALIGNED = detail::BITS_PER_WORD % Bits == 0;
+
+public:
+    using value_type = detail::PackedValue<Bits>;
+    using allocator_type = Allocator;
+
+    static constexpr Word MAX_VALUE = Bits == detail::BITS_PER_WORD ? ~Word{0} : (Word{1} << Bits) - 1;
+
+    class Reference {
+    public:
+        Reference(const Reference&) = default;
+
+        Reference& operator=(value_type value) noexcept {
+            vector_->Set(index_, value);
+            return *this;
+        }
+
+        Reference& operator=(const Reference& other) noexcept {
+            return *this = static_cast<value_type>(other);
+        }
+
+        operator value_type() const noexcept {
+            return vector_->Get(index_);
+        }
+
+    private:
+        friend class PackedVector;
+
+        Reference(PackedVector* vector, size_t index) noexcept
+            : vector_(vector)
+            , index_(index) {
+        }
+
+        PackedVector* vector_;
+        size_t index_;
+    };
+
+    // Итератор произвольного доступа, разыменование которого распаковывает значение
+    class const_iterator {
+    public:
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type = PackedVector::value_type;
+        using difference_type = std::ptrdiff_t;
+        using reference = value_type;
+        using pointer = void;
+
+        const_iterator() = default;
+
+        value_type operator*() const noexcept {
+            return vector_->Get(index_);
+        }
+
+        value_type operator[](difference_type offset) const noexcept {
+            return *(*this + offset);
+        }
+
+        const_iterator& operator++() noexcept {
+            ++index_;
+            return *this;
+        }
+
+        const_iterator operator++(int) noexcept {
+            const_iterator prev = *this;
+            ++index_;
+            return prev;
+        }
+
+        const_iterator& operator--() noexcept {
+            --index_;
+            return *this;
+        }
+
+        const_iterator operator--(int) noexcept {
+            const_iterator prev = *this;
+            --index_;
+            return prev;
+        }
+
+        const_iterator& operator+=(difference_type offset) noexcept {
+            index_ += offset;
+            return *this;
+        }
+
+        const_iterator& operator-=(difference_type offset) noexcept {
+            index_ -= offset;
+            return *this;
+        }
+
+        friend const_iterator operator+(const_iterator it, difference_type offset) noexcept {
+            return it += offset;
+        }
+
+        friend const_iterator operator+(difference_type offset, const_iterator it) noexcept {
+            return it += offset;
+        }
+
+        friend const_iterator operator-(const_iterator it, difference_type offset) noexcept {
+            return it -= offset;
+        }
+
+        friend difference_type operator-(const const_iterator& lhs, const const_iterator& rhs) noexcept {
+            return lhs.index_ - rhs.index_;
+        }
+
+        friend bool operator==(const const_iterator& lhs, const const_iterator& rhs) noexcept {
+            return lhs.index_ == rhs.index_;
+        }
+
+        friend std::strong_ordering operator<=>(const const_iterator& lhs, const const_iterator& rhs) noexcept {
+            return lhs.index_ <=> rhs.index_;
+        }
+
+    private:
+        friend class PackedVector;
+
+        const_iterator(const PackedVector* vector, difference_type index) noexcept
+            : vector_(vector)
+            , index_(index) {
+        }
+
+        const PackedVector* vector_ = nullptr;
+        difference_type index_ = 0;
+    };
+
+    using iterator = const_iterator;
+
+    PackedVector() = default;
+
+    explicit PackedVector(const Allocator& alloc) noexcept
+        : words_(alloc) {
+    }
+
+    explicit PackedVector(size_t size, value_type value = 0, const Allocator& alloc = Allocator())
+        : words_(detail::WordCount(size * Bits), alloc)
+        , size_(size) {
+        if (value != 0) {
+            for (size_t i = 0; i < size_; ++i) {
+                Set(i, value);
+            }
+        }
+    }
+
+    PackedVector(std::initializer_list<value_type> values, const Allocator& alloc = Allocator())
+        : PackedVector(values.begin(), values.end(), alloc) {
+    }
+
+    template <std::input_iterator Iter>
+    explicit PackedVector(Iter first, Iter last, const Allocator& alloc = Allocator())
+        : words_(alloc) {
+        if constexpr (detail::MultiPassIterator<Iter>) {
+            Reserve(std::distance(first, last));
+        }
+        for (; first != last; ++first) {
+            PushBack(static_cast<value_type>(*first));
+        }
+    }
+
+    allocator_type GetAllocator() const noexcept {
+        return words_.GetAllocator();
+    }
+
+    const_iterator begin() const noexcept {
+        return const_iterator(this, 0);
+    }
+
+    const_iterator end() const noexcept {
+        return const_iterator(this, static_cast<std::ptrdiff_t>(size_));
+    }
+
+    const_iterator cbegin() const noexcept {
+        return begin();
+    }
+
+    const_iterator cend() const noexcept {
+        return end();
+    }
+
+    size_t Size() const noexcept {
+        return size_;
+    }
+
+    size_t Capacity() const noexcept {
+        return words_.Capacity() * detail::BITS_PER_WORD / Bits;
+    }
+
+    void Reserve(size_t new_capacity) {
+        words_.Reserve(detail::WordCount(new_capacity * Bits));
+    }
+
+    // Новые элементы получают значение value
+    void Resize(size_t new_size, value_type value = 0) {
+        words_.Resize(detail::WordCount(new_size * Bits));
+        const size_t old_size = std::exchange(size_, new_size);
+        if (new_size < old_size) {
+            detail::ClearTailBits(words_.Data(), size_ * Bits);
+        } else if (value != 0) {
+            for (size_t i = old_size; i < new_size; ++i) {
+                Set(i, value);
+            }
+        }
+    }
+
+    void ShrinkToFit() {
+        words_.ShrinkToFit();
+    }
+
+    void Clear() noexcept {
+        words_.Clear();
+        size_ = 0;
+    }
+
+    value_type Get(size_t index) const noexcept {
+        ADVANCED_VECTOR_CHECK_BOUNDS(index < size_);
+        const Word* words = words_.Data();
+        const size_t offset = index * Bits;
+        const size_t i = offset / detail::BITS_PER_WORD;
+        const size_t shift = offset % detail::BITS_PER_WORD;
+        Word value = words[i] >> shift;
+        if constexpr (!ALIGNED) {
+            if (shift + Bits > detail::BITS_PER_WORD) {
+                value |= words[i + 1] << (detail::BITS_PER_WORD - shift);
+            }
+        }
+        return static_cast<value_type>(value & MAX_VALUE);
+    }
+
+    // Значение должно помещаться в Bits бит: старшие биты не отбрасываются молча, а считаются ошибкой границ.
+    // Без проверок они всё же отсекаются маской, чтобы не испортить соседние элементы
+    void Set(size_t index, value_type value) noexcept {
+        ADVANCED_VECTOR_CHECK_BOUNDS(index < size_);
+        ADVANCED_VECTOR_CHECK_BOUNDS(Word{value} <= MAX_VALUE);
+        Word* words = words_.Data();
+        const Word bits = Word{value} & MAX_VALUE;
+        const size_t offset = index * Bits;
+        const size_t i = offset / detail::BITS_PER_WORD;
+        const size_t shift = offset % detail::BITS_PER_WORD;
+        words[i] = (words[i] & ~(MAX_VALUE << shift)) | (bits << shift);
+        if constexpr (!ALIGNED) {
+            if (shift + Bits > detail::BITS_PER_WORD) {
+                const size_t spill = detail::BITS_PER_WORD - shift;
+                words[i + 1] = (words[i + 1] & ~(MAX_VALUE >> spill)) | (bits >> spill);
+            }
+        }
+    }
+
+    value_type operator[](size_t index) const noexcept {
+        return Get(index);
+    }
+
+    Reference operator[](size_t index) noexcept {
+        ADVANCED_VECTOR_CHECK_BOUNDS(index < size_);
+        return Reference(this, index);
+    }
+
+    // Доступ с проверкой индекса при любом уровне проверок
+    value_type At(size_t index) const {
+        if (index >= size_) [[unlikely]] {
+            throw std::out_of_range("PackedVector index out of range");
+        }
+        return Get(index);
+    }
+
+    value_type Front() const noexcept {
+        return Get(0);
+    }
+
+    value_type Back() const noexcept {
+        ADVANCED_VECTOR_CHECK_BOUNDS(size_ != 0);
+        return Get(size_ - 1);
+    }
+
+    void PushBack(value_type value) {
+        if (const size_t words = detail::WordCount((size_ + 1) * Bits); words > words_.Size()) {
+            words_.PushBack(Word{0});
+        }
+        Set(size_++, value);
+    }
+
+    void PopBack() noexcept {
+        ADVANCED_VECTOR_CHECK_BOUNDS(size_ != 0);
+        Set(size_ - 1, 0);
+        --size_;
+        if (detail::WordCount(size_ * Bits) < words_.Size()) {
+            words_.PopBack();
+        }
+    }
+
+    // Вызывает f(value) для элементов по порядку, сдвигаясь по словам без деления и умножения на индекс
+    template <typename F>
+    void ForEach(F f) const {
+        const Word* words = words_.Data();
+        size_t i = 0;
+        size_t shift = 0;
+        for (size_t n = 0; n < size_; ++n) {
+            Word value = words[i] >> shift;
+            if constexpr (!ALIGNED) {
+                if (shift + Bits > detail::BITS_PER_WORD) {
+                    value |= words[i + 1] << (detail::BITS_PER_WORD - shift);
+                }
+            }
+            f(static_cast<value_type>(value & MAX_VALUE));
+            shift += Bits;
+            if (shift >= detail::BITS_PER_WORD) {
+                shift -= detail::BITS_PER_WORD;
+                ++i;
+            }
+        }
+    }
+
+    // Упакованные слова: элемент i занимает биты [i * Bits, (i + 1) * Bits) начиная с младшего бита слова 0
+    std::span<const Word> Words() const noexcept {
+        return {words_.Data(), words_.Size()};
+    }
+
+    void Swap(PackedVector& other) noexcept {
+        words_.Swap(other.words_);
+        std::swap(size_, other.size_);
+    }
+
+    friend bool operator==(const PackedVector& lhs, const PackedVector& rhs) noexcept {
+        return lhs.size_ == rhs.size_ && std::ranges::equal(lhs.Words(), rhs.Words());
+    }
+
+private:
+    Vector<Word, Allocator> words_;
+    size_t size_ = 0;
+};
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstdio>
+#include <cstdlib>
+
+// Уровень проверок контейнеров задаётся при сборке: -DADVANCED_VECTOR_CHECK_LEVEL=<уровень>
+//   0 (ADVANCED_VECTOR_CHECK_NONE)  - проверок нет вовсе, условия даже не вычисляются;
+//   1 (ADVANCED_VECTOR_CHECK_CHEAP) - только проверки границ (индексы, итераторы, PopBack пустого вектора),
+//                                     которые при нарушении сразу останавливают процесс инструкцией trap,
+//                                     без сообщений и без зависимости от NDEBUG. Режим для hardened-сборок;
+//   2 (ADVANCED_VECTOR_CHECK_FULL)  - отладочный: проверки границ и внутренних инвариантов (равенство
+//                                     аллокаторов при обмене, корректность принятых буферов) с сообщением
+//                                     о месте нарушения.
+// По умолчанию уровень следует за assert: 2 в отладочной сборке и 0 с NDEBUG
+#define ADVANCED_VECTOR_CHECK_NONE 0
+#define ADVANCED_VECTOR_CHECK_CHEAP 1
+#define ADVANCED_VECTOR_CHECK_FULL 2
+
+#ifndef ADVANCED_VECTOR_CHECK_LEVEL
+#ifdef NDEBUG
+#define ADVANCED_VECTOR_CHECK_LEVEL ADVANCED_VECTOR_CHECK_NONE
+#else
+#define ADVANCED_VECTOR_CHECK_LEVEL ADVANCED_VECTOR_CHECK_FULL
+#endif
+#endif
+
+// Отладочные итераторы Vector (-DADVANCED_VECTOR_DEBUG_ITERATORS=1): вместо T* итератор хранит номер поколения
+// буфера и при разыменовании, сравнении и передаче в Emplace/Insert/Erase проверяет, что буфер с тех пор
+// не освобождён и не заменён (реаллокация, ShrinkToFit, Adopt/Release, разрушение вектора). При перемещении
+// и Swap поколение переезжает вместе с буфером, и итераторы, как и у std::vector, остаются действительными.
+// Меняет размер RawMemory и тип итераторов, поэтому включается для всей программы сразу. Нарушение сообщается
+// так же, как проверки этого файла, на любом уровне
+#ifndef ADVANCED_VECTOR_DEBUG_ITERATORS
+#define ADVANCED_VECTOR_DEBUG_ITERATORS 0
+#endif
+
+namespace detail {
+
+// Вынесено из горячего кода: в месте проверки остаются лишь сравнение и редкий переход
+[[noreturn, gnu::cold, gnu::noinline]] inline void CheckFailed([[maybe_unused]] const char* condition,
+                                                              [[maybe_unused]] const char* file,
+                                                              [[maybe_unused]] int line) noexcept {
+#if ADVANCED_VECTOR_CHECK_LEVEL >= ADVANCED_VECTOR_CHECK_FULL
+    std::fprintf(stderr, "%s:%d: check failed: %s\n", file, line, condition);
+    std::abort();
+#else
+    __builtin_trap();
+#endif
+}
+
+}  // namespace detail
+
+#define ADVANCED_VECTOR_CHECK_IMPL(condition)                                  \
+    do {                                                                       \
+        if (!(condition)) [[unlikely]] {                                       \
+            ::detail::CheckFailed(#condition, __FILE__, __LINE__);             \
+        }                                                                      \
+    } while (false)
+
+// Проверка границ: включена на уровнях CHEAP и FULL
+#if ADVANCED_VECTOR_CHECK_LEVEL >= ADVANCED_VECTOR_CHECK_CHEAP
+#define ADVANCED_VECTOR_CHECK_BOUNDS(condition) ADVANCED_VECTOR_CHECK_IMPL(condition)
+#else
+#define ADVANCED_VECTOR_CHECK_BOUNDS(condition) static_cast<void>(0)
+#endif
+
+// Проверка инварианта, слишком дорогая или слишком редкая для hardened-сборки: только на уровне FULL
+#if ADVANCED_VECTOR_CHECK_LEVEL >= ADVANCED_VECTOR_CHECK_FULL
+#define ADVANCED_VECTOR_CHECK_DEBUG(condition) ADVANCED_VECTOR_CHECK_IMPL(condition)
+#else
+#define ADVANCED_VECTOR_CHECK_DEBUG(condition) static_cast<void>(0)
+#endif
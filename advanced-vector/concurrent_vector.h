@@ -0,0 +1,195 @@
+#pragma once
+
+#include "vector.h"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <utility>
+
+// Вектор, в который много потоков одновременно добавляют элементы без блокировок.
+// Элементы лежат в сегментах RawMemory, каждый следующий вдвое больше предыдущего (FIRST_SEGMENT, 2 * FIRST_SEGMENT, ...),
+// и сегменты никогда не переезжают: ссылки на элементы действительны до Clear, Freeze или разрушения вектора.
+// EmplaceBack резервирует индекс одним fetch_add и создаёт элемент в своей ячейке, поэтому не ждёт других потоков;
+// только поток, первым дошедший до нового сегмента, выделяет под него память.
+// Size() считает зарезервированные ячейки, в том числе ещё не созданные элементы, поэтому читатель
+// сначала проверяет IsReady(index). Clear, Freeze и деструктор нельзя вызывать одновременно с другими методами
+template <typename T, typename Allocator = std::allocator<T>>
+class ConcurrentVector {
+    static constexpr size_t WORD_BITS = 64;
+
+public:
+    using allocator_type = Allocator;
+
+    static constexpr size_t FIRST_SEGMENT = 64;
+    static constexpr size_t MAX_SEGMENTS = std::numeric_limits<size_t>::digits - std::countr_zero(FIRST_SEGMENT);
+
+    static_assert(std::has_single_bit(FIRST_SEGMENT) && FIRST_SEGMENT % WORD_BITS == 0);
+
+    ConcurrentVector() = default;
+
+    explicit ConcurrentVector(const Allocator& alloc) noexcept
+        : alloc_(alloc) {
+    }
+
+    ConcurrentVector(const ConcurrentVector&) = delete;
+    ConcurrentVector& operator=(const ConcurrentVector&) = delete;
+
+    ~ConcurrentVector() {
+        Clear();
+        for (std::atomic<Segment*>& segment : segments_) {
+            delete segment.load(std::memory_order_relaxed);
+        }
+    }
+
+    // Добавляет элемент и возвращает ссылку на него. Если конструктор бросил исключение, ячейка остаётся пустой
+    // (IsReady для неё ложно), а исключение пробрасывается
+    template <typename... Args>
+    T& EmplaceBack(Args&&... args) {
+        const size_t index = size_.fetch_add(1, std::memory_order_relaxed);
+        const auto [segment_index, offset] = Locate(index);
+
+        Segment* segment = segments_[segment_index].load(std::memory_order_acquire);
+        if (segment == nullptr) {
+            segment = InstallSegment(segment_index);
+        }
+
+        T& elem = *std::construct_at(segment->elements + offset, std::forward<Args>(args)...);
+        segment->ready[offset / WORD_BITS].fetch_or(uint64_t{1} << offset % WORD_BITS, std::memory_order_release);
+        return elem;
+    }
+
+    T& PushBack(const T& value) {
+        return EmplaceBack(value);
+    }
+
+    T& PushBack(T&& value) {
+        return EmplaceBack(std::move(value));
+    }
+
+    // Число зарезервированных ячеек: элементы в них могут быть ещё не созданы
+    size_t Size() const noexcept {
+        return size_.load(std::memory_order_acquire);
+    }
+
+    // Элемент index создан и виден вызывающему потоку
+    bool IsReady(size_t index) const noexcept {
+        if (index >= Size()) {
+            return false;
+        }
+        const auto [segment_index, offset] = Locate(index);
+        const Segment* segment = segments_[segment_index].load(std::memory_order_acquire);
+        return segment != nullptr && IsReady(*segment, offset);
+    }
+
+    T& operator[](size_t index) noexcept {
+        ADVANCED_VECTOR_CHECK_BOUNDS(index < Size());
+        ADVANCED_VECTOR_CHECK_DEBUG(IsReady(index));
+        const auto [segment_index, offset] = Locate(index);
+        return segments_[segment_index].load(std::memory_order_acquire)->elements[offset];
+    }
+
+    const T& operator[](size_t index) const noexcept {
+        return const_cast<ConcurrentVector&>(*this)[index];
+    }
+
+    // Разрушает элементы; память сегментов остаётся для следующих вставок
+    void Clear() noexcept {
+        ForEachReady([](T& elem) {
+            std::destroy_at(&elem);
+        });
+        for (std::atomic<Segment*>& slot : segments_) {
+            if (Segment* segment = slot.load(std::memory_order_relaxed)) {
+                for (size_t word = 0; word < segment->Words(); ++word) {
+                    segment->ready[word].store(0, std::memory_order_relaxed);
+                }
+            }
+        }
+        size_.store(0, std::memory_order_relaxed);
+    }
+
+    // Переносит созданные элементы по порядку индексов в непрерывный Vector и очищает себя.
+    // При исключении (если элементы пришлось копировать) ConcurrentVector не меняется
+    Vector<T, Allocator> Freeze() {
+        Vector<T, Allocator> result(alloc_);
+        result.Reserve(Size());
+        ForEachReady([&result](T& elem) {
+            result.EmplaceBack(std::move_if_noexcept(elem));
+        });
+        Clear();
+        return result;
+    }
+
+private:
+    struct Segment {
+        Segment(size_t capacity, const Allocator& alloc)
+            : memory(capacity, alloc)
+            , elements(memory.GetAddress())
+            , ready(std::make_unique<std::atomic<uint64_t>[]>(capacity / WORD_BITS)) {
+        }
+
+        size_t Words() const noexcept {
+            return memory.Capacity() / WORD_BITS;
+        }
+
+        RawMemory<T, Allocator> memory;
+        T* elements;
+        std::unique_ptr<std::atomic<uint64_t>[]> ready; // по биту на ячейку: элемент создан
+    };
+
+    struct Location {
+        size_t segment;
+        size_t offset;
+    };
+
+    [[no_unique_address]] Allocator alloc_ = Allocator();
+    std::atomic<size_t> size_ = 0;
+    std::atomic<Segment*> segments_[MAX_SEGMENTS] = {};
+
+    // Сегмент k начинается с индекса FIRST_SEGMENT * (2^k - 1) и вмещает FIRST_SEGMENT * 2^k элементов
+    static Location Locate(size_t index) noexcept {
+        const size_t shifted = index + FIRST_SEGMENT;
+        const size_t high_bit = std::bit_width(shifted) - 1;
+        return {high_bit - std::countr_zero(FIRST_SEGMENT), shifted - (size_t{1} << high_bit)};
+    }
+
+    static bool IsReady(const Segment& segment, size_t offset) noexcept {
+        return segment.ready[offset / WORD_BITS].load(std::memory_order_acquire) & uint64_t{1} << offset % WORD_BITS;
+    }
+
+    // Выделяет сегмент и публикует его, если другой поток не успел раньше
+    Segment* InstallSegment(size_t segment_index) {
+        auto segment = std::make_unique<Segment>(FIRST_SEGMENT << segment_index, alloc_);
+        Segment* expected = nullptr;
+        if (segments_[segment_index].compare_exchange_strong(expected, segment.get(), std::memory_order_acq_rel,
+                                                             std::memory_order_acquire)) {
+            return segment.release();
+        }
+        return expected;
+    }
+
+    template <typename Operation>
+    void ForEachReady(Operation operation) {
+        const size_t size = size_.load(std::memory_order_acquire);
+        for (size_t segment_index = 0; segment_index < MAX_SEGMENTS; ++segment_index) {
+            const size_t first = FIRST_SEGMENT * ((size_t{1} << segment_index) - 1);
+            if (first >= size) {
+                break;
+            }
+            Segment* segment = segments_[segment_index].load(std::memory_order_acquire);
+            if (segment == nullptr) {
+                continue;
+            }
+            const size_t count = std::min(size - first, FIRST_SEGMENT << segment_index);
+            for (size_t offset = 0; offset < count; ++offset) {
+                if (IsReady(*segment, offset)) {
+                    operation(segment->elements[offset]);
+                }
+            }
+        }
+    }
+};
@@ -0,0 +1,282 @@
+#pragma once
+
+#include "vector.h"
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <initializer_list>
+#include <memory>
+#include <utility>
+
+// Вектор с копированием при записи: копии делят один буфер со счётчиком ссылок, поэтому копирование (снимок)
+// стоит O(1) - одно атомарное увеличение счётчика. Буфер дублируется при первом изменении вектора, который делит
+// его с другими: EmplaceBack, Erase, неконстантные operator[], begin() и т.д. Счётчик атомарный, так что копии
+// одного буфера можно читать, менять и разрушать в разных потоках, как копии std::shared_ptr; один и тот же
+// объект CowVector, как и Vector, одновременно из нескольких потоков менять нельзя.
+// Неконстантные методы доступа отделяют буфер даже для чтения, поэтому читать разделяемый вектор лучше через
+// const-ссылку, cbegin()/cend() или View():
+//     CowVector<Setting> settings = LoadSettings();
+//     CowVector<Setting> snapshot = settings; // без копирования элементов
+//     settings[0].value = 42;                 // здесь settings получает собственный буфер
+// Изменяемая ссылка или итератор (Mutable, неконстантные operator[], begin(), Front() и т.д.) остаются записываемыми
+// и после копирования вектора, поэтому выдавший их буфер помечается неразделяемым: следующие копии получают
+// собственные буферы, чтобы запись через старую ссылку не изменила их. Пометку снимают Clear() и MarkShareable()
+template <typename T, typename Allocator = std::allocator<T>>
+class CowVector {
+public:
+    using value_type = T;
+    using allocator_type = Allocator;
+    using VectorType = Vector<T, Allocator>;
+    using iterator = typename VectorType::iterator;
+    using const_iterator = typename VectorType::const_iterator;
+
+    CowVector() = default;
+
+    explicit CowVector(size_t size)
+        : CowVector(VectorType(size)) {
+    }
+
+    CowVector(std::initializer_list<T> items)
+        : CowVector(VectorType(items)) {
+    }
+
+    // Забирает буфер обычного вектора без копирования элементов
+    explicit CowVector(VectorType&& data)
+        : shared_(new Shared{.refs{1}, .data = std::move(data)}) {
+    }
+
+    // Буфер, выдавший изменяемые ссылки, копируется сразу
+    CowVector(const CowVector& other) {
+        if (other.shared_ == nullptr) {
+            return;
+        }
+        if (other.shared_->unshareable) {
+            shared_ = Copy(other.shared_->data);
+        } else {
+            shared_ = other.shared_;
+            shared_->refs.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    CowVector(CowVector&& other) noexcept
+        : shared_(std::exchange(other.shared_, nullptr)) {
+    }
+
+    ~CowVector() {
+        Unref();
+    }
+
+    CowVector& operator=(const CowVector& rhs) {
+        if (shared_ != rhs.shared_) {
+            CowVector tmp(rhs);
+            Swap(tmp);
+        }
+        return *this;
+    }
+
+    CowVector& operator=(CowVector&& rhs) noexcept {
+        if (this != &rhs) {
+            Unref();
+            shared_ = std::exchange(rhs.shared_, nullptr);
+        }
+        return *this;
+    }
+
+    // Содержимое только для чтения, без отделения буфера
+    const VectorType& View() const noexcept {
+        return shared_ == nullptr ? EmptyVector() : shared_->data;
+    }
+
+    // Вектор, которым этот объект владеет единолично (при необходимости буфер копируется).
+    // После этого буфер не разделяется с копиями, пока не будет вызван MarkShareable() или Clear()
+    VectorType& Mutable() {
+        VectorType& data = Own();
+        shared_->unshareable = true;
+        return data;
+    }
+
+    // Обещание, что изменяемых ссылок и итераторов, полученных от этого вектора, больше не используют:
+    // следующие копии снова будут делить буфер
+    void MarkShareable() noexcept {
+        if (shared_ != nullptr) {
+            shared_->unshareable = false;
+        }
+    }
+
+    const_iterator begin() const noexcept {
+        return View().begin();
+    }
+
+    const_iterator end() const noexcept {
+        return View().end();
+    }
+
+    const_iterator cbegin() const noexcept {
+        return begin();
+    }
+
+    const_iterator cend() const noexcept {
+        return end();
+    }
+
+    iterator begin() {
+        return Mutable().begin();
+    }
+
+    iterator end() {
+        return Mutable().end();
+    }
+
+    const T& operator[](size_t index) const noexcept {
+        return View()[index];
+    }
+
+    T& operator[](size_t index) {
+        return Mutable()[index];
+    }
+
+    const T& Front() const noexcept {
+        return View().Front();
+    }
+
+    T& Front() {
+        return Mutable().Front();
+    }
+
+    const T& Back() const noexcept {
+        return View().Back();
+    }
+
+    T& Back() {
+        return Mutable().Back();
+    }
+
+    size_t Size() const noexcept {
+        return View().Size();
+    }
+
+    size_t Capacity() const noexcept {
+        return View().Capacity();
+    }
+
+    // Буфер делят несколько копий, и следующее изменение его скопирует
+    bool IsShared() const noexcept {
+        return shared_ != nullptr && shared_->refs.load(std::memory_order_acquire) != 1;
+    }
+
+    void Reserve(size_t new_capacity) {
+        Own().Reserve(new_capacity);
+    }
+
+    void Resize(size_t new_size) {
+        Own().Resize(new_size);
+    }
+
+    template <typename... Args>
+    T& EmplaceBack(Args&&... args) {
+        return Mutable().EmplaceBack(std::forward<Args>(args)...);
+    }
+
+    void PushBack(const T& value) {
+        Own().EmplaceBack(value);
+    }
+
+    void PushBack(T&& value) {
+        Own().EmplaceBack(std::move(value));
+    }
+
+    void PopBack() {
+        Own().PopBack();
+    }
+
+    // Итераторы могут указывать в разделяемый буфер, поэтому после отделения позиция пересчитывается по индексу
+    template <typename... Args>
+    iterator Emplace(const_iterator it, Args&&... args) {
+        const size_t index = it - cbegin();
+        VectorType& data = Mutable();
+        return data.Emplace(data.begin() + index, std::forward<Args>(args)...);
+    }
+
+    iterator Insert(const_iterator it, const T& value) {
+        return Emplace(it, value);
+    }
+
+    iterator Insert(const_iterator it, T&& value) {
+        return Emplace(it, std::move(value));
+    }
+
+    iterator Erase(const_iterator it) {
+        const size_t index = it - cbegin();
+        VectorType& data = Mutable();
+        return data.Erase(data.begin() + index);
+    }
+
+    iterator Erase(const_iterator first, const_iterator last) {
+        const size_t from = first - cbegin();
+        const size_t to = last - cbegin();
+        VectorType& data = Mutable();
+        return data.Erase(data.begin() + from, data.begin() + to);
+    }
+
+    // Чужой буфер не копируется, а просто отпускается
+    void Clear() noexcept {
+        if (IsShared()) {
+            Unref();
+            shared_ = nullptr;
+        } else if (shared_ != nullptr) {
+            shared_->data.Clear();
+            shared_->unshareable = false;
+        }
+    }
+
+    void Swap(CowVector& rhs) noexcept {
+        std::swap(shared_, rhs.shared_);
+    }
+
+private:
+    struct Shared {
+        std::atomic<size_t> refs;
+        VectorType data;
+        // Меняется только единственным владельцем буфера, поэтому атомарность не нужна
+        bool unshareable = false;
+    };
+
+    Shared* shared_ = nullptr;
+
+    static const VectorType& EmptyVector() noexcept {
+        static const VectorType empty;
+        return empty;
+    }
+
+    // Копия получает ту же ёмкость, что и оригинал, чтобы следующий EmplaceBack не реаллоцировал её сразу же
+    static Shared* Copy(const VectorType& data) {
+        auto copy = std::make_unique<Shared>(1, VectorType(data.GetAllocator()));
+        copy->data.Reserve(data.Capacity());
+        copy->data.Append(data.begin(), data.end());
+        return copy.release();
+    }
+
+    // Acquire при проверке счётчика видит все изменения, сделанные другими копиями до их разрушения
+    void Detach() {
+        if (shared_ == nullptr) {
+            shared_ = new Shared{.refs{1}, .data = VectorType()};
+        } else if (shared_->refs.load(std::memory_order_acquire) != 1) {
+            Shared* copy = Copy(shared_->data);
+            Unref();
+            shared_ = copy;
+        }
+    }
+
+    // Как Mutable(), но без выдачи ссылок наружу, поэтому буфер остаётся разделяемым
+    VectorType& Own() {
+        Detach();
+        return shared_->data;
+    }
+
+    void Unref() noexcept {
+        if (shared_ != nullptr && shared_->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            delete shared_;
+        }
+    }
+};
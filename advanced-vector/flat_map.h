@@ -0,0 +1,461 @@
+#pragma once
+
+#include "vector.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <functional>
+#include <initializer_list>
+#include <ranges>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+// Упорядоченные множество и словарь поверх отсортированного Vector: поиск - lower_bound по непрерывному массиву
+// ключей, без узлов и указателей. Вставка и удаление по одному ключу сдвигают хвост (O(n)), поэтому много ключей
+// сразу лучше добавлять через InsertSorted: новые ключи сортируются отдельно и сливаются с существующими за один проход.
+// Для редко меняющихся данных BuildSearchIndex строит копию ключей в порядке Эйтцингера (in-order обход неявного
+// двоичного дерева), в которой путь двоичного поиска идёт по соседним уровням и хорошо предсказывается и
+// подкачивается; индекс сбрасывается первым же изменением набора ключей
+
+namespace detail {
+
+// Ключи в порядке Эйтцингера (узлы нумеруются с 1, потомки узла k - 2k и 2k + 1; узел k хранится в layout_[k - 1])
+// и позиции этих ключей в отсортированном массиве
+template <typename K, typename Compare>
+class EytzingerIndex {
+public:
+    bool IsBuilt() const noexcept {
+        return ranks_.Size() != 0;
+    }
+
+    void Build(std::span<const K> keys) {
+        // ranks[0] - ответ для ключа больше всех
+        Vector<size_t> ranks(keys.size() + 1);
+        ranks[0] = keys.size();
+        size_t next = 0;
+        FillRanks(ranks, next, 1);
+
+        Vector<K> layout;
+        layout.Reserve(keys.size());
+        for (size_t k = 1; k <= keys.size(); ++k) {
+            layout.EmplaceBack(keys[ranks[k]]);
+        }
+        layout_.Swap(layout);
+        ranks_.Swap(ranks);
+    }
+
+    void Clear() noexcept {
+        layout_.ReleaseMemory();
+        ranks_.ReleaseMemory();
+    }
+
+    // Позиция первого ключа, не меньшего key, в отсортированном массиве (или число ключей)
+    size_t LowerBound(const K& key, const Compare& comp) const {
+        const size_t n = layout_.Size();
+        size_t k = 1;
+        while (k <= n) {
+#if defined(__GNUC__)
+            // Через 4 уровня потомки узла занимают 16 соседних ячеек
+            __builtin_prefetch(layout_.Data() + std::min(16 * k, n) - 1);
+#endif
+            k = 2 * k + static_cast<size_t>(comp(layout_[k - 1], key));
+        }
+        // Узел, где поиск последний раз повернул налево; после спуска - нулевой, если таких поворотов не было
+        k >>= std::countr_one(k) + 1;
+        return ranks_[k];
+    }
+
+private:
+    Vector<K> layout_;
+    Vector<size_t> ranks_;
+
+    // In-order обход неявного дерева выдаёт узлы в порядке возрастания ключей
+    static void FillRanks(Vector<size_t>& ranks, size_t& next, size_t k) noexcept {
+        if (k < ranks.Size()) {
+            FillRanks(ranks, next, 2 * k);
+            ranks[k] = next++;
+            FillRanks(ranks, next, 2 * k + 1);
+        }
+    }
+};
+
+// Общая часть FlatSet и FlatMap: отсортированные уникальные ключи и поиск по ним
+template <typename K, typename Compare>
+class SortedKeys {
+public:
+    explicit SortedKeys(const Compare& comp = Compare())
+        : comp_(comp) {
+    }
+
+    std::span<const K> Keys() const noexcept {
+        return {keys_.Data(), keys_.Size()};
+    }
+
+    size_t Size() const noexcept {
+        return keys_.Size();
+    }
+
+    // Строит индекс Эйтцингера для текущих ключей: дополнительная память - по ключу и size_t на элемент
+    void BuildSearchIndex() {
+        index_.Build(Keys());
+    }
+
+    bool HasSearchIndex() const noexcept {
+        return index_.IsBuilt();
+    }
+
+protected:
+    [[no_unique_address]] Compare comp_;
+    Vector<K> keys_;
+    EytzingerIndex<K, Compare> index_;
+
+    size_t LowerBoundIndex(const K& key) const {
+        if (index_.IsBuilt()) {
+            return index_.LowerBound(key, comp_);
+        }
+        return std::lower_bound(keys_.begin(), keys_.end(), key, comp_) - keys_.begin();
+    }
+
+    // Позиция ключа или Size(), если его нет
+    size_t FindIndex(const K& key) const {
+        const size_t index = LowerBoundIndex(key);
+        return index < keys_.Size() && !comp_(key, keys_[index]) ? index : keys_.Size();
+    }
+
+    // При слиянии ключ добавляется, только если он строго больше последнего добавленного: так отбрасываются повторы
+    bool IsNewLast(const Vector<K>& keys, const K& key) const {
+        return keys.Size() == 0 || comp_(keys.Back(), key);
+    }
+};
+
+// Переносит элемент старого массива при слиянии; копирует, если перенос может бросить, чтобы старый массив
+// остался целым (строгая гарантия)
+template <bool Move, typename T>
+decltype(auto) TakeOld(T& value) noexcept {
+    if constexpr (Move) {
+        return std::move(value);
+    } else {
+        return static_cast<const T&>(value);
+    }
+}
+
+}  // namespace detail
+
+// Множество уникальных ключей в отсортированном Vector
+template <typename K, typename Compare = std::less<K>>
+class FlatSet : public detail::SortedKeys<K, Compare> {
+    using Base = detail::SortedKeys<K, Compare>;
+    using Base::comp_;
+    using Base::index_;
+    using Base::keys_;
+
+public:
+    using key_type = K;
+    using value_type = K;
+    using iterator = const K*;
+    using const_iterator = const K*;
+
+    FlatSet() = default;
+
+    explicit FlatSet(const Compare& comp)
+        : Base(comp) {
+    }
+
+    template <std::ranges::input_range Range>
+    explicit FlatSet(Range&& range, const Compare& comp = Compare())
+        : Base(comp) {
+        InsertSorted(std::forward<Range>(range));
+    }
+
+    FlatSet(std::initializer_list<K> keys, const Compare& comp = Compare())
+        : Base(comp) {
+        InsertSorted(keys);
+    }
+
+    const_iterator begin() const noexcept {
+        return keys_.Data();
+    }
+
+    const_iterator end() const noexcept {
+        return keys_.Data() + keys_.Size();
+    }
+
+    const_iterator LowerBound(const K& key) const {
+        return begin() + this->LowerBoundIndex(key);
+    }
+
+    const_iterator Find(const K& key) const {
+        return begin() + this->FindIndex(key);
+    }
+
+    bool Contains(const K& key) const {
+        return Find(key) != end();
+    }
+
+    // Возвращает позицию ключа и признак того, что его не было
+    template <typename Key>
+    std::pair<const_iterator, bool> Insert(Key&& key) {
+        const size_t index = this->LowerBoundIndex(key);
+        if (index < keys_.Size() && !comp_(key, keys_[index])) {
+            return {begin() + index, false};
+        }
+        index_.Clear();
+        keys_.Emplace(keys_.begin() + index, std::forward<Key>(key));
+        return {begin() + index, true};
+    }
+
+    // Добавляет ключи диапазона в любом порядке: они сортируются отдельно и сливаются с уже имеющимися за один проход,
+    // а повторы отбрасываются (остаётся первый ключ из равных). При исключении множество не меняется
+    template <std::ranges::input_range Range>
+    void InsertSorted(Range&& range) {
+        Vector<K> added;
+        added.AppendRange(std::forward<Range>(range));
+        std::stable_sort(added.begin(), added.end(), comp_);
+
+        constexpr bool MOVE = std::is_nothrow_move_constructible_v<K>;
+        Vector<K> merged;
+        merged.Reserve(keys_.Size() + added.Size());
+        const auto push = [this, &merged](auto&& key) {
+            if (this->IsNewLast(merged, key)) {
+                merged.EmplaceBack(std::forward<decltype(key)>(key));
+            }
+        };
+
+        size_t i = 0;
+        size_t j = 0;
+        while (i < keys_.Size() && j < added.Size()) {
+            if (comp_(added[j], keys_[i])) {
+                push(std::move(added[j++]));
+            } else {
+                push(detail::TakeOld<MOVE>(keys_[i++]));
+            }
+        }
+        for (; i < keys_.Size(); ++i) {
+            push(detail::TakeOld<MOVE>(keys_[i]));
+        }
+        for (; j < added.Size(); ++j) {
+            push(std::move(added[j]));
+        }
+
+        index_.Clear();
+        keys_.Swap(merged);
+    }
+
+    size_t Erase(const K& key) {
+        const const_iterator it = Find(key);
+        if (it == end()) {
+            return 0;
+        }
+        Erase(it);
+        return 1;
+    }
+
+    const_iterator Erase(const_iterator it) {
+        index_.Clear();
+        const size_t index = it - begin();
+        keys_.Erase(keys_.begin() + index);
+        return begin() + index;
+    }
+
+    void Reserve(size_t capacity) {
+        keys_.Reserve(capacity);
+    }
+
+    void Clear() noexcept {
+        index_.Clear();
+        keys_.Clear();
+    }
+};
+
+// Словарь с ключами и значениями в двух отдельных Vector: поиск читает только плотный массив ключей,
+// а значение находится по той же позиции
+template <typename K, typename V, typename Compare = std::less<K>>
+class FlatMap : public detail::SortedKeys<K, Compare> {
+    using Base = detail::SortedKeys<K, Compare>;
+    using Base::comp_;
+    using Base::index_;
+    using Base::keys_;
+
+public:
+    using key_type = K;
+    using mapped_type = V;
+
+    FlatMap() = default;
+
+    explicit FlatMap(const Compare& comp)
+        : Base(comp) {
+    }
+
+    FlatMap(std::initializer_list<std::pair<K, V>> items, const Compare& comp = Compare())
+        : Base(comp) {
+        InsertSorted(items);
+    }
+
+    // Значения в порядке ключей
+    std::span<V> Values() noexcept {
+        return {values_.Data(), values_.Size()};
+    }
+
+    std::span<const V> Values() const noexcept {
+        return {values_.Data(), values_.Size()};
+    }
+
+    const K& KeyAt(size_t index) const noexcept {
+        return keys_[index];
+    }
+
+    V& ValueAt(size_t index) noexcept {
+        return values_[index];
+    }
+
+    const V& ValueAt(size_t index) const noexcept {
+        return values_[index];
+    }
+
+    // Позиция первого ключа, не меньшего key
+    size_t LowerBound(const K& key) const {
+        return this->LowerBoundIndex(key);
+    }
+
+    // Значение по ключу или nullptr
+    V* Find(const K& key) {
+        const size_t index = this->FindIndex(key);
+        return index == keys_.Size() ? nullptr : &values_[index];
+    }
+
+    const V* Find(const K& key) const {
+        return const_cast<FlatMap&>(*this).Find(key);
+    }
+
+    bool Contains(const K& key) const {
+        return Find(key) != nullptr;
+    }
+
+    V& At(const K& key) {
+        V* value = Find(key);
+        if (value == nullptr) {
+            throw std::out_of_range("FlatMap has no such key");
+        }
+        return *value;
+    }
+
+    const V& At(const K& key) const {
+        return const_cast<FlatMap&>(*this).At(key);
+    }
+
+    V& operator[](const K& key) {
+        return *TryEmplace(key).first;
+    }
+
+    // Создаёт значение из args, только если ключа ещё нет. Возвращает значение по ключу и признак вставки
+    template <typename Key, typename... Args>
+    std::pair<V*, bool> TryEmplace(Key&& key, Args&&... args) {
+        const size_t index = this->LowerBoundIndex(key);
+        if (index < keys_.Size() && !comp_(key, keys_[index])) {
+            return {&values_[index], false};
+        }
+
+        values_.Emplace(values_.begin() + index, std::forward<Args>(args)...);
+        try {
+            keys_.Emplace(keys_.begin() + index, std::forward<Key>(key));
+        } catch (...) {
+            values_.Erase(values_.begin() + index);
+            throw;
+        }
+        index_.Clear();
+        return {&values_[index], true};
+    }
+
+    template <typename Key, typename Value>
+    std::pair<V*, bool> InsertOrAssign(Key&& key, Value&& value) {
+        auto [slot, inserted] = TryEmplace(std::forward<Key>(key), std::forward<Value>(value));
+        if (!inserted) {
+            *slot = std::forward<Value>(value);
+        }
+        return {slot, inserted};
+    }
+
+    // Добавляет пары (ключ, значение) диапазона в любом порядке за один проход слияния, как FlatSet::InsertSorted.
+    // Для равных ключей остаётся уже имеющееся значение или первое из диапазона. При исключении словарь не меняется
+    template <std::ranges::input_range Range>
+    void InsertSorted(Range&& range) {
+        Vector<std::pair<K, V>> added;
+        added.AppendRange(std::forward<Range>(range));
+        std::stable_sort(added.begin(), added.end(), [this](const auto& lhs, const auto& rhs) {
+            return comp_(lhs.first, rhs.first);
+        });
+
+        constexpr bool MOVE = std::is_nothrow_move_constructible_v<K> && std::is_nothrow_move_constructible_v<V>;
+        Vector<K> merged_keys;
+        Vector<V> merged_values;
+        merged_keys.Reserve(keys_.Size() + added.Size());
+        merged_values.Reserve(keys_.Size() + added.Size());
+        // Значение добавляется первым: если бросит ключ, лишнее значение убирается, и массивы остаются одной длины
+        const auto push = [this, &merged_keys, &merged_values](auto&& key, auto&& value) {
+            if (this->IsNewLast(merged_keys, key)) {
+                merged_values.EmplaceBack(std::forward<decltype(value)>(value));
+                try {
+                    merged_keys.EmplaceBack(std::forward<decltype(key)>(key));
+                } catch (...) {
+                    merged_values.PopBack();
+                    throw;
+                }
+            }
+        };
+
+        size_t i = 0;
+        size_t j = 0;
+        while (i < keys_.Size() && j < added.Size()) {
+            if (comp_(added[j].first, keys_[i])) {
+                push(std::move(added[j].first), std::move(added[j].second));
+                ++j;
+            } else {
+                push(detail::TakeOld<MOVE>(keys_[i]), detail::TakeOld<MOVE>(values_[i]));
+                ++i;
+            }
+        }
+        for (; i < keys_.Size(); ++i) {
+            push(detail::TakeOld<MOVE>(keys_[i]), detail::TakeOld<MOVE>(values_[i]));
+        }
+        for (; j < added.Size(); ++j) {
+            push(std::move(added[j].first), std::move(added[j].second));
+        }
+
+        index_.Clear();
+        keys_.Swap(merged_keys);
+        values_.Swap(merged_values);
+    }
+
+    size_t Erase(const K& key) {
+        const size_t index = this->FindIndex(key);
+        if (index == keys_.Size()) {
+            return 0;
+        }
+        EraseAt(index);
+        return 1;
+    }
+
+    void EraseAt(size_t index) {
+        ADVANCED_VECTOR_CHECK_BOUNDS(index < keys_.Size());
+        index_.Clear();
+        keys_.Erase(keys_.begin() + index);
+        values_.Erase(values_.begin() + index);
+    }
+
+    void Reserve(size_t capacity) {
+        keys_.Reserve(capacity);
+        values_.Reserve(capacity);
+    }
+
+    void Clear() noexcept {
+        index_.Clear();
+        keys_.Clear();
+        values_.Clear();
+    }
+
+private:
+    Vector<V> values_;
+};
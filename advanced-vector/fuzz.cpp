@@ -0,0 +1,657 @@
+// Случайное дифференциальное тестирование контейнеров с внедрением исключений.
+// Одна и та же последовательность операций выполняется над проверяемым контейнером и над std::vector<int>,
+// который служит моделью. Каждое создание, копирование, присваивание элемента и каждое выделение памяти - точка,
+// в которой может быть брошено исключение. После неудачной операции проверяется обещанная гарантия:
+// строгая (содержимое не изменилось) или базовая (все элементы живы и учтены), а после каждой операции -
+// совпадение с моделью, отсутствие мёртвых и лишних объектов и утечек памяти.
+//
+// Запуск: ./fuzz.exe [число случаев] [seed]. Сборка с -DADVANCED_VECTOR_LIBFUZZER даёт вместо main точку входа
+// LLVMFuzzerTestOneInput, и те же проверки выполняет libFuzzer (clang -fsanitize=fuzzer)
+
+#include "small_vector.h"
+#include "static_vector.h"
+#include "vector.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <iterator>
+#include <map>
+#include <new>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace {
+
+// Название проверяемого контейнера для сообщений об ошибках
+inline const char* current_container = "";
+
+[[noreturn]] void Fail(const char* what, const char* operation) {
+    std::fprintf(stderr, "fuzz: %s (%s, operation %s)\n", what, current_container, operation);
+    std::abort();
+}
+
+// Счётчик точек внедрения: Arm(n) заставляет n-ю по счёту точку бросить исключение
+class FaultInjector {
+public:
+    static void Arm(size_t countdown) noexcept {
+        countdown_ = countdown;
+    }
+
+    static void Disarm() noexcept {
+        countdown_ = 0;
+    }
+
+    // Возвращает true, если в этой точке надо бросить исключение
+    static bool Hit() noexcept {
+        ++points;
+        if (countdown_ != 0 && --countdown_ == 0) {
+            ++injected;
+            return true;
+        }
+        return false;
+    }
+
+    static inline size_t points = 0;
+    static inline size_t injected = 0;
+
+private:
+    static inline size_t countdown_ = 0;
+};
+
+struct InjectedFault : std::runtime_error {
+    InjectedFault()
+        : std::runtime_error("injected fault") {
+    }
+};
+
+inline const uint32_t ALIVE_COOKIE = 0xdeadbeef;
+
+// Сколько элементов сейчас живо во всех контейнерах и у самого теста
+inline long alive_elements = 0;
+
+// Элемент, который проверяет, что с ним работают только пока он жив (как A::IsAlive в main.cpp), и бросает
+// исключения в точках внедрения. Если NothrowMove == false, перемещение тоже может бросить, и контейнеры
+// вынуждены копировать при реаллокации. Relocatable отмечает тип как тривиально перемещаемый
+template <bool NothrowMove, bool Relocatable = false>
+struct Tracked {
+    Tracked() {
+        Inject();
+        Born(0);
+    }
+
+    Tracked(int value) {
+        Inject();
+        Born(value);
+    }
+
+    Tracked(const Tracked& other) {
+        other.Check("copy from a dead element");
+        Inject();
+        Born(other.value);
+    }
+
+    Tracked(Tracked&& other) noexcept(NothrowMove) {
+        other.Check("move from a dead element");
+        if constexpr (!NothrowMove) {
+            Inject();
+        }
+        Born(other.value);
+    }
+
+    Tracked& operator=(const Tracked& other) {
+        Check("assignment to a dead element");
+        other.Check("assignment from a dead element");
+        Inject();
+        value = other.value;
+        return *this;
+    }
+
+    Tracked& operator=(Tracked&& other) noexcept(NothrowMove) {
+        Check("move assignment to a dead element");
+        other.Check("move assignment from a dead element");
+        if constexpr (!NothrowMove) {
+            Inject();
+        }
+        value = other.value;
+        return *this;
+    }
+
+    ~Tracked() {
+        Check("double destruction");
+        cookie = 0;
+        --alive_elements;
+    }
+
+    void Check(const char* what) const {
+        if (cookie != ALIVE_COOKIE) {
+            Fail(what, "element access");
+        }
+    }
+
+    uint32_t cookie = 0;
+    int value = 0;
+
+private:
+    static void Inject() {
+        if (FaultInjector::Hit()) {
+            throw InjectedFault();
+        }
+    }
+
+    void Born(int new_value) noexcept {
+        value = new_value;
+        cookie = ALIVE_COOKIE;
+        ++alive_elements;
+    }
+};
+
+// Выделенные, но ещё не освобождённые блоки: адрес -> размер в байтах
+inline std::map<void*, size_t> live_blocks;
+
+// Аллокатор на malloc, который бросает std::bad_alloc в точках внедрения и проверяет, что каждый блок
+// освобождается ровно один раз и с тем же размером. Reallocating добавляет reallocate, как у MallocAllocator
+template <typename T, bool Reallocating = false>
+struct FaultyAllocator {
+    using value_type = T;
+
+    template <typename U>
+    struct rebind {
+        using other = FaultyAllocator<U, Reallocating>;
+    };
+
+    FaultyAllocator() = default;
+
+    template <typename U>
+    FaultyAllocator(const FaultyAllocator<U, Reallocating>& /*other*/) noexcept {
+    }
+
+    T* allocate(size_t n) {
+        if (FaultInjector::Hit()) {
+            throw std::bad_alloc();
+        }
+        void* buf = std::malloc(n * sizeof(T));
+        if (buf == nullptr) {
+            throw std::bad_alloc();
+        }
+        live_blocks.emplace(buf, n * sizeof(T));
+        return static_cast<T*>(buf);
+    }
+
+    void deallocate(T* buf, size_t n) noexcept {
+        Forget(buf, n);
+        std::free(buf);
+    }
+
+    T* reallocate(T* buf, size_t old_n, size_t new_n) requires Reallocating {
+        if (buf == nullptr) {
+            return allocate(new_n);
+        }
+        if (FaultInjector::Hit()) {
+            throw std::bad_alloc();
+        }
+        Forget(buf, old_n);
+        void* new_buf = std::realloc(static_cast<void*>(buf), new_n * sizeof(T));
+        if (new_buf == nullptr) {
+            live_blocks.emplace(buf, old_n * sizeof(T));
+            throw std::bad_alloc();
+        }
+        live_blocks.emplace(new_buf, new_n * sizeof(T));
+        return static_cast<T*>(new_buf);
+    }
+
+    template <typename U>
+    bool operator==(const FaultyAllocator<U, Reallocating>& /*other*/) const noexcept {
+        return true;
+    }
+
+private:
+    static void Forget(T* buf, size_t n) noexcept {
+        const auto it = live_blocks.find(buf);
+        if (it == live_blocks.end()) {
+            Fail("deallocation of an unknown block", "allocator");
+        }
+        if (it->second != n * sizeof(T)) {
+            Fail("deallocation with a wrong size", "allocator");
+        }
+        live_blocks.erase(it);
+    }
+};
+
+}  // namespace
+
+template <bool NothrowMove>
+struct IsTriviallyRelocatable<Tracked<NothrowMove, true>> : std::true_type {};
+
+namespace {
+
+// Входные байты; за концом читаются нули
+class Input {
+public:
+    Input(const uint8_t* data, size_t size) noexcept
+        : data_(data)
+        , size_(size) {
+    }
+
+    bool Empty() const noexcept {
+        return pos_ == size_;
+    }
+
+    uint8_t Next() noexcept {
+        return pos_ < size_ ? data_[pos_++] : 0;
+    }
+
+private:
+    const uint8_t* data_;
+    size_t size_;
+    size_t pos_ = 0;
+};
+
+// Что обещает операция при исключении
+enum class Guarantee {
+    NOTHROW, // исключений не бывает
+    STRONG,  // контейнер не изменился
+    BASIC,   // контейнер изменился, но все элементы живы и учтены
+};
+
+// Размер, до которого растут контейнеры: вставка за один шаг добавляет не больше MAX_BATCH элементов,
+// поэтому StaticVector ёмкости MAX_SIZE + MAX_BATCH никогда не переполняется
+inline constexpr size_t MAX_SIZE = 48;
+inline constexpr size_t MAX_BATCH = 8;
+
+// Выполняет операции из входа над двумя контейнерами (v_ и w_ нужны для копирования, перемещения и обмена)
+// и над их моделями
+template <typename Container>
+class Fuzzer {
+    using Element = std::iter_value_t<typename Container::iterator>;
+
+    // Сдвиги и удаление присваивают элементы, и если присваивание может бросить, гарантия только базовая
+    static constexpr bool NOTHROW_SHIFT = std::is_nothrow_move_assignable_v<Element>;
+
+public:
+    void Run(Input& input) {
+        while (!input.Empty()) {
+            const uint8_t op = input.Next();
+            const uint8_t arg = input.Next();
+            const uint8_t fault = input.Next();
+            // Каждую четвёртую операцию проверяем во всех точках внедрения по очереди, остальные - в одной или ни в одной
+            exhaustive_ = fault % 4 == 0;
+            first_fault_ = exhaustive_ ? 1 : fault / 4 % 16;
+            Step(op, arg);
+        }
+        v_.Clear();
+        w_.Clear();
+        model_v_.clear();
+        model_w_.clear();
+        extra_alive_ = 0;
+        Verify("Clear");
+    }
+
+private:
+    Container v_;
+    Container w_;
+    std::vector<int> model_v_;
+    std::vector<int> model_w_;
+    // Элементы, которые держит сам тест (источник вставки диапазона)
+    size_t extra_alive_ = 0;
+    bool exhaustive_ = false;
+    size_t first_fault_ = 0;
+
+    static size_t Pos(uint8_t arg, size_t size) noexcept {
+        return arg % (size + 1);
+    }
+
+    void Step(uint8_t op, uint8_t arg) {
+        extra_alive_ = 0;
+        const int value = arg;
+        const bool can_grow = v_.Size() < MAX_SIZE;
+        switch (op % 20) {
+            case 0:
+                if (can_grow) {
+                    const Element element(value);
+                    extra_alive_ = 1;
+                    Apply("PushBack(const T&)", Guarantee::STRONG, [&] {
+                        v_.PushBack(element);
+                    }, [&] {
+                        model_v_.push_back(value);
+                    });
+                }
+                break;
+            case 1:
+                if (can_grow) {
+                    Apply("PushBack(T&&)", Guarantee::STRONG, [&] {
+                        Element element = Make(value);
+                        v_.PushBack(std::move(element));
+                    }, [&] {
+                        model_v_.push_back(value);
+                    });
+                }
+                break;
+            case 2:
+                if (can_grow) {
+                    Apply("EmplaceBack", Guarantee::STRONG, [&] {
+                        v_.EmplaceBack(value);
+                    }, [&] {
+                        model_v_.push_back(value);
+                    });
+                }
+                break;
+            case 3:
+                // Аргумент ссылается на элемент самого вектора, который может переехать при реаллокации
+                if (can_grow && v_.Size() != 0) {
+                    Apply("PushBack(own element)", Guarantee::STRONG, [&] {
+                        v_.PushBack(v_[arg % v_.Size()]);
+                    }, [&] {
+                        model_v_.push_back(model_v_[arg % model_v_.size()]);
+                    });
+                }
+                break;
+            case 4:
+                if (can_grow) {
+                    const Element element(value);
+                    extra_alive_ = 1;
+                    Apply("Insert(const T&)", ShiftGuarantee(), [&] {
+                        v_.Insert(v_.begin() + Pos(arg, v_.Size()), element);
+                    }, [&] {
+                        model_v_.insert(model_v_.begin() + Pos(arg, model_v_.size()), value);
+                    });
+                }
+                break;
+            case 5:
+                if (can_grow) {
+                    Apply("Emplace", ShiftGuarantee(), [&] {
+                        v_.Emplace(v_.begin() + Pos(arg, v_.Size()), value);
+                    }, [&] {
+                        model_v_.insert(model_v_.begin() + Pos(arg, model_v_.size()), value);
+                    });
+                }
+                break;
+            case 6:
+                if (can_grow && v_.Size() != 0) {
+                    Apply("Insert(own element)", ShiftGuarantee(), [&] {
+                        v_.Insert(v_.begin() + Pos(arg, v_.Size()), v_[arg / 2 % v_.Size()]);
+                    }, [&] {
+                        const int own = model_v_[arg / 2 % model_v_.size()];
+                        model_v_.insert(model_v_.begin() + Pos(arg, model_v_.size()), own);
+                    });
+                }
+                break;
+            case 7:
+                if constexpr (requires(Container& c, const Element& e) { c.Insert(c.begin(), size_t{1}, e); }) {
+                    if (can_grow) {
+                        const size_t count = arg % MAX_BATCH;
+                        const Element element(value);
+                        extra_alive_ = 1;
+                        Apply("Insert(count, value)", RangeGuarantee(), [&] {
+                            v_.Insert(v_.begin() + Pos(arg, v_.Size()), count, element);
+                        }, [&] {
+                            model_v_.insert(model_v_.begin() + Pos(arg, model_v_.size()), count, value);
+                        });
+                    }
+                }
+                break;
+            case 8:
+                if constexpr (requires(Container& c, const Element* p) { c.Insert(c.begin(), p, p); }) {
+                    if (can_grow) {
+                        std::vector<Element> source;
+                        for (size_t i = 0; i < arg % MAX_BATCH; ++i) {
+                            source.emplace_back(value + static_cast<int>(i));
+                        }
+                        extra_alive_ = source.size();
+                        Apply("Insert(first, last)", RangeGuarantee(), [&] {
+                            v_.Insert(v_.begin() + Pos(arg, v_.Size()), source.data(), source.data() + source.size());
+                        }, [&] {
+                            std::vector<int> values(source.size());
+                            std::iota(values.begin(), values.end(), value);
+                            model_v_.insert(model_v_.begin() + Pos(arg, model_v_.size()), values.begin(), values.end());
+                        });
+                    }
+                }
+                break;
+            case 9:
+                if (v_.Size() != 0) {
+                    Apply("Erase", NOTHROW_SHIFT ? Guarantee::NOTHROW : Guarantee::BASIC, [&] {
+                        v_.Erase(v_.begin() + arg % v_.Size());
+                    }, [&] {
+                        model_v_.erase(model_v_.begin() + arg % model_v_.size());
+                    });
+                }
+                break;
+            case 10:
+                Apply("Erase(first, last)", NOTHROW_SHIFT ? Guarantee::NOTHROW : Guarantee::BASIC, [&] {
+                    const size_t first = Pos(arg, v_.Size());
+                    v_.Erase(v_.begin() + first, v_.begin() + first + (v_.Size() - first) * (arg % 3) / 2);
+                }, [&] {
+                    const size_t first = Pos(arg, model_v_.size());
+                    const size_t count = (model_v_.size() - first) * (arg % 3) / 2;
+                    model_v_.erase(model_v_.begin() + first, model_v_.begin() + first + count);
+                });
+                break;
+            case 11:
+                if (v_.Size() != 0) {
+                    Apply("PopBack", Guarantee::NOTHROW, [&] {
+                        v_.PopBack();
+                    }, [&] {
+                        model_v_.pop_back();
+                    });
+                }
+                break;
+            case 12:
+                Apply("Resize", Guarantee::STRONG, [&] {
+                    v_.Resize(arg % MAX_SIZE);
+                }, [&] {
+                    model_v_.resize(arg % MAX_SIZE);
+                });
+                break;
+            case 13:
+                Apply("Reserve", Guarantee::STRONG, [&] {
+                    v_.Reserve(arg % (MAX_SIZE + MAX_BATCH));
+                }, [] {
+                });
+                break;
+            case 14:
+                if constexpr (requires(Container& c) { c.ShrinkToFit(); }) {
+                    Apply("ShrinkToFit", Guarantee::STRONG, [&] {
+                        v_.ShrinkToFit();
+                    }, [] {
+                    });
+                }
+                break;
+            case 15:
+                Apply("Clear", Guarantee::NOTHROW, [&] {
+                    v_.Clear();
+                }, [&] {
+                    model_v_.clear();
+                });
+                break;
+            case 16:
+                // Копирующее присваивание на месте присваивает элементы по одному: гарантия только базовая
+                Apply("copy assignment", Guarantee::BASIC, [&] {
+                    w_ = v_;
+                }, [&] {
+                    model_w_ = model_v_;
+                });
+                break;
+            case 17:
+                // Копия строится отдельно, поэтому цель не меняется, если её перемещение не бросает
+                Apply("copy and move assignment", MoveGuarantee() == Guarantee::NOTHROW ? Guarantee::STRONG
+                                                                                         : Guarantee::BASIC, [&] {
+                    w_ = Container(v_);
+                }, [&] {
+                    model_w_ = model_v_;
+                });
+                break;
+            case 18:
+                Apply("Swap", SwapGuarantee(), [&] {
+                    v_.Swap(w_);
+                }, [&] {
+                    model_v_.swap(model_w_);
+                });
+                break;
+            case 19:
+                Apply("move assignment", MoveGuarantee(), [&] {
+                    w_ = std::move(v_);
+                }, [&] {
+                    model_w_ = std::move(model_v_);
+                    model_v_.clear();
+                });
+                break;
+        }
+    }
+
+    static Element Make(int value) {
+        return Element(value);
+    }
+
+    // Вставка одного элемента в середину: строгая гарантия, пока сдвиг хвоста не бросает
+    static Guarantee ShiftGuarantee() noexcept {
+        return NOTHROW_SHIFT ? Guarantee::STRONG : Guarantee::BASIC;
+    }
+
+    // Вставка нескольких элементов в середину без реаллокации присваивает их поверх сдвинутого хвоста:
+    // строгая гарантия есть только для тривиально перемещаемых типов, хвост которых сдвигается memmove
+    static Guarantee RangeGuarantee() noexcept {
+        return IsTriviallyRelocatableV<Element> ? Guarantee::STRONG : Guarantee::BASIC;
+    }
+
+    // Встроенные элементы обмениваются по одному через перемещение
+    Guarantee SwapGuarantee() noexcept {
+        return noexcept(v_.Swap(w_)) ? Guarantee::NOTHROW : Guarantee::BASIC;
+    }
+
+    // Буфер в куче забирается целиком, а встроенные элементы SmallVector и StaticVector переносятся по одному
+    // после очистки цели, поэтому при бросающем перемещении гарантия только базовая
+    static Guarantee MoveGuarantee() noexcept {
+        return std::is_nothrow_move_assignable_v<Container> ? Guarantee::NOTHROW : Guarantee::BASIC;
+    }
+
+    // Выполняет операцию, внедряя исключение в точку номер first_fault_ (0 - без внедрения). В исчерпывающем режиме
+    // после каждого исключения пробует следующую точку, пока операция не пройдёт
+    template <typename Operation, typename ModelOperation>
+    void Apply(const char* name, Guarantee guarantee, Operation operation, ModelOperation model_operation) {
+        for (size_t fault = first_fault_;; ++fault) {
+            FaultInjector::Arm(fault);
+            try {
+                operation();
+            } catch (const InjectedFault&) {
+                Recover(name, guarantee);
+                if (exhaustive_) {
+                    continue;
+                }
+                return;
+            } catch (const std::bad_alloc&) {
+                Recover(name, guarantee);
+                if (exhaustive_) {
+                    continue;
+                }
+                return;
+            }
+            FaultInjector::Disarm();
+            model_operation();
+            Verify(name);
+            return;
+        }
+    }
+
+    void Recover(const char* name, Guarantee guarantee) {
+        FaultInjector::Disarm();
+        if (guarantee == Guarantee::NOTHROW) {
+            Fail("exception from a non-throwing operation", name);
+        }
+        if (guarantee == Guarantee::BASIC) {
+            // Содержимое могло измениться: модель догоняет контейнер, а проверяются живость и учёт объектов
+            Resync(v_, model_v_);
+            Resync(w_, model_w_);
+        }
+        Verify(name);
+    }
+
+    static void Resync(const Container& container, std::vector<int>& model) {
+        model.clear();
+        for (size_t i = 0; i < container.Size(); ++i) {
+            container[i].Check("dead element after a failed operation");
+            model.push_back(container[i].value);
+        }
+    }
+
+    void Verify(const char* name) const {
+        Compare(v_, model_v_, name);
+        Compare(w_, model_w_, name);
+        if (alive_elements != static_cast<long>(v_.Size() + w_.Size() + extra_alive_)) {
+            Fail("element leaked or destroyed twice", name);
+        }
+    }
+
+    static void Compare(const Container& container, const std::vector<int>& model, const char* name) {
+        if (container.Size() != model.size() || container.Capacity() < container.Size()) {
+            Fail("size differs from the model", name);
+        }
+        for (size_t i = 0; i < model.size(); ++i) {
+            container[i].Check("dead element in a container");
+            if (container[i].value != model[i]) {
+                Fail("element differs from the model", name);
+            }
+        }
+    }
+};
+
+template <typename Container>
+void FuzzContainer(const char* name, const uint8_t* data, size_t size) {
+    current_container = name;
+    {
+        Input input(data, size);
+        Fuzzer<Container>().Run(input);
+    }
+    FaultInjector::Disarm();
+    if (alive_elements != 0) {
+        Fail("elements outlived their containers", "destruction");
+    }
+    if (!live_blocks.empty()) {
+        Fail("memory leaked", "destruction");
+    }
+}
+
+void FuzzOne(const uint8_t* data, size_t size) {
+    // Перемещение без исключений, перемещение с исключениями (копирование при реаллокации),
+    // тривиальная релокация memmove и рост буфера на месте через reallocate
+    FuzzContainer<Vector<Tracked<true>, FaultyAllocator<Tracked<true>>>>("Vector, nothrow move", data, size);
+    FuzzContainer<Vector<Tracked<false>, FaultyAllocator<Tracked<false>>>>("Vector, throwing move", data, size);
+    FuzzContainer<Vector<Tracked<true, true>, FaultyAllocator<Tracked<true, true>>>>("Vector, trivially relocatable", data, size);
+    FuzzContainer<Vector<Tracked<true, true>, FaultyAllocator<Tracked<true, true>, true>>>("Vector, reallocate in place", data, size);
+    // Встроенный буфер и переезд в кучу и обратно
+    FuzzContainer<SmallVector<Tracked<true>, 4, FaultyAllocator<Tracked<true>>>>("SmallVector, nothrow move", data, size);
+    FuzzContainer<SmallVector<Tracked<false>, 4, FaultyAllocator<Tracked<false>>>>("SmallVector, throwing move", data, size);
+    FuzzContainer<StaticVector<Tracked<true>, MAX_SIZE + MAX_BATCH>>("StaticVector, nothrow move", data, size);
+    FuzzContainer<StaticVector<Tracked<false>, MAX_SIZE + MAX_BATCH>>("StaticVector, throwing move", data, size);
+}
+
+}  // namespace
+
+#ifdef ADVANCED_VECTOR_LIBFUZZER
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    FuzzOne(data, size);
+    return 0;
+}
+#else
+int main(int argc, char* argv[]) {
+    const size_t cases = argc > 1 ? std::stoul(argv[1]) : 2000;
+    const uint64_t seed = argc > 2 ? std::stoull(argv[2]) : 1;
+
+    std::mt19937_64 random(seed);
+    std::vector<uint8_t> data;
+    for (size_t i = 0; i < cases; ++i) {
+        data.resize(random() % 600);
+        for (uint8_t& byte : data) {
+            byte = static_cast<uint8_t>(random());
+        }
+        FuzzOne(data.data(), data.size());
+    }
+    std::printf("fuzz: %zu cases, %zu fault points, %zu faults injected (seed %llu)\n", cases, FaultInjector::points,
+                FaultInjector::injected, static_cast<unsigned long long>(seed));
+}
+#endif
@@ -0,0 +1,209 @@
+#pragma once
+
+#include "vector.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+// Статистика векторов, собранная по точкам наблюдения. Точка - это имя в политике NamedStats:
+//     Vector<Token, std::allocator<Token>, DoublingGrowth, NamedStats<"parser.tokens">> tokens;
+// Все векторы с одной политикой пишут в общие атомарные счётчики, а реестр StatsRegistry позволяет
+// снять снимок по всем точкам или выдать его текстом. Большое число growth_events при малом числе
+// векторов подсказывает, где не хватает Reserve
+
+// Снимок счётчиков одной точки наблюдения
+struct VectorStats {
+    size_t reallocations = 0;      // все смены буфера, включая Reserve и ShrinkToFit
+    size_t growth_events = 0;      // смены буфера из-за нехватки места
+    size_t allocations = 0;
+    size_t bytes_allocated = 0;
+    size_t bytes_freed = 0;
+    size_t elements_relocated = 0; // перенесено при смене буфера перемещением или побайтово
+    size_t elements_copied = 0;    // перенесено при смене буфера копированием
+    size_t peak_capacity = 0;      // наибольшая ёмкость одного вектора
+};
+
+// Атомарные счётчики одной точки наблюдения. Все операции lock-free и не бросают исключений
+class VectorStatsCounters {
+public:
+    void OnAllocate(size_t bytes) noexcept {
+        allocations_.fetch_add(1, std::memory_order_relaxed);
+        bytes_allocated_.fetch_add(bytes, std::memory_order_relaxed);
+    }
+
+    void OnDeallocate(size_t bytes) noexcept {
+        bytes_freed_.fetch_add(bytes, std::memory_order_relaxed);
+    }
+
+    void OnReallocate(const ReallocationEvent& event) noexcept {
+        reallocations_.fetch_add(1, std::memory_order_relaxed);
+        if (event.reason == ReallocationReason::GROWTH) {
+            growth_events_.fetch_add(1, std::memory_order_relaxed);
+        }
+        elements_relocated_.fetch_add(event.relocated, std::memory_order_relaxed);
+        elements_copied_.fetch_add(event.copied, std::memory_order_relaxed);
+
+        size_t peak = peak_capacity_.load(std::memory_order_relaxed);
+        while (event.new_capacity > peak
+               && !peak_capacity_.compare_exchange_weak(peak, event.new_capacity, std::memory_order_relaxed)) {
+        }
+    }
+
+    // Счётчики читаются по отдельности, поэтому снимок во время работы других потоков согласован лишь приблизительно
+    VectorStats Snapshot() const noexcept {
+        return {
+            .reallocations = reallocations_.load(std::memory_order_relaxed),
+            .growth_events = growth_events_.load(std::memory_order_relaxed),
+            .allocations = allocations_.load(std::memory_order_relaxed),
+            .bytes_allocated = bytes_allocated_.load(std::memory_order_relaxed),
+            .bytes_freed = bytes_freed_.load(std::memory_order_relaxed),
+            .elements_relocated = elements_relocated_.load(std::memory_order_relaxed),
+            .elements_copied = elements_copied_.load(std::memory_order_relaxed),
+            .peak_capacity = peak_capacity_.load(std::memory_order_relaxed),
+        };
+    }
+
+    void Reset() noexcept {
+        for (std::atomic<size_t>* counter : {&reallocations_, &growth_events_, &allocations_, &bytes_allocated_,
+                                             &bytes_freed_, &elements_relocated_, &elements_copied_, &peak_capacity_}) {
+            counter->store(0, std::memory_order_relaxed);
+        }
+    }
+
+private:
+    std::atomic<size_t> reallocations_ = 0;
+    std::atomic<size_t> growth_events_ = 0;
+    std::atomic<size_t> allocations_ = 0;
+    std::atomic<size_t> bytes_allocated_ = 0;
+    std::atomic<size_t> bytes_freed_ = 0;
+    std::atomic<size_t> elements_relocated_ = 0;
+    std::atomic<size_t> elements_copied_ = 0;
+    std::atomic<size_t> peak_capacity_ = 0;
+};
+
+struct NamedVectorStats {
+    std::string name;
+    VectorStats stats;
+};
+
+// Глобальный реестр точек наблюдения. Точки регистрируются сами при первом событии и живут до конца программы
+class StatsRegistry {
+public:
+    static StatsRegistry& Instance() {
+        static StatsRegistry registry;
+        return registry;
+    }
+
+    // Не бросает исключений: если памяти под запись не хватило, точка просто не попадёт в снимки
+    void Register(std::string_view name, const VectorStatsCounters* counters) noexcept {
+        try {
+            std::lock_guard lock(mutex_);
+            entries_.push_back({name, counters});
+        } catch (...) {
+        }
+    }
+
+    // Снимки всех точек, упорядоченные по имени
+    std::vector<NamedVectorStats> Snapshot() const {
+        std::vector<NamedVectorStats> result;
+        {
+            std::lock_guard lock(mutex_);
+            result.reserve(entries_.size());
+            for (const Entry& entry : entries_) {
+                result.push_back({std::string(entry.name), entry.counters->Snapshot()});
+            }
+        }
+        std::sort(result.begin(), result.end(), [](const NamedVectorStats& lhs, const NamedVectorStats& rhs) {
+            return lhs.name < rhs.name;
+        });
+        return result;
+    }
+
+    // Снимок в текстовом формате Prometheus: по строке `vector_<счётчик>{site="<имя>"} <значение>` на счётчик
+    void Write(std::ostream& out) const {
+        for (const auto& [name, stats] : Snapshot()) {
+            const auto line = [&out, &name](std::string_view counter, size_t value) {
+                out << "vector_" << counter << "{site=\"" << name << "\"} " << value << '\n';
+            };
+            line("reallocations", stats.reallocations);
+            line("growth_events", stats.growth_events);
+            line("allocations", stats.allocations);
+            line("bytes_allocated", stats.bytes_allocated);
+            line("bytes_freed", stats.bytes_freed);
+            line("elements_relocated", stats.elements_relocated);
+            line("elements_copied", stats.elements_copied);
+            line("peak_capacity", stats.peak_capacity);
+        }
+    }
+
+private:
+    struct Entry {
+        std::string_view name;
+        const VectorStatsCounters* counters;
+    };
+
+    StatsRegistry() = default;
+
+    mutable std::mutex mutex_;
+    std::vector<Entry> entries_;
+};
+
+// Строковый литерал как параметр шаблона
+template <size_t N>
+struct FixedString {
+    constexpr FixedString(const char (&str)[N]) noexcept {
+        std::copy_n(str, N, data);
+    }
+
+    constexpr std::string_view View() const noexcept {
+        return {data, N - 1};
+    }
+
+    char data[N];
+};
+
+// Политика инструментирования, собирающая статистику точки наблюдения Name (см. NoInstrumentation)
+template <FixedString Name>
+struct NamedStats {
+    static VectorStatsCounters& Counters() noexcept {
+        static VectorStatsCounters& counters = Register();
+        return counters;
+    }
+
+    static VectorStats Snapshot() noexcept {
+        return Counters().Snapshot();
+    }
+
+    static void Reset() noexcept {
+        Counters().Reset();
+    }
+
+    static void OnAllocate(size_t bytes) noexcept {
+        Counters().OnAllocate(bytes);
+    }
+
+    static void OnDeallocate(size_t bytes) noexcept {
+        Counters().OnDeallocate(bytes);
+    }
+
+    static void OnReallocate(const ReallocationEvent& event) noexcept {
+        Counters().OnReallocate(event);
+    }
+
+private:
+    // Счётчики тривиально разрушаемы, поэтому векторы со статическим временем жизни могут писать в них до самого конца
+    static_assert(std::is_trivially_destructible_v<VectorStatsCounters>);
+
+    static VectorStatsCounters& Register() noexcept {
+        static VectorStatsCounters counters;
+        StatsRegistry::Instance().Register(Name.View(), &counters);
+        return counters;
+    }
+};
@@ -1,10 +1,42 @@
+#include "allocators.h"
+#include "bit_vector.h"
+#include "concurrent_vector.h"
+#include "cow_vector.h"
+#include "flat_map.h"
+#include "instrumentation.h"
+#include "mapped_vector.h"
+#include "parallel.h"
+#include "ring_buffer.h"
+#include "segmented_vector.h"
+#include "small_vector.h"
+#include "soa_vector.h"
+#include "static_vector.h"
 #include "vector.h"
+#include "vector_algorithms.h"
+#include "vector_serialization.h"
 
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <filesystem>
 #include <iostream>
+#include <limits>
+#include <memory_resource>
+#include <numeric>
+#include <optional>
+#include <random>
+#include <ranges>
+#include <span>
+#include <sstream>
 #include <stdexcept>
 #include <string>
+#include <thread>
 #include <vector>
 
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
 namespace {
 
 // "Магическое" число, используемое для отслеживания живости объекта
@@ -116,8 +148,109 @@ struct Obj {
     static inline int num_move_assigned = 0;
 };
 
+// Ресурс памяти, считающий выделения и освобождения
+class CountingResource : public std::pmr::memory_resource {
+public:
+    size_t allocations = 0;
+    size_t deallocations = 0;
+    size_t bytes_in_use = 0;
+
+private:
+    void* do_allocate(size_t bytes, size_t alignment) override {
+        ++allocations;
+        bytes_in_use += bytes;
+        return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void* p, size_t bytes, size_t alignment) override {
+        ++deallocations;
+        bytes_in_use -= bytes;
+        std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+};
+
+// Аллокатор с состоянием, который распространяется при копировании, перемещении и обмене
+template <typename T>
+struct PropagatingAllocator {
+    using value_type = T;
+    using propagate_on_container_copy_assignment = std::true_type;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
+
+    explicit PropagatingAllocator(int id) noexcept
+        : id(id) {
+    }
+
+    template <typename U>
+    PropagatingAllocator(const PropagatingAllocator<U>& other) noexcept
+        : id(other.id) {
+    }
+
+    T* allocate(size_t n) {
+        return std::allocator<T>().allocate(n);
+    }
+
+    void deallocate(T* p, size_t n) noexcept {
+        std::allocator<T>().deallocate(p, n);
+    }
+
+    bool operator==(const PropagatingAllocator& other) const noexcept {
+        return id == other.id;
+    }
+
+    int id;
+};
+
+// Тип с нетривиальным перемещением, который явно отмечен как тривиально перемещаемый
+struct Relocatable {
+    explicit Relocatable(int value = 0)
+        : value(std::make_unique<int>(value)) {
+    }
+
+    Relocatable(Relocatable&& other) noexcept
+        : value(std::move(other.value)) {
+        ++num_moved;
+    }
+
+    Relocatable& operator=(Relocatable&& other) noexcept {
+        value = std::move(other.value);
+        ++num_moved;
+        return *this;
+    }
+
+    ~Relocatable() {
+        ++num_destroyed;
+    }
+
+    std::unique_ptr<int> value;
+
+    static inline int num_moved = 0;
+    static inline int num_destroyed = 0;
+};
+
+// Исполнитель, выполняющий куски параллельных операций по очереди в вызывающем потоке
+struct InlineExecutor {
+    size_t Concurrency() const noexcept {
+        return 8;
+    }
+
+    template <typename Task>
+    void Run(size_t tasks, Task& task) const noexcept {
+        for (size_t i = 0; i < tasks; ++i) {
+            task(i);
+        }
+    }
+};
+
 }  // namespace
 
+template <>
+struct IsTriviallyRelocatable<Relocatable> : std::true_type {};
+
 void Test1() {
     Obj::ResetCounters();
     const size_t SIZE = 100500;
@@ -432,7 +565,7 @@ void Test6() {
     {
         Obj::ResetCounters();
         Vector<Obj> v;
-        auto* pos = v.Emplace(v.end(), Obj{1});
+        auto pos = v.Emplace(v.end(), Obj{1});
         assert(v.Size() == 1);
         assert(v.Capacity() >= v.Size());
         assert(&*pos == &v[0]);
@@ -447,7 +580,7 @@ void Test6() {
         Obj::ResetCounters();
         Vector<Obj> v;
         v.Reserve(SIZE);
-        auto* pos = v.Emplace(v.end(), Obj{1});
+        auto pos = v.Emplace(v.end(), Obj{1});
 
         assert(v.Size() == 1);
         assert(v.Capacity() >= v.Size());
@@ -495,7 +628,7 @@ void Test6() {
     {
         Obj::ResetCounters();
         Vector<Obj> v{SIZE};
-        auto* pos = v.Emplace(v.cbegin() + 1, ID, "Ivan"s);
+        auto pos = v.Emplace(v.cbegin() + 1, ID, "Ivan"s);
         assert(v.Size() == SIZE + 1);
         assert(v.Capacity() == SIZE * 2);
         assert(&*pos == &v[1]);
@@ -511,7 +644,7 @@ void Test6() {
     {
         Obj::ResetCounters();
         Vector<Obj> v{SIZE};
-        auto* pos = v.Emplace(v.cbegin() + v.Size(), ID, "Ivan"s);
+        auto pos = v.Emplace(v.cbegin() + v.Size(), ID, "Ivan"s);
         assert(v.Size() == SIZE + 1);
         assert(v.Capacity() == SIZE * 2);
         assert(&*pos == &v[SIZE]);
@@ -530,7 +663,7 @@ void Test6() {
         v.Reserve(SIZE * 2);
         const int old_num_moved = Obj::num_moved;
         assert(v.Capacity() == SIZE * 2);
-        auto* pos = v.Emplace(v.cbegin() + 3, ID, "Ivan"s);
+        auto pos = v.Emplace(v.cbegin() + 3, ID, "Ivan"s);
         assert(v.Size() == SIZE + 1);
         assert(&*pos == &v[3]);
         assert(v[3].id == ID);
@@ -546,7 +679,7 @@ void Test6() {
         Obj::ResetCounters();
         Vector<Obj> v{SIZE};
         v[2].id = ID;
-        auto* pos = v.Erase(v.cbegin() + 1);
+        auto pos = v.Erase(v.cbegin() + 1);
         assert((pos - v.begin()) == 1);
         assert(v.Size() == SIZE - 1);
         assert(v.Capacity() == SIZE);
@@ -559,89 +692,2493 @@ void Test6() {
     }
 }
 
-struct C {
-    C() noexcept {
-        ++def_ctor;
+void Test7() {
+    using PmrVector = Vector<Obj, std::pmr::polymorphic_allocator<Obj>>;
+    const size_t SIZE = 10;
+    const int ID = 42;
+    {
+        Obj::ResetCounters();
+        CountingResource resource;
+        {
+            PmrVector v(&resource);
+            for (size_t i = 0; i < SIZE; ++i) {
+                v.EmplaceBack(ID);
+            }
+            assert(v.GetAllocator().resource() == &resource);
+            assert(resource.allocations > 0);
+
+            // Копия выбирает аллокатор через select_on_container_copy_construction, т.е. ресурс по умолчанию
+            PmrVector v_copy(v);
+            assert(v_copy.GetAllocator().resource() == std::pmr::get_default_resource());
+
+            // Перемещение забирает буфер вместе с ресурсом
+            const size_t allocations = resource.allocations;
+            PmrVector moved(std::move(v));
+            assert(moved.GetAllocator().resource() == &resource);
+            assert(resource.allocations == allocations);
+            assert(moved.Size() == SIZE);
+        }
+        assert(resource.bytes_in_use == 0);
+        assert(resource.allocations == resource.deallocations);
+        assert(Obj::GetAliveObjectCount() == 0);
+    }
+    {
+        Obj::ResetCounters();
+        CountingResource lhs_resource;
+        CountingResource rhs_resource;
+        {
+            PmrVector lhs(&lhs_resource);
+            PmrVector rhs(SIZE, &rhs_resource);
+            rhs[0].id = ID;
+
+            // Аллокаторы не распространяются и не равны: элементы перемещаются по одному
+            lhs = std::move(rhs);
+            assert(lhs.GetAllocator().resource() == &lhs_resource);
+            assert(lhs.Size() == SIZE);
+            assert(lhs[0].id == ID);
+            assert(Obj::num_moved == SIZE);
+            assert(lhs_resource.bytes_in_use == SIZE * sizeof(Obj));
+        }
+        assert(lhs_resource.bytes_in_use == 0);
+        assert(rhs_resource.bytes_in_use == 0);
+        assert(Obj::GetAliveObjectCount() == 0);
+    }
+    {
+        using PropVector = Vector<int, PropagatingAllocator<int>>;
+        PropVector a(SIZE, PropagatingAllocator<int>(1));
+        PropVector b(PropagatingAllocator<int>(2));
+        b = a;
+        assert(b.GetAllocator().id == 1);
+        assert(b.Size() == SIZE);
+
+        PropVector c(PropagatingAllocator<int>(3));
+        c = std::move(a);
+        assert(c.GetAllocator().id == 1);
+        assert(c.Size() == SIZE);
+
+        PropVector d(1, PropagatingAllocator<int>(4));
+        d.Swap(c);
+        assert(d.GetAllocator().id == 1);
+        assert(c.GetAllocator().id == 4);
+        assert(d.Size() == SIZE && c.Size() == 1);
     }
-    C(const C& /*other*/) noexcept {
-        ++copy_ctor;
+}
+
+void Test8() {
+    const int SIZE = 100;
+    static_assert(IsTriviallyRelocatableV<int>);
+    static_assert(IsTriviallyRelocatableV<std::unique_ptr<int>>);
+    static_assert(!IsTriviallyRelocatableV<std::string>);
+    static_assert(!IsTriviallyRelocatableV<Obj>);
+    {
+        Vector<Relocatable> v;
+        for (int i = 0; i < SIZE; ++i) {
+            v.EmplaceBack(i);
+        }
+        v.Reserve(SIZE * 4);
+        v.Resize(SIZE / 2);
+        // Перенос в новую память не вызывает ни перемещений, ни деструкторов старых копий
+        assert(Relocatable::num_moved == 0);
+        assert(Relocatable::num_destroyed == SIZE / 2);
+
+        v.Erase(v.begin() + 1);
+        assert(Relocatable::num_moved == 0);
+        assert(Relocatable::num_destroyed == SIZE / 2 + 1);
+        assert(v.Size() == SIZE / 2 - 1);
+        assert(*v[0].value == 0);
+        for (size_t i = 1; i < v.Size(); ++i) {
+            assert(*v[i].value == static_cast<int>(i) + 1);
+        }
     }
-    C(C&& /*other*/) noexcept {
-        ++move_ctor;
+    {
+        Vector<std::unique_ptr<int>> v;
+        for (int i = 0; i < SIZE; ++i) {
+            v.Emplace(v.begin(), std::make_unique<int>(i));
+        }
+        v.Erase(v.begin());
+        assert(v.Size() == SIZE - 1);
+        for (int i = 0; i < SIZE - 1; ++i) {
+            assert(*v[i] == SIZE - 2 - i);
+        }
     }
-    C& operator=(const C& other) noexcept {
-        if (this != &other) {
-            ++copy_assign;
+}
+
+void Test9() {
+    static_assert(ReallocatingAllocator<MallocAllocator<int>, int>);
+    static_assert(!ReallocatingAllocator<std::allocator<int>, int>);
+    // Достаточно элементов, чтобы буфер пересёк порог mmap и рос через mremap
+    const int SIZE = static_cast<int>(MallocAllocator<int>::MMAP_THRESHOLD / sizeof(int)) * 4;
+    {
+        Vector<int, MallocAllocator<int>> v;
+        for (int i = 0; i < SIZE; ++i) {
+            v.PushBack(i);
         }
-        return *this;
+        assert(v.Size() == static_cast<size_t>(SIZE));
+        for (int i = 0; i < SIZE; ++i) {
+            assert(v[i] == i);
+        }
+
+        v.Resize(SIZE * 2);
+        assert(v[SIZE - 1] == SIZE - 1);
+        assert(v[SIZE] == 0 && v[SIZE * 2 - 1] == 0);
+
+        v.Reserve(SIZE * 3);
+        assert(v.Capacity() == static_cast<size_t>(SIZE) * 3);
+        assert(v[SIZE - 1] == SIZE - 1);
     }
-    C& operator=(C&& /*other*/) noexcept {
-        ++move_assign;
-        return *this;
+    {
+        Vector<int, MallocAllocator<int>> v(1);
+        // Вставка элемента самого вектора должна быть безопасна даже при перемещении буфера
+        v[0] = 42;
+        v.PushBack(v[0]);
+        v.Insert(v.begin(), v[1]);
+        assert(v.Size() == 3 && v[0] == 42 && v[1] == 42 && v[2] == 42);
     }
-    ~C() {
-        ++dtor;
+    {
+        Relocatable::num_moved = 0;
+        Relocatable::num_destroyed = 0;
+        Vector<Relocatable, MallocAllocator<Relocatable>> v;
+        for (int i = 0; i < 100; ++i) {
+            v.EmplaceBack(i);
+        }
+        assert(Relocatable::num_moved == 0);
+        assert(Relocatable::num_destroyed == 0);
+        for (int i = 0; i < 100; ++i) {
+            assert(*v[i].value == i);
+        }
     }
+}
 
-    static void Reset() {
-        def_ctor = 0;
-        copy_ctor = 0;
-        move_ctor = 0;
-        copy_assign = 0;
-        move_assign = 0;
-        dtor = 0;
-    }
+void Test10() {
+    // Удвоение сохраняет прежнюю последовательность ёмкостей
+    assert(DoublingGrowth::NextCapacity<int>(0, 1) == 1);
+    assert(DoublingGrowth::NextCapacity<int>(1, 2) == 2);
+    assert(DoublingGrowth::NextCapacity<int>(100, 101) == 200);
+    assert(DoublingGrowth::NextCapacity<int>(100, 500) == 500);
 
-    inline static size_t def_ctor = 0;
-    inline static size_t copy_ctor = 0;
-    inline static size_t move_ctor = 0;
-    inline static size_t copy_assign = 0;
-    inline static size_t move_assign = 0;
-    inline static size_t dtor = 0;
-};
+    // Первая ёмкость занимает кэш-линию, дальше рост в 1.5 раза с округлением до классов jemalloc
+    assert(CompactGrowth::NextCapacity<int>(0, 1) == 16);
+    assert(CompactGrowth::NextCapacity<int>(16, 17) == 24);
+    assert(CompactGrowth::NextCapacity<char>(1000, 1001) == 1536);
+    assert(CompactGrowth::NextCapacity<char>(1600, 1601) == 2560);
+    // Шаг роста ограничен 64 МиБ
+    const size_t huge = size_t{1} << 30;
+    assert(CompactGrowth::NextCapacity<char>(huge, huge + 1) == huge + (size_t{64} << 20));
 
-void Dump() {
-    using namespace std;
-    cerr << "Def ctors: "sv << C::def_ctor              //
-         << ", Copy ctors: "sv << C::copy_ctor          //
-         << ", Move ctors: "sv << C::move_ctor          //
-         << ", Copy assignments: "sv << C::copy_assign  //
-         << ", Move assignments: "sv << C::move_assign  //
-         << ", Dtors: "sv << C::dtor << endl;
+    const size_t SIZE = 10'000;
+    {
+        Vector<int> v;
+        size_t reallocations = 0;
+        for (size_t i = 1; i <= SIZE; ++i) {
+            const size_t capacity = v.Capacity();
+            v.Resize(i);
+            reallocations += capacity != v.Capacity();
+        }
+        // Resize(n + 1) растёт геометрически, а не на один элемент
+        assert(reallocations <= 15);
+    }
+    {
+        Obj::ResetCounters();
+        Vector<Obj, std::allocator<Obj>, CompactGrowth> v;
+        v.EmplaceBack(0);
+        assert(v.Capacity() * sizeof(Obj) >= 64);
+        size_t reallocations = 0;
+        for (size_t i = 1; i < SIZE; ++i) {
+            const size_t capacity = v.Capacity();
+            v.EmplaceBack(static_cast<int>(i));
+            reallocations += capacity != v.Capacity();
+        }
+        assert(reallocations <= 25);
+        for (size_t i = 0; i < SIZE; ++i) {
+            assert(v[i].id == static_cast<int>(i));
+        }
+    }
+    assert(Obj::GetAliveObjectCount() == 0);
 }
 
-void Benchmark() {
-    using namespace std;
-    try {
-        const size_t NUM = 10;
-        C c;
-        {
-            cerr << "std::vector:"sv << endl;
-            C::Reset();
-            vector<C> v(NUM);
-            v.insert(v.begin(), v.back());
-            Dump();
-            v.push_back(c);
+void Test11() {
+    using namespace std::literals;
+    const size_t N = 8;
+    const size_t SIZE = 100;
+    const int ID = 42;
+    {
+        // Пока элементы помещаются во встроенный буфер, аллокатор не вызывается
+        CountingResource resource;
+        SmallVector<int, N, std::pmr::polymorphic_allocator<int>> v(&resource);
+        for (size_t i = 0; i < N; ++i) {
+            v.PushBack(static_cast<int>(i));
+        }
+        assert(v.IsInline());
+        assert(v.Capacity() == N);
+        assert(resource.allocations == 0);
+
+        v.PushBack(ID);
+        assert(!v.IsInline());
+        assert(v.Capacity() == N * 2);
+        assert(resource.allocations == 1);
+        for (size_t i = 0; i < N; ++i) {
+            assert(v[i] == static_cast<int>(i));
         }
-        Dump();
-    } catch (...) {
+        assert(v.Back() == ID);
     }
-    try {
-        const size_t NUM = 10;
-        C c;
+    {
+        Obj::ResetCounters();
         {
-            cerr << "Vector:"sv << endl;
-            C::Reset();
-            Vector<C> v(NUM);
-            v.Insert(v.begin(), v.Back());
-            Dump();
-            v.PushBack(c);
+            SmallVector<Obj, N> v(N);
+            assert(v.IsInline());
+            v.PushBack(Obj{ID});
+            assert(v.Size() == N + 1);
+            assert(Obj::num_moved == N + 1);
+            assert(Obj::num_copied == 0);
+
+            // Элементы в куче переезжают вместе с буфером, без перемещений
+            const int old_num_moved = Obj::num_moved;
+            SmallVector<Obj, N> moved(std::move(v));
+            assert(moved.Size() == N + 1 && v.Size() == 0);
+            assert(Obj::num_moved == old_num_moved);
+
+            SmallVector<Obj, N> copy(moved);
+            assert(copy.Size() == N + 1 && copy[N].id == ID);
+        }
+        assert(Obj::GetAliveObjectCount() == 0);
+    }
+    {
+        Obj::ResetCounters();
+        Obj::default_construction_throw_countdown = N / 2;
+        try {
+            SmallVector<Obj, N> v(N);
+            assert(false && "Exception is expected");
+        } catch (const std::runtime_error&) {
+        }
+        assert(Obj::GetAliveObjectCount() == 0);
+    }
+    {
+        Obj::ResetCounters();
+        SmallVector<Obj, N> v(SIZE);
+        try {
+            v[SIZE / 2].throw_on_copy = true;
+            SmallVector<Obj, N> v_copy(v);
+            assert(false && "Exception is expected");
+        } catch (const std::runtime_error&) {
+            assert(Obj::num_copied == SIZE / 2);
+        }
+        assert(Obj::GetAliveObjectCount() == SIZE);
+    }
+    {
+        Obj::ResetCounters();
+        SmallVector<Obj, N> v(N);
+        v.Reserve(N * 2);
+        const int old_num_moved = Obj::num_moved;
+        auto* pos = v.Emplace(v.cbegin() + 3, ID, "Ivan"s);
+        assert(&*pos == &v[3]);
+        assert(v[3].id == ID && v[3].name == "Ivan"s);
+        assert(Obj::num_moved == old_num_moved + 1);
+        assert(Obj::num_move_assigned == N - 3);
+
+        pos = v.Erase(v.cbegin() + 3);
+        assert(v.Size() == N);
+        assert(pos == v.begin() + 3);
+    }
+    {
+        // Вставка собственного элемента безопасна и при переполнении встроенного буфера
+        SmallVector<A, N> v(N);
+        v.PushBack(v[0]);
+        v.Insert(v.cbegin() + 2, v[0]);
+        v.Emplace(v.cbegin() + 2, std::move(v[0]));
+        assert(std::all_of(v.begin(), v.end(), [](const A& obj) {
+            return obj.IsAlive();
+        }));
+    }
+    {
+        SmallVector<std::string, 2> a{"a"s, "b"s, "c"s};
+        SmallVector<std::string, 2> b{"d"s};
+        a.Swap(b);
+        assert(a.Size() == 1 && a[0] == "d"s && a.IsInline());
+        assert(b.Size() == 3 && b[2] == "c"s);
+        b = a;
+        assert(b.Size() == 1 && b[0] == "d"s);
+        b.Resize(5);
+        assert(b.Size() == 5 && b[4].empty());
+    }
+    {
+        // Два числа - это количество и значение, а не пара итераторов
+        SmallVector<int, 4> s(5, 7);
+        assert(s.Size() == 5 && !s.IsInline() && std::ranges::count(s, 7) == 5);
+        SmallVector<size_t, 4> t(size_t{2}, size_t{3});
+        assert(t.Size() == 2 && t.IsInline() && t[1] == 3);
+
+        std::istringstream input("1 2 3 4 5 6");
+        SmallVector<int, 4> streamed(std::istream_iterator<int>(input), std::istream_iterator<int>{});
+        assert(streamed.Size() == 6 && streamed[5] == 6);
+    }
+}
+
+void Test12() {
+    using namespace std::literals;
+    const int SIZE = 10;
+    {
+        // Vector<int>(n, value) больше не путается с конструктором от диапазона
+        Vector<int> v(static_cast<size_t>(SIZE), 3);
+        assert(v.Size() == SIZE && v[SIZE - 1] == 3);
+    }
+    {
+        CountingResource resource;
+        Vector<int, std::pmr::polymorphic_allocator<int>> v(&resource);
+        const std::vector<int> src{100, 101, 102, 103, 104};
+        v.Reserve(SIZE);
+        for (int i = 0; i < SIZE; ++i) {
+            v.PushBack(i);
+        }
+        const size_t allocations = resource.allocations;
+        auto pos = v.Insert(v.begin() + 3, src.begin(), src.end());
+        // Вставка пачки реаллоцирует память не больше одного раза
+        assert(resource.allocations == allocations + 1);
+        assert(pos == v.begin() + 3);
+        assert(v.Size() == SIZE + src.size());
+        const std::vector<int> expected{0, 1, 2, 100, 101, 102, 103, 104, 3, 4, 5, 6, 7, 8, 9};
+        assert(std::equal(v.begin(), v.end(), expected.begin(), expected.end()));
+
+        v.Reserve(100);
+        v.Insert(v.begin(), 3, v[1]);
+        assert(v.Size() == 18 && v[0] == 1 && v[1] == 1 && v[2] == 1 && v[3] == 0 && v[4] == 1);
+
+        v.AppendRange(std::views::iota(0, 5));
+        assert(v.Size() == 23 && v.Back() == 4);
+    }
+    {
+        // Однопроходные источники
+        std::istringstream input("1 2 3");
+        Vector<int> v{10, 20};
+        v.Insert(v.begin() + 1, std::istream_iterator<int>(input), std::istream_iterator<int>());
+        const std::vector<int> expected{10, 1, 2, 3, 20};
+        assert(std::equal(v.begin(), v.end(), expected.begin(), expected.end()));
+
+        std::istringstream range_input("4 5");
+        v.AppendRange(std::views::istream<int>(range_input));
+        assert(v.Size() == 7 && v[5] == 4 && v[6] == 5);
+
+        std::istringstream ctor_input("7 8 9");
+        Vector<int> from_input(std::istream_iterator<int>(ctor_input), std::istream_iterator<int>{});
+        assert(from_input.Size() == 3 && from_input[2] == 9);
+    }
+    {
+        // Вставка в середину без реаллокации: хвост сдвигается один раз
+        Obj::ResetCounters();
+        Vector<Obj> v(SIZE);
+        v.Reserve(SIZE * 2);
+        Vector<Obj> src(3);
+        Obj::ResetCounters();
+        v.Insert(v.begin() + 2, src.begin(), src.end());
+        assert(v.Size() == SIZE + 3);
+        assert(Obj::num_moved == 3);
+        assert(Obj::num_move_assigned == SIZE - 2 - 3);
+        assert(Obj::num_assigned == 3);
+        assert(Obj::num_copied == 0);
+
+        // Вставка длиннее хвоста
+        Obj::ResetCounters();
+        v.Insert(v.end() - 1, 4, Obj{7});
+        assert(v.Size() == SIZE + 7);
+        assert(v[SIZE + 2].id == 7 && v[SIZE + 5].id == 7);
+        assert(Obj::num_moved == 1);
+        assert(Obj::num_assigned == 1);
+        assert(Obj::num_copied == 4);
+    }
+    {
+        // Исключение при копировании вставляемых элементов оставляет вектор прежним
+        Obj::ResetCounters();
+        Vector<Obj> v(SIZE);
+        v[0].id = 1;
+        Vector<Obj> src(SIZE);
+        src[SIZE / 2].throw_on_copy = true;
+        try {
+            v.Insert(v.begin() + 1, src.begin(), src.end());
+            assert(false && "Exception is expected");
+        } catch (const std::runtime_error&) {
+        }
+        assert(v.Size() == SIZE && v.Capacity() == SIZE && v[0].id == 1);
+        assert(Obj::GetAliveObjectCount() == SIZE * 2);
+    }
+    {
+        // Тривиально перемещаемые элементы
+        Vector<std::unique_ptr<int>> v;
+        v.Reserve(SIZE);
+        v.PushBack(std::make_unique<int>(1));
+        v.PushBack(std::make_unique<int>(4));
+        std::unique_ptr<int> src[] = {std::make_unique<int>(2), std::make_unique<int>(3)};
+        v.Insert(v.begin() + 1, std::make_move_iterator(std::begin(src)), std::make_move_iterator(std::end(src)));
+        assert(v.Size() == 4);
+        for (int i = 0; i < 4; ++i) {
+            assert(*v[i] == i + 1);
+        }
+    }
+}
+
+void Test13() {
+    const int SIZE = 100;
+    {
+        Obj::ResetCounters();
+        Vector<Obj> v;
+        for (int i = 0; i < SIZE; ++i) {
+            v.EmplaceBack(i);
+        }
+        Obj::ResetCounters();
+        auto pos = v.Erase(v.begin() + 10, v.begin() + 40);
+        assert(pos == v.begin() + 10);
+        assert(v.Size() == SIZE - 30);
+        assert(v[9].id == 9 && v[10].id == 40 && v.Back().id == SIZE - 1);
+        // Хвост сдвигается один раз, а разрушаются ровно удалённые элементы
+        assert(Obj::num_move_assigned == SIZE - 40);
+        assert(Obj::num_destroyed == 30);
+
+        pos = v.Erase(v.begin() + 5, v.begin() + 5);
+        assert(pos == v.begin() + 5 && v.Size() == SIZE - 30);
+
+        Obj::ResetCounters();
+        const size_t removed = EraseIf(v, [](const Obj& obj) {
+            return obj.id % 2 == 0;
+        });
+        assert(removed == 35);
+        assert(v.Size() == 35);
+        assert(std::all_of(v.begin(), v.end(), [](const Obj& obj) {
+            return obj.id % 2 == 1;
+        }));
+        assert(Obj::num_destroyed == 35);
+        assert(Obj::num_move_assigned <= 35);
+    }
+    {
+        Vector<int> v{1, 2, 3, 2, 2, 4};
+        assert(Remove(v, 2) == 3);
+        const std::vector<int> expected{1, 3, 4};
+        assert(std::equal(v.begin(), v.end(), expected.begin(), expected.end()));
+
+        v.Erase(v.begin(), v.end());
+        assert(v.Size() == 0 && v.Capacity() == 6);
+    }
+    {
+        Relocatable::num_moved = 0;
+        Relocatable::num_destroyed = 0;
+        Vector<Relocatable> v;
+        for (int i = 0; i < SIZE; ++i) {
+            v.EmplaceBack(i);
+        }
+        v.Erase(v.begin(), v.begin() + SIZE / 2);
+        assert(Relocatable::num_moved == 0);
+        assert(Relocatable::num_destroyed == SIZE / 2);
+        assert(*v[0].value == SIZE / 2);
+    }
+    {
+        SmallVector<std::string, 4> v{"a", "b", "c", "d", "e"};
+        v.Erase(v.begin() + 1, v.begin() + 3);
+        assert(v.Size() == 3 && v[0] == "a" && v[1] == "d" && v[2] == "e");
+    }
+}
+
+void Test14() {
+    const size_t SIZE = 100;
+    {
+        Vector<int> v(SIZE, DefaultInit);
+        assert(v.Size() == SIZE && v.Capacity() == SIZE);
+        v.ResizeDefaultInit(SIZE * 2);
+        assert(v.Size() == SIZE * 2);
+        v.ResizeDefaultInit(SIZE / 2);
+        assert(v.Size() == SIZE / 2);
+    }
+    {
+        Obj::ResetCounters();
+        Vector<Obj> v(SIZE, DefaultInit);
+        v.ResizeDefaultInit(SIZE * 2);
+        assert(Obj::num_default_constructed == SIZE * 2);
+        assert(Obj::GetAliveObjectCount() == SIZE * 2);
+    }
+    assert(Obj::GetAliveObjectCount() == 0);
+    {
+        Vector<char> buffer;
+        const std::string_view payload = "payload";
+        buffer.ResizeAndOverwrite(64, [&payload](char* data, size_t count) {
+            assert(count == 64);
+            return static_cast<size_t>(std::copy(payload.begin(), payload.end(), data) - data);
+        });
+        assert(buffer.Size() == payload.size());
+        assert(std::string_view(buffer.Data(), buffer.Size()) == payload);
+
+        buffer.ResizeAndOverwrite(3, [](char* data, size_t count) {
+            data[2] = '!';
+            return count;
+        });
+        assert(std::string_view(buffer.Data(), buffer.Size()) == "pa!");
+    }
+    {
+        Obj::ResetCounters();
+        Vector<Obj> v(SIZE);
+        try {
+            v.ResizeAndOverwrite(SIZE * 2, [](Obj* /*data*/, size_t /*count*/) -> size_t {
+                throw std::runtime_error("Oops");
+            });
+            assert(false && "Exception is expected");
+        } catch (const std::runtime_error&) {
         }
-        Dump();
-    } catch (...) {
+        assert(v.Size() == SIZE);
+        assert(Obj::GetAliveObjectCount() == SIZE);
+
+        v.ResizeAndOverwrite(SIZE * 2, [](Obj* data, size_t count) {
+            data[count - 1].id = 42;
+            return count - 1;
+        });
+        assert(v.Size() == SIZE * 2 - 1);
+        assert(Obj::GetAliveObjectCount() == SIZE * 2 - 1);
     }
 }
 
+void Test15() {
+    const size_t SIZE = 100;
+    {
+        Obj::ResetCounters();
+        Vector<Obj> v(SIZE);
+        v.Reserve(SIZE * 4);
+        v.Resize(SIZE / 2);
+        v.ShrinkToFit();
+        assert(v.Size() == SIZE / 2 && v.Capacity() == SIZE / 2);
+        assert(Obj::GetAliveObjectCount() == SIZE / 2);
+
+        v.Clear();
+        assert(v.Size() == 0 && v.Capacity() == SIZE / 2);
+        assert(Obj::GetAliveObjectCount() == 0);
+
+        v.Resize(SIZE);
+        v.ReleaseMemory();
+        assert(v.Size() == 0 && v.Capacity() == 0);
+        assert(Obj::GetAliveObjectCount() == 0);
+    }
+    {
+        CountingResource resource;
+        Vector<int, std::pmr::polymorphic_allocator<int>> v(SIZE, &resource);
+        v.Resize(1);
+        v.ShrinkToFit();
+        assert(v.Capacity() == 1 && resource.bytes_in_use == sizeof(int));
+        v.ReleaseMemory();
+        assert(resource.bytes_in_use == 0);
+    }
+    {
+        // Уменьшение на месте через realloc
+        Vector<int, MallocAllocator<int>> v(SIZE);
+        v[SIZE / 2 - 1] = 42;
+        v.Resize(SIZE / 2);
+        v.ShrinkToFit();
+        assert(v.Capacity() == SIZE / 2 && v.Back() == 42);
+        v.Clear();
+        v.ShrinkToFit();
+        assert(v.Capacity() == 0);
+    }
+    {
+        Obj::ResetCounters();
+        Vector<Obj> v(SIZE);
+        v.Reserve(SIZE * 2);
+        v[SIZE - 1].throw_on_copy = true;
+        // Obj перемещается без исключений, поэтому ShrinkToFit не копирует элементы
+        v.ShrinkToFit();
+        assert(v.Capacity() == SIZE && Obj::num_copied == 0);
+    }
+    {
+        SmallVector<std::string, 4> v{"a", "b", "c", "d", "e", "f"};
+        v.Resize(5);
+        v.ShrinkToFit();
+        assert(!v.IsInline() && v.Capacity() == 5);
+        v.Resize(3);
+        v.ShrinkToFit();
+        assert(v.IsInline() && v.Capacity() == 4);
+        assert(v[0] == "a" && v[2] == "c");
+    }
+}
+
+void Test16() {
+    using Ints = Vector<int, std::allocator<int>, DoublingGrowth, NamedStats<"test16.ints">>;
+    {
+        NamedStats<"test16.ints">::Reset();
+        {
+            Ints v;
+            for (int i = 0; i < 100; ++i) {
+                v.PushBack(i);
+            }
+            // Ёмкости 1, 2, 4, ..., 128: восемь буферов, перенесено 1 + 2 + ... + 64 элементов
+            const VectorStats stats = NamedStats<"test16.ints">::Snapshot();
+            assert(stats.reallocations == 8 && stats.growth_events == 8);
+            assert(stats.allocations == 8 && stats.bytes_allocated == 255 * sizeof(int));
+            assert(stats.bytes_freed == 127 * sizeof(int));
+            assert(stats.elements_relocated == 127 && stats.elements_copied == 0);
+            assert(stats.peak_capacity == 128);
+
+            // Явные Reserve и ShrinkToFit - смены буфера, но не рост
+            v.Reserve(1000);
+            v.ShrinkToFit();
+            const VectorStats after = NamedStats<"test16.ints">::Snapshot();
+            assert(after.reallocations == 10 && after.growth_events == 8);
+            assert(after.elements_relocated == 327 && after.peak_capacity == 1000);
+        }
+        const VectorStats stats = NamedStats<"test16.ints">::Snapshot();
+        assert(stats.bytes_freed == stats.bytes_allocated);
+    }
+    {
+        // Конструктор перемещения может бросить, поэтому при росте элементы копируются
+        struct MayThrowOnMove {
+            MayThrowOnMove() = default;
+            MayThrowOnMove(const MayThrowOnMove&) = default;
+            MayThrowOnMove(MayThrowOnMove&&) noexcept(false) {
+            }
+            MayThrowOnMove& operator=(const MayThrowOnMove&) = default;
+            MayThrowOnMove& operator=(MayThrowOnMove&&) = default;
+        };
+        using Stats = NamedStats<"test16.copied">;
+        Stats::Reset();
+        Vector<MayThrowOnMove, std::allocator<MayThrowOnMove>, DoublingGrowth, Stats> v(4);
+        v.EmplaceBack();
+        v.Resize(20);
+        const VectorStats stats = Stats::Snapshot();
+        assert(stats.growth_events == 2 && stats.elements_copied == 4 + 5 && stats.elements_relocated == 0);
+    }
+    {
+        // Рост на месте через realloc тоже виден статистике
+        using Stats = NamedStats<"test16.malloc">;
+        Stats::Reset();
+        Vector<int, MallocAllocator<int>, DoublingGrowth, Stats> v;
+        v.Resize(10);
+        v.Resize(30);
+        const VectorStats stats = Stats::Snapshot();
+        assert(stats.growth_events == 2 && stats.elements_relocated == 10 && stats.peak_capacity == 30);
+    }
+    {
+        const std::vector<NamedVectorStats> all = StatsRegistry::Instance().Snapshot();
+        const auto it = std::find_if(all.begin(), all.end(), [](const NamedVectorStats& entry) {
+            return entry.name == "test16.ints";
+        });
+        assert(it != all.end() && it->stats.reallocations == 10);
+
+        std::ostringstream out;
+        StatsRegistry::Instance().Write(out);
+        assert(out.str().find("vector_growth_events{site=\"test16.ints\"} 8\n") != std::string::npos);
+    }
+}
+
+// Сверяет векторизованные алгоритмы со стандартными на срезах разной длины и с разными смещениями от границы буфера
+template <typename T>
+void CheckSimdAlgorithms() {
+    const size_t CAPACITY = 300;
+    Vector<T, CacheAlignedAllocator<T>> buffer(CAPACITY);
+    for (size_t i = 0; i < CAPACITY; ++i) {
+        buffer[i] = static_cast<T>(std::is_signed_v<T> ? static_cast<int>(i * 37 % 101) - 50 : static_cast<int>(i * 37 % 101));
+    }
+
+    for (size_t offset = 0; offset < 8; ++offset) {
+        for (size_t size = 0; offset + size <= CAPACITY; size += (size < 70 ? 1 : 23)) {
+            T* first = buffer.Data() + offset;
+            T* last = first + size;
+
+            const T present = size > 0 ? first[size * 2 / 3] : T{};
+            assert(simd::Find(first, last, present) == std::find(first, last, present));
+            assert(simd::Find(first, last, static_cast<T>(99)) == std::find(first, last, static_cast<T>(99)));
+            assert(simd::Count(first, last, present) == static_cast<size_t>(std::count(first, last, present)));
+
+            simd::SumResult<T> expected_sum{};
+            if constexpr (std::integral<T>) {
+                for (const T* it = first; it != last; ++it) {
+                    expected_sum += *it;
+                }
+            } else {
+                expected_sum = std::accumulate(first, last, T{});
+            }
+            // В примере все суммы целые и малы, поэтому точны и для вещественных типов
+            assert(simd::Sum(first, last) == expected_sum);
+
+            if (size > 0) {
+                assert(simd::Min(first, last) == *std::min_element(first, last));
+                assert(simd::Max(first, last) == *std::max_element(first, last));
+            }
+
+            std::vector<T> copy(first, last);
+            assert(simd::Equal(first, last, copy.data()));
+            if (size > 0) {
+                copy[size / 2] += 1;
+                assert(!simd::Equal(first, last, copy.data()));
+            }
+        }
+    }
+
+    // Fill не выходит за границы среза
+    for (size_t offset = 0; offset < 8; ++offset) {
+        Vector<T, CacheAlignedAllocator<T>> v(CAPACITY, static_cast<T>(1));
+        simd::Fill(v.Data() + offset, v.Data() + v.Size() - offset, static_cast<T>(7));
+        for (size_t i = 0; i < CAPACITY; ++i) {
+            assert(v[i] == static_cast<T>(offset <= i && i < CAPACITY - offset ? 7 : 1));
+        }
+    }
+}
+
+void Test17() {
+    const auto is_aligned = [](const void* ptr, size_t alignment) {
+        return reinterpret_cast<uintptr_t>(ptr) % alignment == 0;
+    };
+    {
+        // Сверхвыровненный тип: std::allocator использует выровненный operator new
+        struct alignas(128) Wide {
+            int value = 0;
+        };
+        Vector<Wide> v(3);
+        for (int i = 0; i < 10; ++i) {
+            v.EmplaceBack(Wide{i});
+            assert(is_aligned(v.Data(), 128));
+        }
+        assert(v.Back().value == 9);
+    }
+    {
+        Vector<float, CacheAlignedAllocator<float>> v;
+        for (int i = 0; i < 100; ++i) {
+            v.PushBack(static_cast<float>(i));
+            assert(is_aligned(v.Data(), 64));
+        }
+        v.ShrinkToFit();
+        assert(is_aligned(v.Data(), 64) && v[99] == 99.0f);
+
+        // Копия получает аллокатор с тем же выравниванием
+        Vector<float, CacheAlignedAllocator<float>> copy(v);
+        assert(is_aligned(copy.Data(), 64) && copy.Size() == 100);
+    }
+    {
+        using Allocator = HugePageAllocator<double>;
+        const size_t big = Allocator::HUGE_PAGE_SIZE / sizeof(double) * 2;
+
+        Vector<double, Allocator> v(big);
+        v[big - 1] = 42.0;
+#ifdef __linux__
+        assert(is_aligned(v.Data(), Allocator::HUGE_PAGE_SIZE));
+#endif
+        v.Resize(big + 1);
+        assert(v[big - 1] == 42.0 && v[big] == 0.0);
+
+        // Маленький буфер снова выделяется через operator new
+        v.Resize(10);
+        v.ShrinkToFit();
+        assert(v.Capacity() == 10 && is_aligned(v.Data(), Allocator::ALIGNMENT));
+    }
+}
+
+void Test18() {
+    for (simd::Level level : {simd::Level::SCALAR, simd::Level::VECTOR128, simd::Level::AVX2, simd::Level::AVX512}) {
+        simd::SetLevel(level);
+        assert(simd::ActiveLevel() <= level);
+        CheckSimdAlgorithms<int8_t>();
+        CheckSimdAlgorithms<uint8_t>();
+        CheckSimdAlgorithms<int16_t>();
+        CheckSimdAlgorithms<int32_t>();
+        CheckSimdAlgorithms<uint32_t>();
+        CheckSimdAlgorithms<int64_t>();
+        CheckSimdAlgorithms<float>();
+        CheckSimdAlgorithms<double>();
+    }
+    simd::SetLevel(simd::DetectLevel());
+    {
+        // Алгоритмы для контейнера целиком
+        Vector<float> v(1000);
+        simd::Fill(v, 0.5f);
+        v[731] = -3.0f;
+        assert(simd::Sum(v) == 999 * 0.5f - 3.0f);
+        assert(simd::Count(v, 0.5f) == 999 && simd::Find(v, -3.0f) == v.Data() + 731);
+        assert(simd::Min(v) == -3.0f && simd::Max(v) == 0.5f);
+
+        Vector<float> other(v);
+        assert(simd::Equal(v, other));
+        other.PopBack();
+        assert(!simd::Equal(v, other));
+
+        // Суммы целых не переполняются в 64 битах
+        Vector<int32_t> big(1000, std::numeric_limits<int32_t>::max());
+        assert(simd::Sum(big) == int64_t{1000} * std::numeric_limits<int32_t>::max());
+    }
+    {
+        // Невекторизуемые типы обрабатываются стандартными алгоритмами
+        Vector<std::string> v{"a", "b", "a"};
+        assert(simd::Count(v, "a") == 2 && simd::Find(v, "b") == v.Data() + 1);
+        simd::Fill(v, "c");
+        assert(simd::Count(v, "c") == 3);
+    }
+}
+
+void Test19() {
+    const size_t SIZE = 100;
+    {
+        SoAVector<int, std::string, double> v;
+        for (size_t i = 0; i < SIZE; ++i) {
+            v.EmplaceBack(static_cast<int>(i), std::to_string(i), i * 0.5);
+        }
+        assert(v.Size() == SIZE && v.Capacity() >= SIZE);
+
+        // Прокси-ссылка позволяет менять поля записи
+        auto [id, name, weight] = v[10];
+        assert(id == 10 && name == "10" && weight == 5.0);
+        id = -10;
+        name += "!";
+        assert(std::get<0>(v[10]) == -10 && std::get<1>(v[10]) == "10!");
+
+        // Столбцы непрерывны и сканируются по отдельности
+        const std::span<const double> weights = std::as_const(v).Column<2>();
+        assert(weights.size() == SIZE && std::accumulate(weights.begin(), weights.end(), 0.0) == 0.5 * SIZE * (SIZE - 1) / 2);
+        const auto it = std::find_if(v.begin(), v.end(), [](const auto& record) {
+            return std::get<1>(record) == "42";
+        });
+        assert(it - v.begin() == 42);
+
+        v.Erase(v.begin() + 10);
+        assert(v.Size() == SIZE - 1 && std::get<0>(v[10]) == 11 && std::get<1>(v[10]) == "11");
+        v.Erase(v.begin(), v.begin() + 9);
+        assert(v.Size() == SIZE - 10 && std::get<0>(v.Front()) == 9 && std::get<2>(v.Back()) == (SIZE - 1) * 0.5);
+
+        // У копии ёмкость равна размеру, поэтому вставка растит её, а аргументы ссылаются на старые элементы
+        SoAVector<int, std::string, double> copy(v);
+        assert(copy.Size() == copy.Capacity());
+        copy.EmplaceBack(std::get<0>(copy[0]), std::get<1>(copy[0]), std::get<2>(copy[0]));
+        assert(copy.Size() == v.Size() + 1 && copy.Back() == copy.Front());
+        copy = v;
+        assert(copy.Size() == v.Size() && std::get<1>(copy[20]) == std::get<1>(v[20]));
+
+        SoAVector<int, std::string, double> moved(std::move(copy));
+        assert(moved.Size() == v.Size() && copy.Size() == 0);
+        moved.Clear();
+        assert(moved.Size() == 0 && moved.Capacity() > 0);
+    }
+    {
+        // Поле, которое при росте копируется и может бросить исключение
+        struct Fragile {
+            explicit Fragile(int* copies_left)
+                : copies_left(copies_left) {
+            }
+            Fragile(const Fragile& other)
+                : copies_left(other.copies_left) {
+                if ((*copies_left)-- == 0) {
+                    throw std::runtime_error("Oops");
+                }
+            }
+            Fragile(Fragile&& other) noexcept(false)
+                : copies_left(other.copies_left) {
+            }
+            Fragile& operator=(const Fragile&) = default;
+            Fragile& operator=(Fragile&&) = default;
+
+            int* copies_left;
+        };
+
+        Obj::ResetCounters();
+        int copies_left = std::numeric_limits<int>::max();
+        {
+            SoAVector<Obj, Fragile> v;
+            while (v.Size() < SIZE || v.Size() < v.Capacity()) {
+                v.EmplaceBack(static_cast<int>(v.Size()), &copies_left);
+            }
+            const size_t size = v.Size();
+            const int moved = Obj::num_moved;
+
+            // Столбец Fragile копируется раньше, чем переносятся остальные, поэтому при исключении вектор не меняется
+            copies_left = static_cast<int>(size / 2);
+            try {
+                v.Reserve(size * 2);
+                assert(false && "Exception is expected");
+            } catch (const std::runtime_error&) {
+            }
+            copies_left = static_cast<int>(size / 2);
+            try {
+                v.EmplaceBack(-1, &copies_left);
+                assert(false && "Exception is expected");
+            } catch (const std::runtime_error&) {
+            }
+            assert(v.Size() == size && v.Capacity() == size && Obj::num_moved == moved);
+            assert(Obj::GetAliveObjectCount() == static_cast<int>(size));
+            for (size_t i = 0; i < size; ++i) {
+                assert(std::get<0>(v[i]).id == static_cast<int>(i));
+            }
+
+            copies_left = std::numeric_limits<int>::max();
+            v.EmplaceBack(-1, &copies_left);
+            assert(v.Size() == size + 1 && std::get<0>(v.Back()).id == -1);
+        }
+        assert(Obj::GetAliveObjectCount() == 0);
+    }
+    {
+        // Поле, присваивание которого может бросить исключение, во втором столбце: к этому моменту
+        // первый столбец уже сдвинут, но его хвост ещё не разрушен
+        struct FragileAssign {
+            explicit FragileAssign(int* assignments_left)
+                : assignments_left(assignments_left) {
+            }
+            FragileAssign(const FragileAssign&) = default;
+            FragileAssign& operator=(const FragileAssign& other) {
+                if ((*assignments_left)-- == 0) {
+                    throw std::runtime_error("Oops");
+                }
+                assignments_left = other.assignments_left;
+                return *this;
+            }
+
+            int* assignments_left;
+        };
+
+        Obj::ResetCounters();
+        int assignments_left = std::numeric_limits<int>::max();
+        {
+            SoAVector<Obj, FragileAssign> v;
+            for (int i = 0; i < 10; ++i) {
+                v.EmplaceBack(i, &assignments_left);
+            }
+
+            assignments_left = 3;
+            try {
+                v.Erase(v.begin() + 2, v.begin() + 4);
+                assert(false && "Exception is expected");
+            } catch (const std::runtime_error&) {
+            }
+            assert(v.Size() == 10 && Obj::GetAliveObjectCount() == 10);
+
+            assignments_left = std::numeric_limits<int>::max();
+            v.Erase(v.begin(), v.begin() + 5);
+            assert(v.Size() == 5 && Obj::GetAliveObjectCount() == 5);
+            assert(std::get<0>(v.Back()).id == 9);
+        }
+        assert(Obj::GetAliveObjectCount() == 0);
+    }
+}
+
+void Test20() {
+    struct Record {
+        int64_t id;
+        double value;
+    };
+    const size_t SIZE = 10000;
+    const std::filesystem::path path = std::filesystem::temp_directory_path() / "advanced_vector_test20.bin";
+    std::filesystem::remove(path);
+    {
+        MappedVector<Record> v(path);
+        assert(v.Size() == 0 && v.Capacity() == 0);
+        for (size_t i = 0; i < SIZE; ++i) {
+            v.PushBack({static_cast<int64_t>(i), i * 0.5});
+        }
+        assert(v.Size() == SIZE && v.Capacity() >= SIZE);
+        // Аргумент ссылается на элемент, который при росте переезжает вместе с отображением
+        while (v.Size() < v.Capacity()) {
+            v.PushBack(v.Back());
+        }
+        v.EmplaceBack(v.Front());
+        assert(v.Back().id == 0);
+        v.Resize(SIZE);
+        v.Sync();
+    }
+    {
+        // Повторное открытие не копирует элементы: они читаются прямо из страниц файла
+        const MappedVector<Record> v(path, MappedMode::READ_ONLY);
+        assert(v.IsReadOnly() && v.Size() == SIZE);
+        {
+            MappedVector<Record> reader(path, MappedMode::READ_ONLY);
+            try {
+                reader.PushBack({-1, -1.0});
+                assert(false && "Exception is expected");
+            } catch (const std::logic_error&) {
+            }
+            try {
+                reader.Clear();
+                assert(false && "Exception is expected");
+            } catch (const std::logic_error&) {
+            }
+            assert(reader.Size() == SIZE);
+        }
+        for (size_t i = 0; i < SIZE; ++i) {
+            assert(v[i].id == static_cast<int64_t>(i) && v[i].value == i * 0.5);
+        }
+
+        MappedVector<Record> writer(path);
+        writer.PushBack({-1, -1.0});
+        // Оба отображения разделяемые, поэтому запись сразу видна читателю
+        assert(v.Size() == SIZE + 1 && v.Back().id == -1);
+        writer.PopBack();
+        assert(v.Size() == SIZE);
+
+        // Писатель удлинил файл, но отображение читателя осталось прежним: размер ограничен его ёмкостью
+        const size_t reader_capacity = v.Capacity();
+        while (writer.Size() <= reader_capacity) {
+            writer.PushBack({-2, -2.0});
+        }
+        assert(v.Size() == reader_capacity && v.Capacity() == reader_capacity);
+        writer.Resize(SIZE);
+        assert(v.Size() == SIZE);
+    }
+    {
+        MappedVector<Record> v(path);
+        MappedVector<Record> moved(std::move(v));
+        assert(moved.Size() == SIZE && v.Size() == 0);
+        moved.Clear();
+        moved.Resize(3);
+        assert(moved.Size() == 3 && moved[2].id == 0);
+    }
+    try {
+        // Размер элемента записан в заголовке, и файл другого типа не откроется
+        MappedVector<int> v(path, MappedMode::READ_ONLY);
+        assert(false && "Exception is expected");
+    } catch (const std::runtime_error&) {
+    }
+    std::filesystem::remove(path);
+    try {
+        MappedVector<Record> v(path, MappedMode::READ_ONLY);
+        assert(false && "Exception is expected");
+    } catch (const std::system_error& e) {
+        assert(e.code() == std::errc::no_such_file_or_directory);
+    }
+}
+
+void Test21() {
+    struct Record {
+        int64_t id;
+        double value;
+    };
+    const size_t SIZE = 10000;
+    Vector<Record> v;
+    for (size_t i = 0; i < SIZE; ++i) {
+        v.PushBack({static_cast<int64_t>(i), i * 0.25});
+    }
+    const auto same = [&v](const auto& other) {
+        return other.size() == v.Size() && std::equal(v.begin(), v.end(), other.begin(), [](const Record& lhs, const Record& rhs) {
+            return lhs.id == rhs.id && lhs.value == rhs.value;
+        });
+    };
+    {
+        const std::filesystem::path path = std::filesystem::temp_directory_path() / "advanced_vector_test21.bin";
+        const int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        assert(fd >= 0);
+        WriteVector(fd, v);
+        assert(static_cast<size_t>(::lseek(fd, 0, SEEK_CUR)) == SerializedSize(v));
+
+        // Чтение переиспользует ёмкость и заменяет старое содержимое
+        Vector<Record> loaded(SIZE * 2);
+        ::lseek(fd, 0, SEEK_SET);
+        ReadVector(fd, loaded);
+        assert(loaded.Capacity() == SIZE * 2 && same(std::span<const Record>(loaded.begin(), loaded.Size())));
+
+        // Оборванный файл не читается, а вектор остаётся пустым
+        assert(::ftruncate(fd, static_cast<off_t>(SerializedSize(v) - 1)) == 0);
+        ::lseek(fd, 0, SEEK_SET);
+        try {
+            ReadVector(fd, loaded);
+            assert(false && "Exception is expected");
+        } catch (const SerializationError&) {
+        }
+        assert(loaded.Size() == 0);
+
+        // Число элементов сверяется с длиной файла до выделения памяти
+        std::byte forged[SERIALIZED_HEADER_BYTES];
+        ::lseek(fd, 0, SEEK_SET);
+        assert(::read(fd, forged, sizeof(forged)) == static_cast<ssize_t>(sizeof(forged)));
+        const uint64_t huge_count = std::numeric_limits<size_t>::max() / sizeof(Record);
+        std::memcpy(forged + offsetof(SerializedVectorHeader, count), &huge_count, sizeof(huge_count));
+        ::lseek(fd, 0, SEEK_SET);
+        assert(::write(fd, forged, sizeof(forged)) == static_cast<ssize_t>(sizeof(forged)));
+        ::lseek(fd, 0, SEEK_SET);
+        try {
+            ReadVector(fd, loaded);
+            assert(false && "Exception is expected");
+        } catch (const SerializationError&) {
+        }
+        assert(loaded.Size() == 0);
+
+        // Из канала длина неизвестна, и элементы читаются порциями
+        int pipe_fds[2];
+        assert(::pipe(pipe_fds) == 0);
+        std::thread writer([&forged, fd = pipe_fds[1]] {
+            assert(::write(fd, forged, sizeof(forged)) == static_cast<ssize_t>(sizeof(forged)));
+            const std::vector<std::byte> payload(SERIALIZED_READ_CHUNK_BYTES * 3);
+            assert(::write(fd, payload.data(), payload.size()) == static_cast<ssize_t>(payload.size()));
+            ::close(fd);
+        });
+        try {
+            ReadVector(pipe_fds[0], loaded);
+            assert(false && "Exception is expected");
+        } catch (const SerializationError&) {
+        }
+        writer.join();
+        ::close(pipe_fds[0]);
+        assert(loaded.Size() == 0);
+
+        assert(::pipe(pipe_fds) == 0);
+        std::thread small_writer([&v, fd = pipe_fds[1]] {
+            WriteVector(fd, v);
+            ::close(fd);
+        });
+        ReadVector(pipe_fds[0], loaded);
+        small_writer.join();
+        ::close(pipe_fds[0]);
+        assert(same(std::span<const Record>(loaded.begin(), loaded.Size())));
+
+        ::close(fd);
+        std::filesystem::remove(path);
+    }
+    {
+        std::stringstream stream;
+        WriteVector(stream, v);
+        WriteVector(stream, Vector<Record>());
+        const std::string bytes = stream.str();
+        assert(bytes.size() == SerializedSize(v) + SERIALIZED_HEADER_BYTES);
+
+        Vector<Record> loaded;
+        ReadVector(stream, loaded);
+        assert(same(std::span<const Record>(loaded.begin(), loaded.Size())));
+        ReadVector(stream, loaded);
+        assert(loaded.Size() == 0);
+
+        // Испорченный заголовок с огромным числом элементов не заставляет выделить под них память заранее
+        std::string forged = bytes.substr(0, SERIALIZED_HEADER_BYTES);
+        const uint64_t huge_count = std::numeric_limits<size_t>::max() / sizeof(Record);
+        std::memcpy(forged.data() + offsetof(SerializedVectorHeader, count), &huge_count, sizeof(huge_count));
+        std::stringstream forged_stream(forged + bytes.substr(SERIALIZED_HEADER_BYTES, SerializedSize(v) - SERIALIZED_HEADER_BYTES));
+        try {
+            ReadVector(forged_stream, loaded);
+            assert(false && "Exception is expected");
+        } catch (const SerializationError&) {
+        }
+        assert(loaded.Size() == 0);
+
+        // Буфер в памяти читается без копирования
+        Vector<std::byte, CacheAlignedAllocator<std::byte>> buffer(bytes.size());
+        std::memcpy(buffer.Data(), bytes.data(), bytes.size());
+        const std::span<const std::byte> view_bytes(buffer.begin(), buffer.Size());
+        const std::span<const Record> view = ViewSerializedVector<Record>(view_bytes);
+        assert(static_cast<const void*>(view.data()) == buffer.Data() + SERIALIZED_HEADER_BYTES && same(view));
+
+        // Заголовок хранит размер элемента, поэтому другой тип не прочитается
+        try {
+            ViewSerializedVector<int>(view_bytes);
+            assert(false && "Exception is expected");
+        } catch (const SerializationError&) {
+        }
+        try {
+            ViewSerializedVector<Record>(view_bytes.first(SerializedSize(v) - 1));
+            assert(false && "Exception is expected");
+        } catch (const SerializationError&) {
+        }
+    }
+}
+
+void Test22() {
+    const size_t SIZE = 100;
+    {
+        // Буфер из malloc освобождается своим deleter, когда вектор вырастает из него
+        int frees = 0;
+        const auto free_buffer = [&frees](int* buffer, size_t /*capacity*/) {
+            ++frees;
+            std::free(buffer);
+        };
+        int* buffer = static_cast<int*>(std::malloc(SIZE * sizeof(int)));
+        std::iota(buffer, buffer + SIZE / 2, 0);
+
+        Vector<int> v;
+        v.Adopt(buffer, SIZE / 2, SIZE, free_buffer);
+        assert(v.Data() == buffer && v.Size() == SIZE / 2 && v.Capacity() == SIZE);
+        v.Resize(SIZE);
+        assert(frees == 0 && v.Data() == buffer);
+        v.PushBack(42);
+        assert(frees == 1 && v.Size() == SIZE + 1 && v[SIZE / 2 - 1] == SIZE / 2 - 1 && v.Back() == 42);
+
+        // Аллокатор с realloc тоже не трогает чужой буфер
+        Vector<int, MallocAllocator<int>> m;
+        m.Adopt(static_cast<int*>(std::malloc(SIZE * sizeof(int))), SIZE, SIZE, free_buffer);
+        m[SIZE - 1] = 7;
+        m.PushBack(8);
+        assert(frees == 2 && m[SIZE - 1] == 7 && m.Back() == 8);
+    }
+    {
+        // Буфер переходит из вектора в вектор вместе с элементами и способом освобождения
+        CountingResource resource;
+        Vector<std::string, std::pmr::polymorphic_allocator<std::string>> v(&resource);
+        for (size_t i = 0; i < SIZE; ++i) {
+            v.EmplaceBack(std::string(32, 'a' + i % 26));
+        }
+        const std::string* data = v.Data();
+
+        ReleasedBuffer<std::string> released = v.Release();
+        assert(v.Size() == 0 && v.Capacity() == 0 && released.data == data && released.size == SIZE);
+        assert(resource.bytes_in_use > 0);
+
+        Vector<std::string> other;
+        other.Adopt(released.data, released.size, released.capacity, std::move(released.deleter));
+        assert(other.Data() == data && other.Size() == SIZE && other[25] == std::string(32, 'z'));
+
+        released = other.Release();
+        std::destroy_n(released.data, released.size);
+        released.deleter(released.data, released.capacity);
+        assert(resource.bytes_in_use == 0);
+    }
+    {
+        // Без deleter буфер освобождает аллокатор вектора; прежние элементы разрушаются
+        Obj::ResetCounters();
+        Vector<Obj> v(SIZE);
+        Obj* buffer = std::allocator<Obj>().allocate(SIZE);
+        std::uninitialized_value_construct_n(buffer, SIZE / 2);
+        v.Adopt(buffer, SIZE / 2, SIZE);
+        assert(Obj::GetAliveObjectCount() == SIZE / 2 && v.Capacity() == SIZE);
+        v.ReleaseMemory();
+        assert(Obj::GetAliveObjectCount() == 0);
+
+        Vector<Obj> empty;
+        ReleasedBuffer<Obj> released = empty.Release();
+        assert(released.data == nullptr && !released.deleter);
+    }
+}
+
+void Test23() {
+    const size_t SIZE = 200000;
+    {
+        ThreadExecutor pool(4);
+        const Vector<std::string> v(Parallel(pool), SIZE, std::string(40, 'x'));
+        assert(v.Size() == SIZE && std::all_of(v.begin(), v.end(), [](const std::string& s) {
+            return s == std::string(40, 'x');
+        }));
+
+        Vector<std::string> copy(Parallel(pool), v);
+        assert(copy.Size() == SIZE && copy[SIZE - 1] == v[SIZE - 1]);
+
+        Vector<std::string> target(Parallel(pool), SIZE / 2);
+        target.Assign(Parallel(pool), copy);
+        assert(target.Size() == SIZE && target.Capacity() == SIZE && target[SIZE / 2] == v[SIZE / 2]);
+
+        target.ReleaseMemory(Parallel(pool));
+        assert(target.Size() == 0 && target.Capacity() == 0);
+        copy.Clear(Parallel(pool));
+        assert(copy.Size() == 0 && copy.Capacity() == SIZE);
+
+        const Vector<int> ints(Parallel(pool), SIZE);
+        assert(std::count(ints.begin(), ints.end(), 0) == SIZE);
+    }
+    {
+        // Последовательный исполнитель делает поведение кусков детерминированным
+        InlineExecutor executor;
+
+        // Исключение в одном куске разрушает и все уже созданные куски
+        Obj::ResetCounters();
+        Obj::default_construction_throw_countdown = SIZE / 3 * 2;
+        try {
+            Vector<Obj> v(Parallel(executor), SIZE);
+            assert(false && "Exception is expected");
+        } catch (const std::runtime_error&) {
+        }
+        assert(Obj::GetAliveObjectCount() == 0);
+
+        Obj::ResetCounters();
+        Vector<Obj> source(SIZE);
+        source[SIZE / 3].throw_on_copy = true;
+        Vector<Obj> target(Parallel(executor), SIZE / 2);
+        target[0].id = 42;
+        try {
+            target.Assign(Parallel(executor), source);
+            assert(false && "Exception is expected");
+        } catch (const std::runtime_error&) {
+        }
+        // Строгая гарантия: прежнее содержимое не тронуто
+        assert(target.Size() == SIZE / 2 && target[0].id == 42);
+        assert(Obj::GetAliveObjectCount() == SIZE + SIZE / 2);
+    }
+}
+
+void Test24() {
+    {
+        const size_t THREADS = 4;
+        const size_t PER_THREAD = 20000;
+        ConcurrentVector<std::pair<size_t, size_t>> v;
+        const std::pair<size_t, size_t>* first = &v.EmplaceBack(THREADS, 0);
+
+        std::vector<std::thread> producers;
+        for (size_t t = 0; t < THREADS; ++t) {
+            producers.emplace_back([&v, t] {
+                for (size_t i = 0; i < PER_THREAD; ++i) {
+                    v.EmplaceBack(t, i);
+                }
+            });
+        }
+        // Читатель видит только созданные элементы
+        std::thread reader([&v] {
+            for (size_t round = 0; round < 1000; ++round) {
+                const size_t size = v.Size();
+                for (size_t i = size > 64 ? size - 64 : 0; i < size; ++i) {
+                    if (v.IsReady(i)) {
+                        assert(v[i].first <= THREADS);
+                    }
+                }
+            }
+        });
+        for (std::thread& producer : producers) {
+            producer.join();
+        }
+        reader.join();
+
+        // Сегменты не переезжают
+        assert(&v[0] == first);
+        assert(v.Size() == THREADS * PER_THREAD + 1);
+
+        // Элементы каждого производителя идут в порядке их добавления
+        std::vector<size_t> next(THREADS + 1, 0);
+        for (size_t i = 1; i < v.Size(); ++i) {
+            assert(v.IsReady(i));
+            assert(v[i].second == next[v[i].first]++);
+        }
+
+        const Vector<std::pair<size_t, size_t>> frozen = v.Freeze();
+        assert(frozen.Size() == THREADS * PER_THREAD + 1 && frozen[0].first == THREADS);
+        assert(v.Size() == 0 && !v.IsReady(0));
+        v.PushBack({1, 2});
+        assert(&v[0] == first);
+    }
+    {
+        // Брошенный конструктором элемент оставляет пустую ячейку, которую пропускают Freeze и деструктор
+        Obj::ResetCounters();
+        {
+            ConcurrentVector<Obj> v;
+            for (int i = 0; i < 100; ++i) {
+                v.EmplaceBack(i);
+            }
+            Obj::default_construction_throw_countdown = 1;
+            try {
+                v.EmplaceBack();
+                assert(false && "Exception is expected");
+            } catch (const std::runtime_error&) {
+            }
+            v.EmplaceBack(100);
+            assert(v.Size() == 102 && !v.IsReady(100) && v.IsReady(101));
+            assert(Obj::GetAliveObjectCount() == 101);
+
+            const Vector<Obj> frozen = v.Freeze();
+            assert(frozen.Size() == 101 && frozen[100].id == 100);
+            assert(Obj::GetAliveObjectCount() == 101);
+        }
+        assert(Obj::GetAliveObjectCount() == 0);
+    }
+}
+
+void Test25() {
+    {
+        SegmentedVector<int, std::allocator<int>, 16> v;
+        static_assert(std::random_access_iterator<SegmentedVector<int>::iterator>);
+        v.PushBack(0);
+        const int* first = &v[0];
+        const auto it = v.begin();
+        for (int i = 1; i < 100; ++i) {
+            v.PushBack(i);
+        }
+        // Рост не переносит элементы и не портит итераторы
+        assert(&v[0] == first && *it == 0);
+        assert(v.Size() == 100 && v.Capacity() == 112 && v.ChunkCount() == 7);
+        assert(v.Chunk(0).size() == 16 && v.Chunk(6).size() == 4 && v.Chunk(6)[3] == 99);
+        assert(&v[17] == &v.Chunk(1)[1]);
+
+        // Аргумент может ссылаться на элемент самого вектора
+        for (int i = 0; i < 12; ++i) {
+            v.EmplaceBack(v[0]);
+        }
+        assert(v.Size() == 112 && v.Back() == 0);
+        v.EmplaceBack(v[5]);
+        assert(v.Back() == 5 && v.ChunkCount() == 8);
+
+        size_t total = 0;
+        v.ForEachChunk([&total](std::span<int> chunk) {
+            total += chunk.size();
+        });
+        assert(total == v.Size());
+        assert(std::accumulate(v.begin(), v.begin() + 100, 0) == 4950);
+
+        SegmentedVector<int, std::allocator<int>, 16> copy(v);
+        assert(std::equal(copy.begin(), copy.end(), v.begin(), v.end()));
+        copy.Resize(10);
+        copy.ShrinkToFit();
+        assert(copy.Size() == 10 && copy.Capacity() == 16);
+        v = std::move(copy);
+        assert(v.Size() == 10 && v[9] == 9);
+    }
+    {
+        Obj::ResetCounters();
+        {
+            SegmentedVector<Obj, std::allocator<Obj>, 8> v(20);
+            assert(Obj::num_default_constructed == 20);
+            v[3].throw_on_copy = true;
+            try {
+                SegmentedVector<Obj, std::allocator<Obj>, 8> copy(v);
+                assert(false && "Exception is expected");
+            } catch (const std::runtime_error&) {
+            }
+            assert(Obj::GetAliveObjectCount() == 20);
+
+            v[3].throw_on_copy = false;
+            Obj::default_construction_throw_countdown = 1;
+            try {
+                v.EmplaceBack();
+                assert(false && "Exception is expected");
+            } catch (const std::runtime_error&) {
+            }
+            assert(v.Size() == 20 && Obj::GetAliveObjectCount() == 20);
+            v.Clear();
+            assert(Obj::GetAliveObjectCount() == 0 && v.Capacity() == 24);
+        }
+        assert(Obj::GetAliveObjectCount() == 0);
+    }
+    {
+        // polymorphic_allocator не распространяется при присваивании: вектор сохраняет свой ресурс
+        using PmrSegmented = SegmentedVector<int, std::pmr::polymorphic_allocator<int>, 16>;
+        CountingResource resource;
+        CountingResource other_resource;
+        {
+            PmrSegmented v{std::pmr::polymorphic_allocator<int>(&resource)};
+            PmrSegmented other;
+            for (int i = 0; i < 40; ++i) {
+                other.PushBack(i);
+            }
+            v = other;
+            assert(v.GetAllocator().resource() == &resource && v.Size() == 40 && v[39] == 39);
+            assert(resource.allocations == 3);
+
+            // Ресурсы разные, поэтому элементы перемещаются по одному в уже выделенные собственные блоки
+            v = std::move(other);
+            assert(v.GetAllocator().resource() == &resource && v.Size() == 40 && v[17] == 17);
+            assert(resource.allocations == 3 && other.Size() == 40);
+
+            // С тем же ресурсом блоки забираются без выделений
+            PmrSegmented same{std::pmr::polymorphic_allocator<int>(&resource)};
+            same.PushBack(7);
+            const size_t allocations = resource.allocations;
+            v = std::move(same);
+            assert(v.Size() == 1 && v[0] == 7 && resource.allocations == allocations);
+
+            PmrSegmented foreign{std::pmr::polymorphic_allocator<int>(&other_resource)};
+            foreign.PushBack(1);
+            foreign = v;
+            assert(foreign.GetAllocator().resource() == &other_resource && other_resource.bytes_in_use > 0);
+        }
+        assert(resource.bytes_in_use == 0 && other_resource.bytes_in_use == 0);
+    }
+    {
+        // Аллокатор, требующий распространения, переезжает при копировании и перемещении
+        using Propagating = SegmentedVector<int, PropagatingAllocator<int>, 16>;
+        Propagating v{PropagatingAllocator<int>(1)};
+        Propagating other{PropagatingAllocator<int>(2)};
+        other.PushBack(5);
+        v = other;
+        assert(v.GetAllocator().id == 2 && v.Size() == 1 && v[0] == 5);
+        Propagating moved{PropagatingAllocator<int>(3)};
+        moved = std::move(v);
+        assert(moved.GetAllocator().id == 2 && moved.Size() == 1 && v.Size() == 0);
+    }
+}
+
+void Test26() {
+    {
+        Obj::ResetCounters();
+        CowVector<Obj> v(Vector<Obj>(10));
+        const int copied = Obj::num_copied;
+
+        // Снимок не копирует элементы
+        CowVector<Obj> snapshot = v;
+        const CowVector<Obj>& view = snapshot;
+        assert(Obj::num_copied == copied && v.IsShared() && snapshot.IsShared());
+        assert(&view[0] == &v.View()[0]);
+
+        // Первое изменение отделяет буфер, сохраняя ёмкость; остальные изменения его уже не копируют
+        v[0].id = 42;
+        assert(Obj::num_copied == copied + 10 && !v.IsShared() && !snapshot.IsShared());
+        assert(v.Capacity() == snapshot.Capacity());
+        v.EmplaceBack(7);
+        v.Erase(v.cbegin() + 1);
+        assert(Obj::num_copied == copied + 10);
+        assert(v.Size() == 10 && v.View()[0].id == 42 && v.View()[9].id == 7);
+        assert(view.Size() == 10 && view[0].id == 0);
+
+        // Итератор в разделяемый буфер переносится на копию по индексу
+        CowVector<Obj> other = snapshot;
+        other.Insert(other.cbegin() + 2, Obj(5));
+        assert(other.Size() == 11 && other.View()[2].id == 5 && view.Size() == 10);
+
+        other.Clear();
+        assert(other.Size() == 0 && view.Size() == 10);
+        assert(Obj::GetAliveObjectCount() == 20);
+    }
+    assert(Obj::GetAliveObjectCount() == 0);
+    {
+        // Исключение при отделении оставляет вектор разделяемым и нетронутым
+        CowVector<Obj> v(Vector<Obj>(4));
+        v[2].throw_on_copy = true;
+        // Ссылка от operator[] больше не используется, и снимок может делить буфер
+        v.MarkShareable();
+        const CowVector<Obj> snapshot = v;
+        try {
+            v.PushBack(Obj(1));
+            assert(false && "Exception is expected");
+        } catch (const std::runtime_error&) {
+        }
+        assert(v.IsShared() && v.Size() == 4);
+    }
+    {
+        // Запись через ссылку и итератор, полученные до копирования, не затрагивает копию
+        CowVector<int> v = {1, 2, 3};
+        int& first = v[0];
+        const auto it = v.begin() + 1;
+        const CowVector<int> snapshot = v;
+        assert(!v.IsShared() && &snapshot.View()[0] != &v.View()[0]);
+        first = 10;
+        *it = 20;
+        assert(snapshot[0] == 1 && snapshot[1] == 2 && v.View()[0] == 10 && v.View()[1] == 20);
+
+        // Без выданных ссылок копии снова делят буфер
+        v.MarkShareable();
+        const CowVector<int> shared = v;
+        assert(v.IsShared() && &shared.View()[0] == &v.View()[0]);
+        v.PushBack(4);
+        const CowVector<int> after_push = v;
+        assert(v.IsShared() && after_push.Size() == 4 && shared.Size() == 3);
+    }
+    {
+        // Копии одного буфера читаются, меняются и разрушаются в разных потоках
+        const CowVector<int> base = {1, 2, 3, 4};
+        std::vector<std::thread> workers;
+        for (int t = 0; t < 4; ++t) {
+            workers.emplace_back([&base, t] {
+                for (int i = 0; i < 1000; ++i) {
+                    CowVector<int> snapshot = base;
+                    assert(snapshot.View()[3] == 4);
+                    snapshot.PushBack(t);
+                    assert(snapshot.Size() == 5 && snapshot.View().Back() == t);
+                }
+            });
+        }
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
+        assert(!base.IsShared() && base.Size() == 4);
+    }
+}
+
+void Test27() {
+    using namespace std::literals;
+    const size_t SIZE = 10;
+    const int ID = 42;
+    {
+        // Без временного объекта: 1 перемещение в неинициализированный конец и присваивания для остального хвоста
+        Obj::ResetCounters();
+        Vector<Obj> v(SIZE);
+        v.Reserve(SIZE * 2);
+        const int old_moved = Obj::num_moved;
+        auto pos = v.EmplaceNoAlias(v.cbegin() + 3, ID, "Ivan"s);
+        assert(&*pos == &v[3] && v[3].id == ID && v[3].name == "Ivan"s && v.Size() == SIZE + 1);
+        assert(Obj::num_constructed_with_id_and_name == 1);
+        assert(Obj::num_moved == old_moved + 1);
+        assert(Obj::num_move_assigned == SIZE - 4);
+        assert(Obj::GetAliveObjectCount() == SIZE + 1);
+
+        // Emplace с числовыми аргументами выбирает этот путь сам
+        const int old_move_assigned = Obj::num_move_assigned;
+        v.Emplace(v.cbegin() + 1, ID);
+        assert(v[1].id == ID && v[4].id == ID);
+        assert(Obj::num_move_assigned == old_move_assigned + static_cast<int>(SIZE) - 1);
+
+        // При исключении в конструкторе хвост возвращается на место
+        for (size_t i = 0; i < v.Size(); ++i) {
+            v[i].id = static_cast<int>(i);
+        }
+        Obj::default_construction_throw_countdown = 1;
+        try {
+            v.Emplace(v.cbegin() + 2);
+            assert(false && "Exception is expected");
+        } catch (const std::runtime_error&) {
+        }
+        assert(v.Size() == SIZE + 2);
+        for (size_t i = 0; i < v.Size(); ++i) {
+            assert(v[i].id == static_cast<int>(i));
+        }
+        assert(Obj::GetAliveObjectCount() == SIZE + 2);
+    }
+    {
+        // Тривиально перемещаемые элементы сдвигаются memmove; аргумент может ссылаться на сдвигаемый элемент
+        Vector<int> v{0, 1, 2, 3, 4};
+        v.Reserve(16);
+        v.Emplace(v.cbegin() + 1, v[3]);
+        v.Emplace(v.cbegin(), std::as_const(v[4]));
+        assert(std::ranges::equal(v, std::initializer_list<int>{3, 0, 3, 1, 2, 3, 4}));
+        v.EmplaceNoAlias(v.cbegin() + 7, 5);
+        v.EmplaceNoAlias(v.cbegin() + 2, 9);
+        assert(std::ranges::equal(v, std::initializer_list<int>{3, 0, 9, 3, 1, 2, 3, 4, 5}));
+    }
+}
+
+void Test28() {
+    using namespace std::literals;
+    {
+        FlatSet<int> set{5, 1, 3};
+        assert(std::ranges::equal(set, std::initializer_list<int>{1, 3, 5}));
+        assert(set.Insert(4).second && !set.Insert(3).second);
+        assert(*set.Insert(4).first == 4 && set.Size() == 4);
+        assert(set.Contains(5) && !set.Contains(2) && *set.LowerBound(2) == 3 && set.Find(6) == set.end());
+
+        // Повторы внутри диапазона и с уже имеющимися ключами отбрасываются
+        set.InsertSorted(std::vector<int>{9, 0, 3, 9, 2, 7});
+        assert(std::ranges::equal(set, std::initializer_list<int>{0, 1, 2, 3, 4, 5, 7, 9}));
+        assert(set.Erase(4) == 1 && set.Erase(4) == 0 && set.Size() == 7);
+
+        FlatSet<int, std::greater<int>> reversed(set.Keys());
+        assert(reversed.Keys().front() == 9 && reversed.Keys().back() == 0);
+    }
+    {
+        FlatMap<std::string, int> map{{"b"s, 2}, {"a"s, 1}};
+        map["c"] = 3;
+        assert(map.Size() == 3 && map.KeyAt(2) == "c"s && map.At("b"s) == 2);
+        assert(!map.TryEmplace("a"s, 10).second && map.At("a"s) == 1);
+        assert(!map.InsertOrAssign("a"s, 10).second && map.At("a"s) == 10);
+        assert(map.Find("z"s) == nullptr);
+        try {
+            map.At("z"s);
+            assert(false && "Exception is expected");
+        } catch (const std::out_of_range&) {
+        }
+
+        // При равных ключах остаются уже имеющееся значение и первое из диапазона
+        map.InsertSorted(std::vector<std::pair<std::string, int>>{{"d"s, 4}, {"a"s, 0}, {"0"s, -1}, {"d"s, 5}});
+        assert(std::ranges::equal(map.Keys(), std::initializer_list<std::string>{"0"s, "a"s, "b"s, "c"s, "d"s}));
+        assert(std::ranges::equal(map.Values(), std::initializer_list<int>{-1, 10, 2, 3, 4}));
+        assert(map.Erase("b"s) == 1 && map.Size() == 4 && map.ValueAt(2) == 3);
+    }
+    {
+        // Индекс Эйтцингера отвечает так же, как двоичный поиск, в том числе для отсутствующих ключей
+        for (size_t n : {0, 1, 2, 7, 8, 100, 1000}) {
+            FlatMap<int, int> map;
+            std::vector<std::pair<int, int>> items;
+            for (size_t i = 0; i < n; ++i) {
+                items.emplace_back(static_cast<int>(i * 3), static_cast<int>(i));
+            }
+            map.InsertSorted(items);
+            FlatMap<int, int> indexed = map;
+            indexed.BuildSearchIndex();
+            assert(indexed.HasSearchIndex() && !map.HasSearchIndex());
+            for (int key = -2; key < static_cast<int>(n * 3) + 2; ++key) {
+                assert(indexed.LowerBound(key) == map.LowerBound(key));
+                assert(indexed.Contains(key) == map.Contains(key));
+            }
+            indexed[-5] = 0;
+            assert(!indexed.HasSearchIndex() && indexed.LowerBound(-5) == 0);
+        }
+    }
+}
+
+// Векторы, которые строятся и разрушаются во время компиляции
+constexpr int BuildAndSum() {
+    Vector<int> v;
+    for (int i = 0; i < 10; ++i) {
+        v.PushBack(i);
+    }
+    v.Insert(v.begin(), -1);
+    v.Emplace(v.begin() + 5, 100);
+    v.Erase(v.begin() + 1);
+    v.Resize(12);
+    EraseIf(v, [](int x) {
+        return x % 2 != 0;
+    });
+    Vector<int> copy = v;
+    copy.ShrinkToFit();
+    int sum = 0;
+    for (int x : copy) {
+        sum += x;
+    }
+    return sum + static_cast<int>(copy.Size());
+}
+
+constexpr bool BuildStrings() {
+    Vector<std::string> v{"b", "d"};
+    v.Reserve(4);
+    v.Emplace(v.begin() + 1, "c");
+    v.Insert(v.begin(), std::string("a"));
+    v.EmplaceBack(v[0]);
+    Vector<std::string> moved = std::move(v);
+    moved.Erase(moved.begin() + 1, moved.begin() + 3);
+    return moved.Size() == 3 && moved[0] == "a" && moved[1] == "d" && moved[2] == "a" && v.Size() == 0;
+}
+
+void Test29() {
+    // Остаются 2, 100, 4, 6, 8, 0: сумма 120 и 6 элементов. Во время выполнения результат тот же
+    static_assert(BuildAndSum() == 126);
+    static_assert(BuildStrings());
+    assert(BuildAndSum() == 126 && BuildStrings());
+
+    static constexpr auto SQUARES = FreezeToArray<[] {
+        Vector<uint64_t> v;
+        for (uint64_t i = 0; i < 1000; ++i) {
+            v.PushBack(i * i);
+        }
+        return v;
+    }>();
+    static_assert(SQUARES.size() == 1000 && SQUARES[999] == 998001);
+    assert(std::accumulate(SQUARES.begin(), SQUARES.end(), uint64_t{0}) == 332833500);
+}
+
+void Test30() {
+    using namespace std::literals;
+    const size_t SIZE = 100;
+    const size_t CAPACITY = 128;
+    const int ID = 42;
+    using ObjVector = StaticVector<Obj, CAPACITY, ThrowOnOverflow>;
+
+    // Для тривиально копируемых элементов объект копируется целиком, а кучи нет вовсе
+    static_assert(std::is_trivially_copyable_v<StaticVector<int, 8>>);
+    static_assert(!std::is_trivially_copyable_v<ObjVector>);
+    static_assert(sizeof(StaticVector<int, 8>) == 8 * sizeof(int) + sizeof(size_t));
+    static_assert(ObjVector::Capacity() == CAPACITY);
+    {
+        Obj::ResetCounters();
+        {
+            ObjVector v(SIZE);
+            assert(v.Size() == SIZE && Obj::GetAliveObjectCount() == SIZE);
+            v[SIZE / 2].id = ID;
+            const ObjVector v_copy(v);
+            assert(&v[SIZE / 2] != &v_copy[SIZE / 2] && v_copy[SIZE / 2].id == ID);
+
+            // Перемещение переносит элементы по одному, исходный вектор пустеет
+            const int old_moved = Obj::num_moved;
+            ObjVector moved(std::move(v));
+            assert(moved.Size() == SIZE && v.Size() == 0);
+            assert(Obj::num_moved == old_moved + static_cast<int>(SIZE));
+            assert(Obj::GetAliveObjectCount() == 2 * SIZE);
+
+            // Присваивание меньшего вектора: SIZE / 2 присваиваний и разрушение лишних
+            ObjVector small(SIZE / 2);
+            moved = small;
+            assert(moved.Size() == SIZE / 2 && Obj::num_assigned == SIZE / 2);
+            assert(Obj::GetAliveObjectCount() == 2 * SIZE);
+        }
+        assert(Obj::GetAliveObjectCount() == 0);
+    }
+    {
+        // Исключение в конструкторе элемента: созданные элементы разрушаются
+        Obj::ResetCounters();
+        Obj::default_construction_throw_countdown = SIZE / 2;
+        try {
+            ObjVector v(SIZE);
+            assert(false && "Exception is expected");
+        } catch (const std::runtime_error&) {
+        }
+        assert(Obj::num_default_constructed == SIZE / 2 - 1);
+        assert(Obj::GetAliveObjectCount() == 0);
+    }
+    {
+        Obj::ResetCounters();
+        ObjVector v(SIZE);
+        v[SIZE / 2].throw_on_copy = true;
+        try {
+            ObjVector v_copy(v);
+            assert(false && "Exception is expected");
+        } catch (const std::runtime_error&) {
+            assert(Obj::num_copied == SIZE / 2);
+        }
+        assert(Obj::GetAliveObjectCount() == SIZE);
+
+        // Вставка копии, которая бросает: вектор не меняется
+        try {
+            v.Insert(v.cbegin() + 1, v[SIZE / 2]);
+            assert(false && "Exception is expected");
+        } catch (const std::runtime_error&) {
+        }
+        assert(v.Size() == SIZE && Obj::GetAliveObjectCount() == SIZE);
+    }
+    {
+        // Переполнение сообщается политикой до того, как вектор изменится
+        Obj::ResetCounters();
+        ObjVector v(CAPACITY);
+        assert(v.Full());
+        try {
+            v.EmplaceBack(ID);
+            assert(false && "Exception is expected");
+        } catch (const std::length_error&) {
+        }
+        try {
+            v.Emplace(v.cbegin(), ID);
+            assert(false && "Exception is expected");
+        } catch (const std::length_error&) {
+        }
+        try {
+            v.Resize(CAPACITY + 1);
+            assert(false && "Exception is expected");
+        } catch (const std::length_error&) {
+        }
+        assert(v.Size() == CAPACITY && Obj::num_constructed_with_id == 0);
+        assert(Obj::GetAliveObjectCount() == static_cast<int>(CAPACITY));
+
+        // TryEmplaceBack не вызывает политику и ничего не создаёт
+        assert(!v.TryEmplaceBack(ID));
+        assert(Obj::num_constructed_with_id == 0);
+        v.PopBack();
+        assert(v.TryEmplaceBack(ID) && v.Back().id == ID && v.Full());
+
+        int items[] = {1, 2, 3};
+        try {
+            StaticVector<int, 2, ThrowOnOverflow> too_many(std::begin(items), std::end(items));
+            assert(false && "Exception is expected");
+        } catch (const std::length_error&) {
+        }
+    }
+    {
+        // Resize, PushBack и EmplaceBack, в том числе элементов самого вектора
+        Obj::ResetCounters();
+        ObjVector v;
+        v.Resize(SIZE);
+        assert(v.Size() == SIZE && Obj::num_default_constructed == SIZE);
+        v.Resize(SIZE / 2);
+        assert(v.Size() == SIZE / 2 && Obj::num_destroyed == SIZE / 2);
+        Obj o{ID};
+        v.PushBack(o);
+        v.PushBack(Obj{ID});
+        assert(Obj::num_copied == 1 && Obj::num_moved == 1);
+        auto& elem = v.EmplaceBack(ID, "Ivan"s);
+        assert(&elem == &v.Back() && elem.name == "Ivan"s);
+        assert(Obj::num_constructed_with_id_and_name == 1);
+
+        StaticVector<A, 4> a(1);
+        a.PushBack(a[0]);
+        a.PushBack(std::move(a[0]));
+        a.EmplaceBack(a[1]);
+        assert(std::all_of(a.begin(), a.end(), [](const A& obj) {
+            return obj.IsAlive();
+        }));
+    }
+    {
+        // Emplace и Erase в середине: те же сдвиги, что у Vector с запасом ёмкости
+        Obj::ResetCounters();
+        ObjVector v(SIZE);
+        auto* pos = v.Emplace(v.cbegin() + 3, ID, "Ivan"s);
+        assert(v.Size() == SIZE + 1 && &*pos == &v[3]);
+        assert(v[3].id == ID && v[3].name == "Ivan"s);
+        assert(Obj::num_copied == 0 && Obj::num_moved == 1);
+        assert(Obj::num_move_assigned == SIZE - 3 && Obj::num_assigned == 0);
+
+        const int old_move_assigned = Obj::num_move_assigned;
+        const int old_destroyed = Obj::num_destroyed;
+        pos = v.Erase(v.cbegin() + 2);
+        assert(pos == v.begin() + 2 && pos->id == ID);
+        assert(Obj::num_move_assigned == old_move_assigned + static_cast<int>(SIZE) - 2);
+        assert(Obj::num_destroyed == old_destroyed + 1);
+        pos = v.Erase(v.cbegin(), v.cbegin() + 10);
+        assert(pos == v.begin() && v.Size() == SIZE - 10);
+
+        StaticVector<A, 16> a(10);
+        a.Insert(a.cbegin() + 2, a[0]);
+        a.Emplace(a.cbegin() + 2, std::move(a[5]));
+        assert(std::all_of(a.begin(), a.end(), [](const A& obj) {
+            return obj.IsAlive();
+        }));
+    }
+    {
+        // Тривиальные элементы: вставки и удаления сдвигают хвост байтами
+        StaticVector<int, 16> v{1, 2, 4, 5};
+        v.Insert(v.cbegin() + 2, 3);
+        v.Emplace(v.cbegin(), 0);
+        v.Erase(v.cbegin() + 5);
+        const StaticVector<int, 16> copy = v;
+        assert(std::ranges::equal(copy, std::initializer_list<int>{0, 1, 2, 3, 4}));
+
+        StaticVector<int, 16> other{7};
+        other.Swap(v);
+        assert(v.Size() == 1 && other.Size() == 5 && other[4] == 4);
+
+        ObjVector lhs(3);
+        ObjVector rhs(SIZE);
+        rhs[SIZE - 1].id = ID;
+        lhs.Swap(rhs);
+        assert(lhs.Size() == SIZE && rhs.Size() == 3 && lhs[SIZE - 1].id == ID);
+    }
+    assert(Obj::GetAliveObjectCount() == 0);
+}
+
+// Запускает operation в дочернем процессе и возвращает сигнал, которым тот завершился (0 - завершился сам)
+template <typename Operation>
+int DeathSignal(Operation operation) {
+    const pid_t pid = fork();
+    if (pid == 0) {
+        const int null_fd = open("/dev/null", O_WRONLY);
+        dup2(null_fd, STDERR_FILENO);
+        operation();
+        _exit(0);
+    }
+    int status = 0;
+    waitpid(pid, &status, 0);
+    return WIFSIGNALED(status) ? WTERMSIG(status) : 0;
+}
+
+void Test31() {
+    // Тесты собираются без NDEBUG, то есть с полными проверками
+    static_assert(ADVANCED_VECTOR_CHECK_LEVEL == ADVANCED_VECTOR_CHECK_FULL);
+    {
+        Vector<int> v{1, 2, 3};
+        const auto& cv = v;
+        assert(v.At(2) == 3 && &cv.At(0) == &v[0]);
+        try {
+            v.At(3);
+            assert(false && "Exception is expected");
+        } catch (const std::out_of_range&) {
+        }
+
+        SmallVector<int, 2> small{1, 2, 3};
+        StaticVector<int, 4> fixed{1, 2};
+        assert(small.At(2) == 3 && fixed.At(1) == 2);
+        try {
+            fixed.At(2);
+            assert(false && "Exception is expected");
+        } catch (const std::out_of_range&) {
+        }
+    }
+    {
+        // Нарушение границ останавливает процесс, а не портит память
+        assert(DeathSignal([] {
+            Vector<int> v(3);
+            static_cast<void>(v[3]);
+        }) == SIGABRT);
+        assert(DeathSignal([] {
+            Vector<int> v;
+            v.PopBack();
+        }) == SIGABRT);
+        assert(DeathSignal([] {
+            Vector<int> v(3);
+            Vector<int> other(3);
+            v.Erase(other.begin());
+        }) == SIGABRT);
+        assert(DeathSignal([] {
+            StaticVector<int, 4> v(2);
+            static_cast<void>(v.Back());
+            static_cast<void>(v[1]);
+        }) == 0);
+        assert(DeathSignal([] {
+            StaticVector<int, 2> v(2);
+            v.PushBack(3);
+        }) == SIGABRT);
+        assert(DeathSignal([] {
+            FlatMap<int, int> map{{1, 1}};
+            map.EraseAt(1);
+        }) == SIGABRT);
+        assert(DeathSignal([] {
+            ConcurrentVector<int> v;
+            v.PushBack(1);
+            static_cast<void>(v[1]);
+        }) == SIGABRT);
+        assert(DeathSignal([] {
+            const Vector<int> v;
+            static_cast<void>(simd::Min(v.Data(), v.Data()));
+        }) == SIGABRT);
+    }
+}
+
+void Test32() {
+    static_assert(std::contiguous_iterator<Vector<int>::iterator>);
+    static_assert(std::contiguous_iterator<Vector<int>::const_iterator>);
+#if ADVANCED_VECTOR_DEBUG_ITERATORS
+    {
+        // Итератор живёт, пока буфер не заменён
+        Vector<int> v{1, 2, 3};
+        v.Reserve(10);
+        Vector<int>::const_iterator it = v.begin() + 1;
+        v.PushBack(4);
+        v.Insert(v.begin(), 0);
+        assert(*it == 1 && it - v.begin() == 1 && std::span<int>(v.begin(), v.end()).size() == 5);
+    }
+    {
+        // Как и у std::vector, при перемещении и обмене итераторы следуют за буфером в другой вектор
+        Vector<int> v{1, 2, 3};
+        auto it = v.begin() + 1;
+        Vector<int> w;
+        w = std::move(v);
+        assert(*it == 2 && it - w.begin() == 1);
+        w.Erase(it);
+        assert(w.Size() == 2 && w[1] == 3);
+
+        const auto first = w.begin();
+        Vector<int> moved(std::move(w));
+        Vector<int> other{7};
+        const auto seven = other.begin();
+        moved.Swap(other);
+        assert(*first == 1 && first == other.begin() && *seven == 7 && seven == moved.begin());
+        other.Insert(first, 0);
+        assert(other.Size() == 3 && other[0] == 0);
+    }
+    // Реаллокация, ShrinkToFit, освобождение буфера и разрушение вектора делают итераторы недействительными
+    assert(DeathSignal([] {
+        Vector<int> v(1);
+        auto it = v.begin();
+        v.Reserve(10);
+        static_cast<void>(*it);
+    }) == SIGABRT);
+    assert(DeathSignal([] {
+        Vector<int> v(1);
+        auto it = v.begin();
+        v.PushBack(1);
+        static_cast<void>(it == v.begin());
+    }) == SIGABRT);
+    assert(DeathSignal([] {
+        Vector<int> v(4);
+        auto it = v.begin();
+        v.Resize(2);
+        v.ShrinkToFit();
+        v.Emplace(it, 1);
+    }) == SIGABRT);
+    assert(DeathSignal([] {
+        // Буфер, в который смотрит итератор, освобождён присваиванием
+        Vector<int> v(4);
+        auto it = v.begin();
+        v = Vector<int>(2);
+        static_cast<void>(*it);
+    }) == SIGABRT);
+    assert(DeathSignal([] {
+        Vector<int> v(4);
+        auto it = v.end();
+        Vector<int> moved = std::move(v);
+        moved.Reserve(100);
+        moved.Erase(it - 1);
+    }) == SIGABRT);
+    assert(DeathSignal([] {
+        Vector<int>::iterator it;
+        {
+            Vector<int> v(4);
+            it = v.begin();
+        }
+        static_cast<void>(*it);
+    }) == SIGABRT);
+    assert(DeathSignal([] {
+        Vector<int> v(4);
+        Vector<int> other(4);
+        other.Erase(v.begin());
+    }) == SIGABRT);
+#else
+    // Без отладочных итераторов итератор - это указатель без накладных расходов
+    static_assert(std::is_same_v<Vector<int>::iterator, int*>);
+    static_assert(sizeof(RawMemory<int>) == sizeof(int*) + sizeof(size_t) + sizeof(BufferDeleter<int>));
+#endif
+}
+
+void Test33() {
+    using namespace std::literals;
+    {
+        // Ёмкость округляется до степени двойки, порядок FIFO сохраняется при переходе через конец буфера
+        SpscRingBuffer<int> ring(3);
+        assert(ring.Capacity() == 4 && ring.Size() == 0 && !ring.TryPop());
+        for (int round = 0; round < 3; ++round) {
+            for (int i = 0; i < 4; ++i) {
+                assert(ring.TryPush(round * 10 + i));
+            }
+            assert(!ring.TryPush(-1) && ring.Size() == 4);
+            assert(*ring.TryPop() == round * 10 && *ring.TryPop() == round * 10 + 1);
+            assert(ring.TryPush(round * 10 + 4));
+            for (int i = 2; i < 5; ++i) {
+                assert(*ring.TryPop() == round * 10 + i);
+            }
+            assert(!ring.TryPop());
+        }
+    }
+    {
+        // Пакеты не переходят через конец буфера: остаток достаётся следующим вызовом
+        SpscRingBuffer<int> ring(8);
+        std::span<int> slots = ring.PushN(6);
+        assert(slots.size() == 6);
+        std::iota(slots.begin(), slots.end(), 0);
+        ring.CommitPush(slots.first(5));
+        std::span<int> batch = ring.PopN(10);
+        assert(batch.size() == 5 && batch[4] == 4);
+        ring.CommitPop(batch.first(4));
+        assert(ring.Size() == 1);
+
+        slots = ring.PushN(10);
+        assert(slots.size() == 3 && slots.data() == batch.data() + 5);
+        std::iota(slots.begin(), slots.end(), 5);
+        ring.CommitPush(slots);
+        slots = ring.PushN(10);
+        assert(slots.size() == 4 && slots.data() == batch.data());
+        std::iota(slots.begin(), slots.end(), 8);
+        ring.CommitPush(slots);
+        assert(ring.PushN(1).empty() && ring.Size() == 8);
+
+        std::vector<int> popped;
+        for (std::span<int> part = ring.PopN(100); !part.empty(); part = ring.PopN(100)) {
+            popped.insert(popped.end(), part.begin(), part.end());
+            ring.CommitPop(part);
+        }
+        std::vector<int> expected(8);
+        std::iota(expected.begin(), expected.end(), 4);
+        assert(popped == expected);
+    }
+    {
+        // Элементы разрушаются при извлечении, CommitPop и вместе с буфером; брошенный конструктор очередь не меняет
+        Obj::ResetCounters();
+        {
+            SpscRingBuffer<Obj> ring(4);
+            assert(ring.TryEmplace(1) && ring.TryEmplace(2, "two"s) && ring.TryPush(Obj(3)));
+            Obj::default_construction_throw_countdown = 1;
+            try {
+                ring.TryEmplace();
+                assert(false && "Exception is expected");
+            } catch (const std::runtime_error&) {
+            }
+            assert(ring.Size() == 3 && Obj::GetAliveObjectCount() == 3);
+            assert(ring.TryPop()->id == 1);
+            assert(Obj::GetAliveObjectCount() == 2);
+            std::span<Obj> batch = ring.PopN(1);
+            assert(batch.size() == 1 && batch[0].name == "two"s);
+            ring.CommitPop(batch);
+            assert(Obj::GetAliveObjectCount() == 1);
+
+            MpmcRingBuffer<Obj> mpmc(2);
+            assert(mpmc.TryEmplace(4) && mpmc.TryEmplace(5) && !mpmc.TryEmplace(6));
+            assert(mpmc.TryPop()->id == 4);
+            assert(Obj::GetAliveObjectCount() == 2);
+        }
+        assert(Obj::GetAliveObjectCount() == 0);
+    }
+    {
+        // Производитель и потребитель в разных потоках: ни одно значение не теряется и не повторяется
+        constexpr int COUNT = 200'000;
+        SpscRingBuffer<int> ring(64);
+        std::thread producer([&ring] {
+            for (int i = 0; i < COUNT;) {
+                std::span<int> slots = ring.PushN(std::min(16, COUNT - i));
+                if (slots.empty()) {
+                    std::this_thread::yield();
+                }
+                for (int& slot : slots) {
+                    slot = i++;
+                }
+                ring.CommitPush(slots);
+            }
+        });
+        for (int expected = 0; expected < COUNT;) {
+            std::span<int> batch = ring.PopN(32);
+            if (batch.empty()) {
+                std::this_thread::yield();
+            }
+            for (int value : batch) {
+                assert(value == expected++);
+            }
+            ring.CommitPop(batch);
+        }
+        producer.join();
+        assert(ring.Size() == 0);
+    }
+    {
+        // Ждущий режим: крошечный буфер заставляет обе стороны засыпать
+        constexpr int COUNT = 20'000;
+        SpscRingBuffer<std::string, std::allocator<std::string>, true> ring(2);
+        std::thread producer([&ring] {
+            for (int i = 0; i < COUNT; ++i) {
+                ring.Push(std::to_string(i));
+            }
+        });
+        for (int i = 0; i < COUNT; ++i) {
+            assert(ring.Pop() == std::to_string(i));
+        }
+        producer.join();
+
+        // Аргументы Emplace передаются дальше без копирования, поэтому подходят и некопируемые
+        SpscRingBuffer<std::unique_ptr<int>, std::allocator<std::unique_ptr<int>>, true> owners(2);
+        owners.Emplace(std::make_unique<int>(5));
+        std::unique_ptr<int> owner = std::make_unique<int>(6);
+        owners.Emplace(std::move(owner));
+        assert(!owner && *owners.Pop() == 5 && *owners.Pop() == 6);
+    }
+    {
+        // Несколько производителей и потребителей, одиночные и пакетные операции вперемешку
+        constexpr size_t THREADS = 4;
+        constexpr size_t PER_THREAD = 50'000;
+        MpmcRingBuffer<size_t> ring(128);
+        std::vector<std::atomic<int>> seen(THREADS * PER_THREAD);
+        std::atomic<size_t> consumed = 0;
+        std::vector<std::thread> threads;
+        for (size_t t = 0; t < THREADS; ++t) {
+            threads.emplace_back([&ring, t] {
+                for (size_t i = t * PER_THREAD; i < (t + 1) * PER_THREAD;) {
+                    if (i % 3 == 0) {
+                        std::span<size_t> slots = ring.PushN(std::min<size_t>(8, (t + 1) * PER_THREAD - i));
+                        if (slots.empty()) {
+                            std::this_thread::yield();
+                        }
+                        for (size_t& slot : slots) {
+                            slot = i++;
+                        }
+                        ring.CommitPush(slots);
+                    } else if (ring.TryPush(i)) {
+                        ++i;
+                    } else {
+                        std::this_thread::yield();
+                    }
+                }
+            });
+            threads.emplace_back([&ring, &seen, &consumed, t] {
+                while (consumed.load() < THREADS * PER_THREAD) {
+                    if (t % 2 == 0) {
+                        std::span<size_t> batch = ring.PopN(8);
+                        if (batch.empty()) {
+                            std::this_thread::yield();
+                        }
+                        for (size_t value : batch) {
+                            ++seen[value];
+                        }
+                        ring.CommitPop(batch);
+                        consumed += batch.size();
+                    } else if (std::optional<size_t> value = ring.TryPop()) {
+                        ++seen[*value];
+                        ++consumed;
+                    } else {
+                        std::this_thread::yield();
+                    }
+                }
+            });
+        }
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+        assert(std::ranges::all_of(seen, [](const std::atomic<int>& count) {
+            return count.load() == 1;
+        }));
+        assert(ring.Size() == 0 && !ring.TryPop());
+    }
+    {
+        // Только пакеты на маленьком буфере: захваченные куски разных потоков не перекрываются,
+        // и каждый элемент извлекается ровно один раз
+        constexpr size_t THREADS = 4;
+        constexpr size_t PER_THREAD = 40'000;
+        MpmcRingBuffer<size_t> ring(16);
+        std::vector<std::atomic<int>> seen(THREADS * PER_THREAD);
+        std::atomic<size_t> consumed = 0;
+        std::vector<std::thread> threads;
+        for (size_t t = 0; t < THREADS; ++t) {
+            threads.emplace_back([&ring, t] {
+                for (size_t i = t * PER_THREAD; i < (t + 1) * PER_THREAD;) {
+                    std::span<size_t> slots = ring.PushN(std::min<size_t>(1 + i % 7, (t + 1) * PER_THREAD - i));
+                    if (slots.empty()) {
+                        std::this_thread::yield();
+                    }
+                    for (size_t& slot : slots) {
+                        slot = i++;
+                    }
+                    ring.CommitPush(slots);
+                }
+            });
+            threads.emplace_back([&ring, &seen, &consumed, t] {
+                while (consumed.load() < THREADS * PER_THREAD) {
+                    std::span<size_t> batch = ring.PopN(1 + t % 5);
+                    if (batch.empty()) {
+                        std::this_thread::yield();
+                    }
+                    for (size_t value : batch) {
+                        ++seen[value];
+                    }
+                    ring.CommitPop(batch);
+                    consumed += batch.size();
+                }
+            });
+        }
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+        assert(std::ranges::all_of(seen, [](const std::atomic<int>& count) {
+            return count.load() == 1;
+        }));
+        assert(consumed.load() == THREADS * PER_THREAD && ring.Size() == 0 && !ring.TryPop());
+    }
+    {
+        constexpr int COUNT = 10'000;
+        MpmcRingBuffer<int, std::allocator<int>, true> ring(4);
+        std::atomic<long long> sum = 0;
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 2; ++t) {
+            threads.emplace_back([&ring] {
+                for (int i = 1; i <= COUNT; ++i) {
+                    ring.Push(i);
+                }
+            });
+            threads.emplace_back([&ring, &sum] {
+                for (int i = 0; i < COUNT; ++i) {
+                    sum += ring.Pop();
+                }
+            });
+        }
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+        assert(sum == 2LL * COUNT * (COUNT + 1) / 2);
+    }
+}
+
+// Сверяет PackedVector<Bits> с std::vector на случайных значениях, в том числе пересекающих границы слов
+template <unsigned Bits>
+void CheckPackedVector(std::mt19937_64& random) {
+    using Packed = PackedVector<Bits>;
+    using Value = typename Packed::value_type;
+    Packed packed;
+    std::vector<Value> expected;
+    for (size_t i = 0; i < 1000; ++i) {
+        const auto value = static_cast<Value>(random() & Packed::MAX_VALUE);
+        packed.PushBack(value);
+        expected.push_back(value);
+    }
+    assert(packed.Words().size() == (1000 * Bits + 63) / 64);
+    for (size_t i = 0; i < 2000; ++i) {
+        const size_t index = random() % expected.size();
+        const auto value = static_cast<Value>(random() & Packed::MAX_VALUE);
+        packed[index] = value;
+        expected[index] = value;
+        assert(packed.Get(index) == value);
+    }
+    assert(std::ranges::equal(packed, expected));
+    std::vector<Value> visited;
+    packed.ForEach([&visited](Value value) {
+        visited.push_back(value);
+    });
+    assert(visited == expected);
+
+    // Укороченный и снова выросший вектор читает нули, а не прежние значения
+    packed.Resize(333);
+    packed.Resize(500);
+    assert(std::all_of(packed.begin() + 333, packed.end(), [](Value value) {
+        return value == 0;
+    }));
+    while (packed.Size() > 1) {
+        packed.PopBack();
+    }
+    assert(packed == Packed{expected[0]});
+}
+
+void Test34() {
+    {
+        BitVector bits(130);
+        assert(bits.Size() == 130 && bits.Words().size() == 3 && bits.None());
+        assert(bits.FindFirst() == bits.NPOS && bits.FindFirstZero() == 0);
+        bits.Set(0);
+        bits.Set(64);
+        bits[129] = true;
+        assert(bits.Count() == 3 && bits.Any() && !bits.All());
+        assert(bits.FindFirst() == 0 && bits.FindFirst(1) == 64 && bits.FindFirst(65) == 129);
+        assert(bits.FindFirstZero() == 1 && bits.FindFirstZero(129) == bits.NPOS);
+        bits.Flip(64);
+        assert(!bits[64] && bits.Test(129) && bits.At(129));
+        try {
+            bits.At(130);
+            assert(false && "Exception is expected");
+        } catch (const std::out_of_range&) {
+        }
+
+        // Биты за концом вектора остаются нулевыми при любых операциях
+        bits.Flip();
+        assert(bits.Count() == 128 && bits.Words()[2] == 1);
+        bits.SetAll();
+        assert(bits.All() && bits.FindFirstZero() == bits.NPOS);
+        bits.Resize(70);
+        bits.Resize(200);
+        assert(bits.Count() == 70 && bits.FindFirstZero() == 70);
+        bits.Resize(250, true);
+        assert(bits.Count() == 120 && bits.FindFirst(70) == 200);
+        bits.Fill(60, 210, false);
+        assert(bits.Count() == 100 && bits.FindFirst(60) == 210);
+    }
+    {
+        // Массовые операции и поиск сверяются с std::vector<bool>
+        std::mt19937_64 random(42);
+        for (size_t size : {1, 63, 64, 65, 1000}) {
+            BitVector lhs;
+            BitVector rhs;
+            std::vector<bool> expected_lhs;
+            std::vector<bool> expected_rhs;
+            for (size_t i = 0; i < size; ++i) {
+                const bool x = random() % 3 == 0;
+                const bool y = random() % 2 == 0;
+                lhs.PushBack(x);
+                rhs.PushBack(y);
+                expected_lhs.push_back(x);
+                expected_rhs.push_back(y);
+            }
+            const auto check = [](const BitVector<>& bits, const std::vector<bool>& expected) {
+                assert(bits.Size() == expected.size());
+                assert(bits.Count() == static_cast<size_t>(std::ranges::count(expected, true)));
+                std::vector<size_t> set;
+                bits.ForEachSet([&set](size_t index) {
+                    set.push_back(index);
+                });
+                size_t next = 0;
+                for (size_t i = 0; i < expected.size(); ++i) {
+                    assert(bits[i] == expected[i]);
+                    if (expected[i]) {
+                        assert(set[next++] == i);
+                    }
+                    const auto first = std::find(expected.begin() + i, expected.end(), true);
+                    const auto zero = std::find(expected.begin() + i, expected.end(), false);
+                    assert(bits.FindFirst(i) == (first == expected.end() ? bits.NPOS : first - expected.begin()));
+                    assert(bits.FindFirstZero(i) == (zero == expected.end() ? bits.NPOS : zero - expected.begin()));
+                }
+                assert(next == set.size());
+            };
+            check(lhs, expected_lhs);
+
+            BitVector and_bits = lhs;
+            and_bits &= rhs;
+            BitVector or_bits = lhs;
+            or_bits |= rhs;
+            BitVector xor_bits = lhs;
+            xor_bits ^= rhs;
+            BitVector and_not = lhs;
+            and_not.AndNot(rhs);
+            std::vector<bool> expected_and(size);
+            std::vector<bool> expected_or(size);
+            std::vector<bool> expected_xor(size);
+            std::vector<bool> expected_and_not(size);
+            for (size_t i = 0; i < size; ++i) {
+                expected_and[i] = expected_lhs[i] && expected_rhs[i];
+                expected_or[i] = expected_lhs[i] || expected_rhs[i];
+                expected_xor[i] = expected_lhs[i] != expected_rhs[i];
+                expected_and_not[i] = expected_lhs[i] && !expected_rhs[i];
+            }
+            check(and_bits, expected_and);
+            check(or_bits, expected_or);
+            check(xor_bits, expected_xor);
+            check(and_not, expected_and_not);
+
+            BitVector flipped = lhs;
+            flipped.Flip();
+            flipped.Flip();
+            assert(flipped == lhs && (flipped.Flip(0), flipped != lhs));
+            while (lhs.Size() > 0) {
+                assert(lhs.Back() == expected_lhs.back());
+                lhs.PopBack();
+                expected_lhs.pop_back();
+            }
+            assert(lhs.Words().empty());
+        }
+    }
+    {
+        std::mt19937_64 random(7);
+        CheckPackedVector<1>(random);
+        CheckPackedVector<3>(random);
+        CheckPackedVector<8>(random);
+        CheckPackedVector<12>(random);
+        CheckPackedVector<17>(random);
+        CheckPackedVector<20>(random);
+        CheckPackedVector<33>(random);
+        CheckPackedVector<63>(random);
+        CheckPackedVector<64>(random);
+
+        static_assert(std::is_same_v<PackedVector<20>::value_type, uint32_t>);
+        static_assert(std::is_same_v<PackedVector<8>::value_type, uint8_t>);
+        static_assert(std::random_access_iterator<PackedVector<20>::const_iterator>);
+
+        PackedVector<20> ids(3, 0xABCDE);
+        assert(ids.Words().size() == 1 && ids.Back() == 0xABCDE && ids.Front() == 0xABCDE);
+        const std::vector<uint32_t> source{1, 2, 3, 0xFFFFF};
+        PackedVector<20> copy(source.begin(), source.end());
+        assert(std::ranges::equal(copy, source) && copy.At(3) == 0xFFFFF);
+        try {
+            copy.At(4);
+            assert(false && "Exception is expected");
+        } catch (const std::out_of_range&) {
+        }
+        assert(DeathSignal([] {
+            PackedVector<4> small(1);
+            small.Set(0, 16);
+        }) == SIGABRT);
+    }
+}
 
 int main() {
     try {
@@ -651,7 +3188,34 @@ int main() {
         Test4();
         Test5();
         Test6();
-        Benchmark();
+        Test7();
+        Test8();
+        Test9();
+        Test10();
+        Test11();
+        Test12();
+        Test13();
+        Test14();
+        Test15();
+        Test16();
+        Test17();
+        Test18();
+        Test19();
+        Test20();
+        Test21();
+        Test22();
+        Test23();
+        Test24();
+        Test25();
+        Test26();
+        Test27();
+        Test28();
+        Test29();
+        Test30();
+        Test31();
+        Test32();
+        Test33();
+        Test34();
     } catch (const std::exception& e) {
         std::cerr << e.what() << std::endl;
     }
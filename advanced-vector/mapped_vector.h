@@ -0,0 +1,337 @@
+#pragma once
+
+#include "vector.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+enum class MappedMode {
+    READ_WRITE, // файл открывается или создаётся, вектор можно менять
+    READ_ONLY,  // файл только читается; процессы, открывшие его так, делят одни страницы кэша
+};
+
+// Вектор тривиально копируемых элементов, лежащих прямо в отображённом в память файле (mmap с MAP_SHARED).
+// Файл начинается с заголовка на HEADER_BYTES байт с размером вектора, за ним идут элементы, а длина файла задаёт ёмкость.
+// Рост удлиняет файл через ftruncate и расширяет отображение через mremap, поэтому элементы не копируются ни при росте,
+// ни при повторном открытии: сохранённый вектор готов к работе сразу после конструктора.
+// Ошибки системных вызовов сообщаются исключением std::system_error, чужой или повреждённый файл - std::runtime_error,
+// попытка изменить вектор, открытый только для чтения, - std::logic_error
+template <typename T>
+class MappedVector {
+    static_assert(std::is_trivially_copyable_v<T>, "Only trivially copyable elements can be stored in a file");
+
+    struct Header {
+        uint64_t magic;
+        uint64_t element_size;
+        uint64_t size;
+    };
+
+public:
+    using iterator = T*;
+    using const_iterator = const T*;
+
+    // Элементы начинаются с этого смещения, поэтому выровнены не хуже кэш-линии
+    static constexpr size_t HEADER_BYTES = 64;
+    static constexpr uint64_t MAGIC = 0x314345564450414d; // "MAPDVEC1"
+
+    static_assert(alignof(T) <= HEADER_BYTES, "Elements must not be aligned stricter than the header size");
+
+    explicit MappedVector(const std::filesystem::path& path, MappedMode mode = MappedMode::READ_WRITE)
+        : read_only_(mode == MappedMode::READ_ONLY) {
+        fd_ = ::open(path.c_str(), read_only_ ? O_RDONLY : O_RDWR | O_CREAT, 0644);
+        if (fd_ < 0) {
+            ThrowSystemError("open");
+        }
+
+        try {
+            struct stat info {};
+            if (::fstat(fd_, &info) != 0) {
+                ThrowSystemError("fstat");
+            }
+            size_t bytes = static_cast<size_t>(info.st_size);
+
+            const bool is_new = bytes == 0 && !read_only_;
+            if (is_new) {
+                bytes = HEADER_BYTES;
+                Truncate(bytes);
+            }
+            if (bytes < HEADER_BYTES) {
+                throw std::runtime_error("File is too short for a MappedVector header");
+            }
+            Map(bytes);
+
+            if (is_new) {
+                *GetHeader() = {.magic = MAGIC, .element_size = sizeof(T), .size = 0};
+            }
+            const Header& header = *GetHeader();
+            if (header.magic != MAGIC || header.element_size != sizeof(T) || header.size > Capacity()) {
+                throw std::runtime_error("File does not contain a MappedVector of this element type");
+            }
+        } catch (...) {
+            Close();
+            throw;
+        }
+    }
+
+    MappedVector(const MappedVector&) = delete;
+    MappedVector& operator=(const MappedVector&) = delete;
+
+    MappedVector(MappedVector&& other) noexcept
+        : read_only_(other.read_only_)
+        , fd_(std::exchange(other.fd_, -1))
+        , map_(std::exchange(other.map_, nullptr))
+        , mapped_bytes_(std::exchange(other.mapped_bytes_, 0)) {
+    }
+
+    MappedVector& operator=(MappedVector&& rhs) noexcept {
+        if (this != &rhs) {
+            Close();
+            read_only_ = rhs.read_only_;
+            fd_ = std::exchange(rhs.fd_, -1);
+            map_ = std::exchange(rhs.map_, nullptr);
+            mapped_bytes_ = std::exchange(rhs.mapped_bytes_, 0);
+        }
+        return *this;
+    }
+
+    // Изменения уже лежат в страницах файла; на диск их в своё время запишет ядро (или Sync)
+    ~MappedVector() {
+        Close();
+    }
+
+    // Запись через итераторы вектора, открытого только для чтения, завершится ошибкой защиты памяти
+    iterator begin() noexcept {
+        return Data();
+    }
+
+    const_iterator begin() const noexcept {
+        return Data();
+    }
+
+    const_iterator cbegin() const noexcept {
+        return begin();
+    }
+
+    iterator end() noexcept {
+        return begin() + Size();
+    }
+
+    const_iterator end() const noexcept {
+        return begin() + Size();
+    }
+
+    const_iterator cend() const noexcept {
+        return end();
+    }
+
+    T& Front() noexcept {
+        return *begin();
+    }
+
+    const T& Front() const noexcept {
+        return *begin();
+    }
+
+    T& Back() noexcept {
+        return *std::prev(end());
+    }
+
+    const T& Back() const noexcept {
+        return *std::prev(end());
+    }
+
+    const T& operator[](size_t index) const noexcept {
+        ADVANCED_VECTOR_CHECK_BOUNDS(index < Size());
+        return Data()[index];
+    }
+
+    T& operator[](size_t index) noexcept {
+        ADVANCED_VECTOR_CHECK_BOUNDS(index < Size());
+        return begin()[index];
+    }
+
+    // Размер читается из общего заголовка, поэтому сразу видит записи других процессов. Если писатель вырос
+    // дальше отображённой части файла, читатель видит только свои Capacity() элементов: остальные ему не отображены
+    size_t Size() const noexcept {
+        return map_ == nullptr ? 0 : std::min<size_t>(GetHeader()->size, Capacity());
+    }
+
+    size_t Capacity() const noexcept {
+        return mapped_bytes_ < HEADER_BYTES ? 0 : (mapped_bytes_ - HEADER_BYTES) / sizeof(T);
+    }
+
+    bool IsReadOnly() const noexcept {
+        return read_only_;
+    }
+
+    // Удлиняет файл под new_capacity элементов. Элементы остаются на месте в файле, но адрес отображения может измениться
+    void Reserve(size_t new_capacity) {
+        CheckWritable();
+        if (new_capacity <= Capacity()) {
+            return;
+        }
+        if (new_capacity > (std::numeric_limits<size_t>::max() - HEADER_BYTES) / sizeof(T)) {
+            throw std::length_error("MappedVector capacity is too large");
+        }
+
+        const size_t old_bytes = mapped_bytes_;
+        const size_t new_bytes = HEADER_BYTES + new_capacity * sizeof(T);
+        Truncate(new_bytes);
+        try {
+            Remap(new_bytes);
+        } catch (...) {
+            static_cast<void>(::ftruncate(fd_, static_cast<off_t>(old_bytes)));
+            throw;
+        }
+    }
+
+    void Resize(size_t new_size) {
+        CheckWritable();
+        if (new_size > Capacity()) {
+            Reserve(NextCapacity(new_size));
+        }
+        if (new_size > Size()) {
+            std::uninitialized_value_construct(end(), begin() + new_size);
+        }
+        GetHeader()->size = new_size;
+    }
+
+    template <typename... Args>
+    T& EmplaceBack(Args&&... args) {
+        CheckWritable();
+        // Аргументы могут ссылаться на элементы вектора, которые переедут вместе с отображением
+        T value(std::forward<Args>(args)...);
+        if (Size() == Capacity()) {
+            Reserve(NextCapacity(Size() + 1));
+        }
+        std::construct_at(end(), value);
+        ++GetHeader()->size;
+        return Back();
+    }
+
+    void PushBack(const T& value) {
+        EmplaceBack(value);
+    }
+
+    void PopBack() {
+        CheckWritable();
+        ADVANCED_VECTOR_CHECK_BOUNDS(Size() != 0);
+        --GetHeader()->size;
+    }
+
+    void Clear() {
+        CheckWritable();
+        GetHeader()->size = 0;
+    }
+
+    // Дожидается записи отображённых страниц на диск
+    void Sync() {
+        CheckWritable();
+        if (::msync(map_, mapped_bytes_, MS_SYNC) != 0) {
+            ThrowSystemError("msync");
+        }
+    }
+
+    void Swap(MappedVector& rhs) noexcept {
+        std::swap(read_only_, rhs.read_only_);
+        std::swap(fd_, rhs.fd_);
+        std::swap(map_, rhs.map_);
+        std::swap(mapped_bytes_, rhs.mapped_bytes_);
+    }
+
+private:
+    bool read_only_ = false;
+    int fd_ = -1;
+    std::byte* map_ = nullptr;
+    size_t mapped_bytes_ = 0;
+
+    [[noreturn]] static void ThrowSystemError(const char* what) {
+        throw std::system_error(errno, std::generic_category(), what);
+    }
+
+    // Изменение вектора, открытого только для чтения, - ошибка программы, которая не должна исчезать в релизной сборке
+    void CheckWritable() const {
+        if (read_only_) {
+            throw std::logic_error("MappedVector is opened read-only");
+        }
+    }
+
+    Header* GetHeader() noexcept {
+        return reinterpret_cast<Header*>(map_);
+    }
+
+    const Header* GetHeader() const noexcept {
+        return reinterpret_cast<const Header*>(map_);
+    }
+
+    T* Data() noexcept {
+        return reinterpret_cast<T*>(map_ + HEADER_BYTES);
+    }
+
+    const T* Data() const noexcept {
+        return reinterpret_cast<const T*>(map_ + HEADER_BYTES);
+    }
+
+    size_t NextCapacity(size_t required) const noexcept {
+        return DoublingGrowth::NextCapacity<T>(Capacity(), required);
+    }
+
+    void Truncate(size_t bytes) {
+        if (::ftruncate(fd_, static_cast<off_t>(bytes)) != 0) {
+            ThrowSystemError("ftruncate");
+        }
+    }
+
+    void Map(size_t bytes) {
+        const int protection = read_only_ ? PROT_READ : PROT_READ | PROT_WRITE;
+        void* map = ::mmap(nullptr, bytes, protection, MAP_SHARED, fd_, 0);
+        if (map == MAP_FAILED) {
+            ThrowSystemError("mmap");
+        }
+        map_ = static_cast<std::byte*>(map);
+        mapped_bytes_ = bytes;
+    }
+
+    // Расширяет отображение до bytes байт. При исключении старое отображение не меняется
+    void Remap(size_t bytes) {
+#ifdef __linux__
+        void* map = ::mremap(map_, mapped_bytes_, bytes, MREMAP_MAYMOVE);
+        if (map == MAP_FAILED) {
+            ThrowSystemError("mremap");
+        }
+        map_ = static_cast<std::byte*>(map);
+        mapped_bytes_ = bytes;
+#else
+        std::byte* old_map = map_;
+        const size_t old_bytes = mapped_bytes_;
+        Map(bytes);
+        ::munmap(old_map, old_bytes);
+#endif
+    }
+
+    void Close() noexcept {
+        if (map_ != nullptr) {
+            ::munmap(map_, mapped_bytes_);
+            map_ = nullptr;
+            mapped_bytes_ = 0;
+        }
+        if (fd_ >= 0) {
+            ::close(fd_);
+            fd_ = -1;
+        }
+    }
+};
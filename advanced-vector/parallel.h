@@ -0,0 +1,62 @@
+#pragma once
+
+#include "vector.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+// Исполнитель ChunkExecutor на потоках std::thread, которые живут один вызов Run. Создание потоков занимает
+// десятки микросекунд и окупается на массивах, которые Vector вообще решит делить на куски (от сотен килобайт).
+// Если в программе уже есть пул потоков, его можно подключить собственной реализацией ChunkExecutor:
+//     ThreadExecutor pool;
+//     Vector<State> checkpoint(Parallel(pool), state);
+class ThreadExecutor {
+public:
+    explicit ThreadExecutor(size_t threads = DefaultConcurrency()) noexcept
+        : threads_(std::max<size_t>(threads, 1)) {
+    }
+
+    size_t Concurrency() const noexcept {
+        return threads_;
+    }
+
+    // Вызывающий поток тоже выполняет задачи, поэтому если новый поток создать не удалось, работа всё равно будет сделана
+    template <typename Task>
+    void Run(size_t tasks, Task& task) const noexcept {
+        if (tasks == 0) {
+            return;
+        }
+
+        std::atomic<size_t> next = 0;
+        const auto work = [&next, &task, tasks]() noexcept {
+            for (size_t i = next.fetch_add(1, std::memory_order_relaxed); i < tasks;
+                 i = next.fetch_add(1, std::memory_order_relaxed)) {
+                task(i);
+            }
+        };
+
+        std::vector<std::thread> workers;
+        try {
+            const size_t helpers = std::min(threads_, tasks) - 1;
+            workers.reserve(helpers);
+            for (size_t i = 0; i < helpers; ++i) {
+                workers.emplace_back(work);
+            }
+        } catch (...) {
+        }
+        work();
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
+    }
+
+    static size_t DefaultConcurrency() noexcept {
+        return std::max<size_t>(std::thread::hardware_concurrency(), 1);
+    }
+
+private:
+    size_t threads_;
+};
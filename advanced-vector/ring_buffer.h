@@ -0,0 +1,470 @@
+#pragma once
+
+#include "vector.h"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <span>
+#include <type_traits>
+#include <utility>
+
+namespace detail {
+
+// Индексы, которые меняют разные потоки, разнесены по разным кэш-линиям, чтобы не было ложного разделения
+inline constexpr size_t CACHE_LINE_SIZE = 64;
+
+// Ожидание события кольцевого буфера через std::atomic::wait (futex в Linux).
+// Ждущий поток регистрируется в waiters_, и сигналящий поток будит его, только если кто-то ждёт: в неблокирующем
+// буфере (Enabled == false) класс пуст и ничего не стоит
+template <bool Enabled>
+class RingWaiter {
+public:
+    void Notify() noexcept {
+    }
+};
+
+template <>
+class RingWaiter<true> {
+public:
+    // Повторяет attempt(), пока та не вернёт true, засыпая между попытками. Барьер после регистрации в паре
+    // с барьером в Notify гарантирует, что либо повторная попытка увидит изменение, либо Notify увидит ждущего.
+    // Эпоха читается с acquire: если она уже увеличена Notify, чтение синхронизируется с его барьером, и повторная
+    // попытка видит опубликованный индекс. С relaxed на ARM и POWER она могла бы увидеть старый индекс и уснуть
+    // на новой эпохе, которую уже никто не разбудит
+    template <typename Attempt>
+    void WaitUntil(Attempt attempt) {
+        while (!attempt()) {
+            waiters_.fetch_add(1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            const uint32_t epoch = epoch_.load(std::memory_order_acquire);
+            const bool done = attempt();
+            if (!done) {
+                epoch_.wait(epoch, std::memory_order_acquire);
+            }
+            waiters_.fetch_sub(1, std::memory_order_relaxed);
+            if (done) {
+                return;
+            }
+        }
+    }
+
+    void Notify() noexcept {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (waiters_.load(std::memory_order_relaxed) != 0) {
+            epoch_.fetch_add(1, std::memory_order_relaxed);
+            epoch_.notify_all();
+        }
+    }
+
+private:
+    std::atomic<uint32_t> epoch_ = 0;
+    std::atomic<uint32_t> waiters_ = 0;
+};
+
+}  // namespace detail
+
+// Кольцевой буфер на RawMemory для одного потока-производителя и одного потока-потребителя, без блокировок.
+// Ёмкость округляется вверх до степени двойки, и позиция в буфере - это индекс по маске. Индексы только растут,
+// поэтому заполненность - просто их разность. Каждая сторона помнит последний виденный индекс другой стороны
+// и перечитывает чужую кэш-линию, только когда по запомненному значению места (или элементов) не хватает.
+// Пакетный обмен без копирования: PushN отдаёт производителю непрерывный кусок свободных ячеек, в который можно
+// писать напрямую, PopN - потребителю непрерывный кусок готовых элементов; CommitPush/CommitPop публикуют
+// обработанное начало куска. Так один буфер переиспользуется для всех пакетов, а не выделяется Vector на каждый.
+// С Blocking == true доступны ждущие Push/Pop: поток засыпает на std::atomic::wait, пока не появится место
+// или элемент; без него буфер не тратит на это ни одной инструкции
+//     SpscRingBuffer<Tick> ticks(4096);
+//     // производитель                        // потребитель
+//     std::span<Tick> slots = ticks.PushN(64); std::span<Tick> batch = ticks.PopN(64);
+//     size_t n = Decode(packet, slots);        Process(batch);
+//     ticks.CommitPush(slots.first(n));        ticks.CommitPop(batch);
+template <typename T, typename Allocator = std::allocator<T>, bool Blocking = false>
+class SpscRingBuffer {
+public:
+    using value_type = T;
+    using allocator_type = Allocator;
+
+    explicit SpscRingBuffer(size_t min_capacity, const Allocator& alloc = Allocator())
+        : buffer_(std::bit_ceil(std::max<size_t>(min_capacity, 1)), alloc)
+        , mask_(buffer_.Capacity() - 1) {
+    }
+
+    SpscRingBuffer(const SpscRingBuffer&) = delete;
+    SpscRingBuffer& operator=(const SpscRingBuffer&) = delete;
+
+    ~SpscRingBuffer() {
+        const size_t tail = tail_.load(std::memory_order_relaxed);
+        for (size_t head = head_.load(std::memory_order_relaxed); head != tail; ++head) {
+            std::destroy_at(Slot(head));
+        }
+    }
+
+    size_t Capacity() const noexcept {
+        return mask_ + 1;
+    }
+
+    // Число элементов в момент вызова; точно только для самих производителя и потребителя
+    size_t Size() const noexcept {
+        const size_t head = head_.load(std::memory_order_acquire);
+        return tail_.load(std::memory_order_acquire) - head;
+    }
+
+    // Методы производителя
+
+    // Создаёт элемент в конце очереди или возвращает false, если места нет.
+    // Если конструктор бросил исключение, очередь не меняется
+    template <typename... Args>
+    bool TryEmplace(Args&&... args) {
+        const size_t tail = tail_.load(std::memory_order_relaxed);
+        if (FreeSlots(tail, 1) == 0) {
+            return false;
+        }
+        std::construct_at(Slot(tail), std::forward<Args>(args)...);
+        PublishPush(tail + 1);
+        return true;
+    }
+
+    bool TryPush(const T& value) {
+        return TryEmplace(value);
+    }
+
+    bool TryPush(T&& value) {
+        return TryEmplace(std::move(value));
+    }
+
+    // До max свободных ячеек подряд, начиная с конца очереди (меньше, если места нет или кусок упирается в конец
+    // буфера). Ячейки не инициализированы, поэтому T должен быть тривиально копируемым
+    std::span<T> PushN(size_t max) requires std::is_trivially_copyable_v<T> {
+        const size_t tail = tail_.load(std::memory_order_relaxed);
+        const size_t count = std::min(FreeSlots(tail, max), Capacity() - (tail & mask_));
+        return {Slot(tail), std::min(count, max)};
+    }
+
+    // Публикует заполненные ячейки: начало куска, полученного от последнего PushN
+    void CommitPush(std::span<T> batch) requires std::is_trivially_copyable_v<T> {
+        const size_t tail = tail_.load(std::memory_order_relaxed);
+        ADVANCED_VECTOR_CHECK_BOUNDS(batch.empty() || batch.data() == Slot(tail));
+        PublishPush(tail + batch.size());
+    }
+
+    // Методы потребителя
+
+    std::optional<T> TryPop() {
+        const size_t head = head_.load(std::memory_order_relaxed);
+        if (ReadySlots(head, 1) == 0) {
+            return std::nullopt;
+        }
+        T* slot = Slot(head);
+        std::optional<T> result(std::move(*slot));
+        std::destroy_at(slot);
+        PublishPop(head + 1);
+        return result;
+    }
+
+    // До max готовых элементов подряд, начиная с начала очереди. Элементы остаются в буфере до CommitPop
+    std::span<T> PopN(size_t max) {
+        const size_t head = head_.load(std::memory_order_relaxed);
+        const size_t count = std::min(ReadySlots(head, max), Capacity() - (head & mask_));
+        return {Slot(head), std::min(count, max)};
+    }
+
+    // Разрушает обработанные элементы - начало куска, полученного от последнего PopN, - и освобождает их ячейки
+    void CommitPop(std::span<T> batch) {
+        const size_t head = head_.load(std::memory_order_relaxed);
+        ADVANCED_VECTOR_CHECK_BOUNDS(batch.empty() || batch.data() == Slot(head));
+        std::destroy(batch.begin(), batch.end());
+        PublishPop(head + batch.size());
+    }
+
+    // Ждущие варианты: производитель спит, пока очередь полна, потребитель - пока она пуста
+
+    // Неудачная попытка TryEmplace не трогает аргументы, поэтому их можно передавать дальше при каждой попытке
+    template <typename... Args>
+    void Emplace(Args&&... args) requires Blocking {
+        not_full_.WaitUntil([&] {
+            return TryEmplace(std::forward<Args>(args)...);
+        });
+    }
+
+    void Push(const T& value) requires Blocking {
+        Emplace(value);
+    }
+
+    // Значение перемещается, только когда для него нашлось место
+    void Push(T&& value) requires Blocking {
+        not_full_.WaitUntil([&] {
+            return TryEmplace(std::move(value));
+        });
+    }
+
+    T Pop() requires Blocking {
+        std::optional<T> result;
+        not_empty_.WaitUntil([&] {
+            result = TryPop();
+            return result.has_value();
+        });
+        return std::move(*result);
+    }
+
+private:
+    RawMemory<T, Allocator> buffer_;
+    const size_t mask_;
+
+    // Линия производителя: свой индекс и последний виденный индекс потребителя
+    alignas(detail::CACHE_LINE_SIZE) std::atomic<size_t> tail_ = 0;
+    size_t cached_head_ = 0;
+
+    // Линия потребителя
+    alignas(detail::CACHE_LINE_SIZE) std::atomic<size_t> head_ = 0;
+    size_t cached_tail_ = 0;
+
+    alignas(detail::CACHE_LINE_SIZE) [[no_unique_address]] detail::RingWaiter<Blocking> not_empty_;
+    [[no_unique_address]] detail::RingWaiter<Blocking> not_full_;
+
+    T* Slot(size_t index) noexcept {
+        return buffer_.GetAddress() + (index & mask_);
+    }
+
+    // Свободные ячейки для производителя; индекс потребителя перечитывается, только если запомненного мало
+    size_t FreeSlots(size_t tail, size_t wanted) noexcept {
+        if (Capacity() - (tail - cached_head_) < wanted) {
+            cached_head_ = head_.load(std::memory_order_acquire);
+        }
+        return Capacity() - (tail - cached_head_);
+    }
+
+    size_t ReadySlots(size_t head, size_t wanted) noexcept {
+        if (cached_tail_ - head < wanted) {
+            cached_tail_ = tail_.load(std::memory_order_acquire);
+        }
+        return cached_tail_ - head;
+    }
+
+    void PublishPush(size_t new_tail) noexcept {
+        tail_.store(new_tail, std::memory_order_release);
+        not_empty_.Notify();
+    }
+
+    void PublishPop(size_t new_head) noexcept {
+        head_.store(new_head, std::memory_order_release);
+        not_full_.Notify();
+    }
+};
+
+// Кольцевой буфер для многих производителей и многих потребителей без блокировок (очередь Вьюкова).
+// У каждой ячейки есть номер последовательности: ячейка свободна для записи с номером pos, когда её номер равен pos,
+// и готова к чтению, когда он равен pos + 1. Поток захватывает позицию одним CAS по общему индексу, после чего
+// работает со своей ячейкой, не мешая остальным; медленный поток задерживает только свою ячейку.
+// PushN/PopN захватывают сразу несколько свободных (готовых) ячеек подряд одним CAS, но в отличие от
+// SpscRingBuffer захваченный кусок нужно отдать в CommitPush/CommitPop целиком: другие потоки уже работают за ним.
+// Перемещение T не должно бросать исключений: элемент, для которого захвачена ячейка, обязан в неё попасть
+template <typename T, typename Allocator = std::allocator<T>, bool Blocking = false>
+class MpmcRingBuffer {
+    static_assert(std::is_nothrow_move_constructible_v<T>, "MpmcRingBuffer elements must be nothrow movable");
+
+public:
+    using value_type = T;
+    using allocator_type = Allocator;
+
+    explicit MpmcRingBuffer(size_t min_capacity, const Allocator& alloc = Allocator())
+        : buffer_(std::bit_ceil(std::max<size_t>(min_capacity, 1)), alloc)
+        , mask_(buffer_.Capacity() - 1)
+        , sequences_(std::make_unique<std::atomic<size_t>[]>(buffer_.Capacity())) {
+        for (size_t i = 0; i < buffer_.Capacity(); ++i) {
+            sequences_[i].store(i, std::memory_order_relaxed);
+        }
+    }
+
+    MpmcRingBuffer(const MpmcRingBuffer&) = delete;
+    MpmcRingBuffer& operator=(const MpmcRingBuffer&) = delete;
+
+    // Вызывается, когда другие потоки уже не работают с буфером: разрушает опубликованные элементы
+    ~MpmcRingBuffer() {
+        const size_t end = enqueue_pos_.load(std::memory_order_relaxed);
+        for (size_t pos = dequeue_pos_.load(std::memory_order_relaxed); pos != end; ++pos) {
+            if (Sequence(pos).load(std::memory_order_relaxed) == pos + 1) {
+                std::destroy_at(Slot(pos));
+            }
+        }
+    }
+
+    size_t Capacity() const noexcept {
+        return mask_ + 1;
+    }
+
+    // Приблизительное число элементов: захваченные, но ещё не опубликованные ячейки тоже считаются
+    size_t Size() const noexcept {
+        const size_t dequeued = dequeue_pos_.load(std::memory_order_acquire);
+        const size_t enqueued = enqueue_pos_.load(std::memory_order_acquire);
+        return enqueued > dequeued ? enqueued - dequeued : 0;
+    }
+
+    // Конструктор, который может бросить, выполняется до захвата ячейки, и при исключении очередь не меняется
+    template <typename... Args>
+    bool TryEmplace(Args&&... args) {
+        if constexpr (std::is_nothrow_constructible_v<T, Args&&...>) {
+            const ClaimedRange claimed = Claim(enqueue_pos_, 0, 1);
+            if (claimed.count == 0) {
+                return false;
+            }
+            std::construct_at(Slot(claimed.pos), std::forward<Args>(args)...);
+            Sequence(claimed.pos).store(claimed.pos + 1, std::memory_order_release);
+            not_empty_.Notify();
+            return true;
+        } else {
+            T value(std::forward<Args>(args)...);
+            return TryEmplace(std::move(value));
+        }
+    }
+
+    bool TryPush(const T& value) {
+        return TryEmplace(value);
+    }
+
+    bool TryPush(T&& value) {
+        return TryEmplace(std::move(value));
+    }
+
+    std::optional<T> TryPop() {
+        const ClaimedRange claimed = Claim(dequeue_pos_, 1, 1);
+        if (claimed.count == 0) {
+            return std::nullopt;
+        }
+        T* slot = Slot(claimed.pos);
+        std::optional<T> result(std::move(*slot));
+        std::destroy_at(slot);
+        Sequence(claimed.pos).store(claimed.pos + Capacity(), std::memory_order_release);
+        not_full_.Notify();
+        return result;
+    }
+
+    // Захватывает до max свободных ячеек подряд (Т - тривиально копируемый, ячейки не инициализированы).
+    // Весь кусок нужно заполнить и отдать в CommitPush
+    std::span<T> PushN(size_t max) requires std::is_trivially_copyable_v<T> {
+        const ClaimedRange claimed = Claim(enqueue_pos_, 0, max);
+        return {Slot(claimed.pos), claimed.count};
+    }
+
+    void CommitPush(std::span<T> batch) requires std::is_trivially_copyable_v<T> {
+        Advance(batch, 1);
+        not_empty_.Notify();
+    }
+
+    // Захватывает до max готовых элементов подряд. Весь кусок нужно отдать в CommitPop
+    std::span<T> PopN(size_t max) {
+        const ClaimedRange claimed = Claim(dequeue_pos_, 1, max);
+        return {Slot(claimed.pos), claimed.count};
+    }
+
+    void CommitPop(std::span<T> batch) {
+        std::destroy(batch.begin(), batch.end());
+        Advance(batch, mask_);
+        not_full_.Notify();
+    }
+
+    template <typename... Args>
+    void Emplace(Args&&... args) requires Blocking {
+        T value(std::forward<Args>(args)...);
+        not_full_.WaitUntil([&] {
+            return TryEmplace(std::move(value));
+        });
+    }
+
+    void Push(const T& value) requires Blocking {
+        Emplace(value);
+    }
+
+    void Push(T&& value) requires Blocking {
+        not_full_.WaitUntil([&] {
+            return TryEmplace(std::move(value));
+        });
+    }
+
+    T Pop() requires Blocking {
+        std::optional<T> result;
+        not_empty_.WaitUntil([&] {
+            result = TryPop();
+            return result.has_value();
+        });
+        return std::move(*result);
+    }
+
+private:
+    RawMemory<T, Allocator> buffer_;
+    const size_t mask_;
+    std::unique_ptr<std::atomic<size_t>[]> sequences_;
+
+    alignas(detail::CACHE_LINE_SIZE) std::atomic<size_t> enqueue_pos_ = 0;
+    alignas(detail::CACHE_LINE_SIZE) std::atomic<size_t> dequeue_pos_ = 0;
+
+    alignas(detail::CACHE_LINE_SIZE) [[no_unique_address]] detail::RingWaiter<Blocking> not_empty_;
+    [[no_unique_address]] detail::RingWaiter<Blocking> not_full_;
+
+    T* Slot(size_t pos) noexcept {
+        return buffer_.GetAddress() + (pos & mask_);
+    }
+
+    std::atomic<size_t>& Sequence(size_t pos) noexcept {
+        return sequences_[pos & mask_];
+    }
+
+    // Ячейка pos доступна, когда её номер равен pos + lag (0 для записи, 1 для чтения)
+    bool IsAvailable(size_t pos, size_t lag) noexcept {
+        return Sequence(pos).load(std::memory_order_acquire) == pos + lag;
+    }
+
+    // Число доступных ячеек подряд начиная с pos, но не больше max и не дальше конца буфера
+    size_t AvailableCount(size_t pos, size_t lag, size_t max) noexcept {
+        const size_t limit = std::min(max, Capacity() - (pos & mask_));
+        size_t count = 0;
+        while (count < limit && IsAvailable(pos + count, lag)) {
+            ++count;
+        }
+        return count;
+    }
+
+    // Захваченные ячейки [pos, pos + count); count == 0 - ничего не захвачено
+    struct ClaimedRange {
+        size_t pos = 0;
+        size_t count = 0;
+    };
+
+    // Захватывает позицию индекса index и до max доступных ячеек за ней. Длина куска - ровно та, на которую
+    // сдвинул индекс успешный CAS: ячейки дальше могли с тех пор освободиться, но их уже захватывают другие потоки.
+    // Пустой результат - первая ячейка ещё занята (буфер полон или пуст)
+    ClaimedRange Claim(std::atomic<size_t>& index, size_t lag, size_t max) noexcept {
+        if (max == 0) {
+            return {};
+        }
+        size_t pos = index.load(std::memory_order_relaxed);
+        for (;;) {
+            const size_t sequence = Sequence(pos).load(std::memory_order_acquire);
+            const auto diff = static_cast<std::ptrdiff_t>(sequence - (pos + lag));
+            if (diff == 0) {
+                const size_t count = AvailableCount(pos, lag, max);
+                if (count != 0 && index.compare_exchange_weak(pos, pos + count, std::memory_order_relaxed)) {
+                    return {pos, count};
+                }
+            } else if (diff < 0) {
+                // Ячейку pos ещё не освободил (не заполнил) поток, прошедший по буферу кругом раньше
+                return {};
+            } else {
+                pos = index.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Номер захваченной ячейки - её позиция (для записи) или позиция + 1 (для чтения), поэтому следующий номер
+    // получается прибавлением step: 1 после записи и Capacity() - 1 после чтения
+    void Advance(std::span<T> batch, size_t step) noexcept {
+        const size_t first = batch.data() - buffer_.GetAddress();
+        for (size_t i = 0; i < batch.size(); ++i) {
+            std::atomic<size_t>& sequence = sequences_[first + i];
+            sequence.store(sequence.load(std::memory_order_relaxed) + step, std::memory_order_release);
+        }
+    }
+};
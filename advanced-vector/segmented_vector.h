@@ -0,0 +1,412 @@
+#pragma once
+
+#include "vector.h"
+
+#include <algorithm>
+#include <bit>
+#include <compare>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <span>
+#include <type_traits>
+#include <utility>
+
+namespace detail {
+
+// Порядка 64 КиБ на блок, но не меньше одного элемента
+template <typename T>
+constexpr size_t DefaultChunkSize() noexcept {
+    return std::bit_floor(std::max<size_t>(64 * 1024 / sizeof(T), 1));
+}
+
+}  // namespace detail
+
+// Вектор из блоков RawMemory по ChunkSize элементов (как std::deque, но только с ростом в конец).
+// Добавление никогда не переносит уже созданные элементы: заполненный блок остаётся на месте, а новый элемент ложится
+// в следующий блок, поэтому ссылки, указатели и итераторы остаются действительными при росте, а стоимость EmplaceBack
+// не зависит от размера вектора. При росте копируется лишь таблица блоков - по указателю и ёмкости на блок.
+// ChunkSize - степень двойки, и доступ по индексу сводится к сдвигу и маске. Для внутренних циклов элементы
+// доступны блоками: Chunk(i) и ForEachChunk отдают непрерывные std::span, которые компилятор векторизует
+//     SegmentedVector<float> samples;
+//     samples.ForEachChunk([](std::span<float> chunk) { simd::Fill(chunk, 0.0f); });
+template <typename T, typename Allocator = std::allocator<T>, size_t ChunkSize = detail::DefaultChunkSize<T>()>
+class SegmentedVector {
+    static_assert(std::has_single_bit(ChunkSize), "ChunkSize must be a power of two");
+
+    using ChunkMemory = RawMemory<T, Allocator>;
+    using AllocTraits = std::allocator_traits<Allocator>;
+
+    template <bool IsConst>
+    class BasicIterator;
+
+public:
+    using value_type = T;
+    using allocator_type = Allocator;
+    using iterator = BasicIterator<false>;
+    using const_iterator = BasicIterator<true>;
+
+    static constexpr size_t CHUNK_SIZE = ChunkSize;
+    static constexpr size_t CHUNK_SHIFT = std::countr_zero(ChunkSize);
+    static constexpr size_t CHUNK_MASK = ChunkSize - 1;
+
+    SegmentedVector() = default;
+
+    explicit SegmentedVector(const Allocator& alloc) noexcept
+        : alloc_(alloc) {
+    }
+
+    explicit SegmentedVector(size_t size, const Allocator& alloc = Allocator())
+        : SegmentedVector(alloc) {
+        Resize(size);
+    }
+
+    // Делегирующие конструкторы: при исключении созданные элементы разрушит деструктор
+    SegmentedVector(const SegmentedVector& other)
+        : SegmentedVector(AllocTraits::select_on_container_copy_construction(other.alloc_)) {
+        AppendCopy(other);
+    }
+
+    SegmentedVector(SegmentedVector&& other) noexcept
+        : alloc_(other.alloc_) {
+        Swap(other);
+    }
+
+    ~SegmentedVector() {
+        Clear();
+    }
+
+    // Копия строится сразу на том аллокаторе, который останется у вектора: на аллокаторе rhs, только если этого
+    // требует propagate_on_container_copy_assignment. При исключении вектор не меняется
+    SegmentedVector& operator=(const SegmentedVector& rhs) {
+        if (this != &rhs) {
+            SegmentedVector tmp(AllocTraits::propagate_on_container_copy_assignment::value ? rhs.alloc_ : alloc_);
+            tmp.AppendCopy(rhs);
+            if constexpr (AllocTraits::propagate_on_container_copy_assignment::value) {
+                alloc_ = tmp.alloc_;
+            }
+            StealFrom(tmp);
+        }
+        return *this;
+    }
+
+    // Блоки rhs забираются, только если аллокатор переезжает вместе с ними или аллокаторы равны
+    SegmentedVector& operator=(SegmentedVector&& rhs) noexcept(AllocTraits::propagate_on_container_move_assignment::value
+                                                              || AllocTraits::is_always_equal::value) {
+        if (this == &rhs) {
+            return *this;
+        }
+
+        if constexpr (AllocTraits::propagate_on_container_move_assignment::value) {
+            alloc_ = rhs.alloc_;
+            StealFrom(rhs);
+        } else if (alloc_ == rhs.alloc_) {
+            StealFrom(rhs);
+        } else {
+            // Чужие блоки нельзя освободить своим аллокатором, поэтому элементы перемещаются по одному
+            Clear();
+            Reserve(rhs.size_);
+            rhs.ForEachChunk([this](std::span<T> chunk) {
+                for (T& elem : chunk) {
+                    EmplaceBack(std::move(elem));
+                }
+            });
+        }
+        return *this;
+    }
+
+    allocator_type GetAllocator() const noexcept {
+        return alloc_;
+    }
+
+    // Итераторы ссылаются на сам вектор, а не на таблицу блоков, поэтому переживают рост
+    iterator begin() noexcept {
+        return iterator(this, 0);
+    }
+
+    const_iterator begin() const noexcept {
+        return const_iterator(this, 0);
+    }
+
+    const_iterator cbegin() const noexcept {
+        return begin();
+    }
+
+    iterator end() noexcept {
+        return iterator(this, size_);
+    }
+
+    const_iterator end() const noexcept {
+        return const_iterator(this, size_);
+    }
+
+    const_iterator cend() const noexcept {
+        return end();
+    }
+
+    T& operator[](size_t index) noexcept {
+        ADVANCED_VECTOR_CHECK_BOUNDS(index < size_);
+        return chunks_[index >> CHUNK_SHIFT].GetAddress()[index & CHUNK_MASK];
+    }
+
+    const T& operator[](size_t index) const noexcept {
+        return const_cast<SegmentedVector&>(*this)[index];
+    }
+
+    T& Front() noexcept {
+        return (*this)[0];
+    }
+
+    const T& Front() const noexcept {
+        return (*this)[0];
+    }
+
+    T& Back() noexcept {
+        return (*this)[size_ - 1];
+    }
+
+    const T& Back() const noexcept {
+        return (*this)[size_ - 1];
+    }
+
+    size_t Size() const noexcept {
+        return size_;
+    }
+
+    size_t Capacity() const noexcept {
+        return chunks_.Size() * ChunkSize;
+    }
+
+    // Число блоков, в которых есть элементы
+    size_t ChunkCount() const noexcept {
+        return (size_ + CHUNK_MASK) >> CHUNK_SHIFT;
+    }
+
+    // Элементы блока index: непрерывный массив из ChunkSize элементов (в последнем блоке - сколько есть)
+    std::span<T> Chunk(size_t index) noexcept {
+        ADVANCED_VECTOR_CHECK_BOUNDS(index < ChunkCount());
+        return {chunks_[index].GetAddress(), std::min(ChunkSize, size_ - (index << CHUNK_SHIFT))};
+    }
+
+    std::span<const T> Chunk(size_t index) const noexcept {
+        return const_cast<SegmentedVector&>(*this).Chunk(index);
+    }
+
+    // Вызывает operation(std::span<T>) для каждого блока по порядку
+    template <typename Operation>
+    void ForEachChunk(Operation&& operation) {
+        for (size_t i = 0; i < ChunkCount(); ++i) {
+            operation(Chunk(i));
+        }
+    }
+
+    template <typename Operation>
+    void ForEachChunk(Operation&& operation) const {
+        for (size_t i = 0; i < ChunkCount(); ++i) {
+            operation(Chunk(i));
+        }
+    }
+
+    // Выделяет блоки под new_capacity элементов; существующие элементы не трогает
+    void Reserve(size_t new_capacity) {
+        const size_t chunks = (new_capacity + CHUNK_MASK) >> CHUNK_SHIFT;
+        if (chunks <= chunks_.Size()) {
+            return;
+        }
+        chunks_.Reserve(chunks);
+        while (chunks_.Size() < chunks) {
+            chunks_.EmplaceBack(ChunkSize, alloc_);
+        }
+    }
+
+    void Resize(size_t new_size) {
+        if (new_size < size_) {
+            while (size_ > new_size) {
+                PopBack();
+            }
+            return;
+        }
+        Reserve(new_size);
+        while (size_ < new_size) {
+            EmplaceBack();
+        }
+    }
+
+    // Аргументы могут ссылаться на элементы вектора: те никогда не переезжают
+    template <typename... Args>
+    T& EmplaceBack(Args&&... args) {
+        if (size_ == Capacity()) {
+            chunks_.EmplaceBack(ChunkSize, alloc_);
+        }
+        T* slot = chunks_[size_ >> CHUNK_SHIFT].GetAddress() + (size_ & CHUNK_MASK);
+        std::construct_at(slot, std::forward<Args>(args)...);
+        ++size_;
+        return *slot;
+    }
+
+    void PushBack(const T& value) {
+        EmplaceBack(value);
+    }
+
+    void PushBack(T&& value) {
+        EmplaceBack(std::move(value));
+    }
+
+    void PopBack() noexcept {
+        ADVANCED_VECTOR_CHECK_BOUNDS(size_ != 0);
+        std::destroy_at(&Back());
+        --size_;
+    }
+
+    // Разрушает элементы, сохраняя блоки для следующих вставок
+    void Clear() noexcept {
+        ForEachChunk([](std::span<T> chunk) {
+            std::destroy(chunk.begin(), chunk.end());
+        });
+        size_ = 0;
+    }
+
+    // Возвращает аллокатору блоки, оставшиеся без элементов
+    void ShrinkToFit() {
+        while (chunks_.Size() > ChunkCount()) {
+            chunks_.PopBack();
+        }
+        chunks_.ShrinkToFit();
+    }
+
+    void Swap(SegmentedVector& rhs) noexcept {
+        using std::swap;
+        if constexpr (std::allocator_traits<Allocator>::propagate_on_container_swap::value) {
+            swap(alloc_, rhs.alloc_);
+        } else {
+            ADVANCED_VECTOR_CHECK_DEBUG(alloc_ == rhs.alloc_);
+        }
+        chunks_.Swap(rhs.chunks_);
+        swap(size_, rhs.size_);
+    }
+
+private:
+    [[no_unique_address]] Allocator alloc_ = Allocator();
+    Vector<ChunkMemory> chunks_;
+    size_t size_ = 0;
+
+    // Копирует элементы other в конец вектора, выделяя блоки своим аллокатором
+    void AppendCopy(const SegmentedVector& other) {
+        Reserve(size_ + other.size_);
+        other.ForEachChunk([this](std::span<const T> chunk) {
+            for (const T& elem : chunk) {
+                EmplaceBack(elem);
+            }
+        });
+    }
+
+    // Разрушает свои элементы и забирает блоки other; каждый блок освобождается аллокатором, которым был выделен
+    void StealFrom(SegmentedVector& other) noexcept {
+        Clear();
+        chunks_ = std::move(other.chunks_);
+        size_ = std::exchange(other.size_, 0);
+    }
+};
+
+template <typename T, typename Allocator, size_t ChunkSize>
+template <bool IsConst>
+class SegmentedVector<T, Allocator, ChunkSize>::BasicIterator {
+    using Owner = std::conditional_t<IsConst, const SegmentedVector, SegmentedVector>;
+
+public:
+    using value_type = T;
+    using reference = std::conditional_t<IsConst, const T&, T&>;
+    using pointer = std::conditional_t<IsConst, const T*, T*>;
+    using difference_type = std::ptrdiff_t;
+    using iterator_category = std::random_access_iterator_tag;
+
+    BasicIterator() = default;
+
+    // Неконстантный итератор приводится к константному
+    template <bool OtherConst>
+        requires(IsConst && !OtherConst)
+    BasicIterator(const BasicIterator<OtherConst>& other) noexcept
+        : owner_(other.owner_)
+        , index_(other.index_) {
+    }
+
+    reference operator*() const noexcept {
+        return (*owner_)[static_cast<size_t>(index_)];
+    }
+
+    pointer operator->() const noexcept {
+        return &**this;
+    }
+
+    reference operator[](difference_type offset) const noexcept {
+        return *(*this + offset);
+    }
+
+    BasicIterator& operator++() noexcept {
+        ++index_;
+        return *this;
+    }
+
+    BasicIterator operator++(int) noexcept {
+        BasicIterator prev = *this;
+        ++index_;
+        return prev;
+    }
+
+    BasicIterator& operator--() noexcept {
+        --index_;
+        return *this;
+    }
+
+    BasicIterator operator--(int) noexcept {
+        BasicIterator prev = *this;
+        --index_;
+        return prev;
+    }
+
+    BasicIterator& operator+=(difference_type offset) noexcept {
+        index_ += offset;
+        return *this;
+    }
+
+    BasicIterator& operator-=(difference_type offset) noexcept {
+        index_ -= offset;
+        return *this;
+    }
+
+    friend BasicIterator operator+(BasicIterator it, difference_type offset) noexcept {
+        return it += offset;
+    }
+
+    friend BasicIterator operator+(difference_type offset, BasicIterator it) noexcept {
+        return it += offset;
+    }
+
+    friend BasicIterator operator-(BasicIterator it, difference_type offset) noexcept {
+        return it -= offset;
+    }
+
+    friend difference_type operator-(const BasicIterator& lhs, const BasicIterator& rhs) noexcept {
+        return lhs.index_ - rhs.index_;
+    }
+
+    friend bool operator==(const BasicIterator& lhs, const BasicIterator& rhs) noexcept {
+        return lhs.index_ == rhs.index_;
+    }
+
+    friend std::strong_ordering operator<=>(const BasicIterator& lhs, const BasicIterator& rhs) noexcept {
+        return lhs.index_ <=> rhs.index_;
+    }
+
+private:
+    friend class SegmentedVector;
+    friend class BasicIterator<!IsConst>;
+
+    BasicIterator(Owner* owner, difference_type index) noexcept
+        : owner_(owner)
+        , index_(index) {
+    }
+
+    Owner* owner_ = nullptr;
+    difference_type index_ = 0;
+};
@@ -0,0 +1,380 @@
+#pragma once
+
+#include "vector.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+// Вектор, хранящий до N элементов прямо в объекте и переезжающий в RawMemory только при переполнении.
+// Семантика Emplace/Erase/Reserve и гарантии безопасности исключений такие же, как у Vector
+template <typename T, size_t N, typename Allocator = std::allocator<T>, typename GrowthPolicy = DoublingGrowth>
+class SmallVector {
+    using AllocTraits = std::allocator_traits<Allocator>;
+
+    static_assert(N > 0, "Use Vector for containers without inline storage");
+
+public:
+    using iterator = T*;
+    using const_iterator = const T*;
+    using allocator_type = Allocator;
+
+    SmallVector() = default;
+
+    explicit SmallVector(const Allocator& alloc) noexcept
+        : heap_(alloc) {
+    }
+
+    explicit SmallVector(size_t size, const Allocator& alloc = Allocator())
+        : heap_(alloc) {
+        ReserveExact(size);
+        std::uninitialized_value_construct_n(begin(), size);
+        size_ = size;
+    }
+
+    explicit SmallVector(size_t size, const T& value, const Allocator& alloc = Allocator())
+        : heap_(alloc) {
+        ReserveExact(size);
+        std::uninitialized_fill_n(begin(), size, value);
+        size_ = size;
+    }
+
+    SmallVector(std::initializer_list<T> values, const Allocator& alloc = Allocator())
+        : SmallVector(values.begin(), values.end(), alloc) {
+    }
+
+    // Ограничение на итераторы не даёт SmallVector(5, 7) выбрать этот конструктор вместо (количество, значение)
+    template <std::input_iterator Iter>
+    explicit SmallVector(Iter first, Iter last, const Allocator& alloc = Allocator())
+        : heap_(alloc) {
+        if constexpr (detail::MultiPassIterator<Iter>) {
+            const size_t size = std::distance(first, last);
+            ReserveExact(size);
+            std::uninitialized_copy(first, last, begin());
+            size_ = size;
+        } else {
+            // Деструктор не вызывается для недостроенного объекта, поэтому созданные элементы разрушаются здесь
+            try {
+                for (; first != last; ++first) {
+                    EmplaceBack(*first);
+                }
+            } catch (...) {
+                Clear();
+                throw;
+            }
+        }
+    }
+
+    SmallVector(const SmallVector& other)
+        : SmallVector(other, AllocTraits::select_on_container_copy_construction(other.GetAllocator())) {
+    }
+
+    SmallVector(const SmallVector& other, const Allocator& alloc)
+        : SmallVector(other.begin(), other.end(), alloc) {
+    }
+
+    // Буфер в куче забирается целиком, а встроенные элементы переносятся по одному
+    SmallVector(SmallVector&& other) noexcept(std::is_nothrow_move_constructible_v<T>)
+        : heap_(other.GetAllocator()) {
+        StealFrom(other);
+    }
+
+    ~SmallVector() {
+        std::destroy_n(begin(), size_);
+    }
+
+    SmallVector& operator=(const SmallVector& rhs) {
+        if (this == &rhs) {
+            return *this;
+        }
+
+        if (Capacity() >= rhs.size_) {
+            // До этой позиции будет присваивание, а после - разрушение или инициализация
+            size_t min_size = std::min(size_, rhs.size_);
+            std::copy_n(rhs.begin(), min_size, begin());
+
+            if (size_ > rhs.size_) {
+                std::destroy(begin() + min_size, end());
+            } else {
+                std::uninitialized_copy(rhs.begin() + min_size, rhs.end(), begin() + min_size);
+            }
+            size_ = rhs.size_;
+        } else {
+            SmallVector tmp(rhs, GetAllocator());
+            Clear();
+            StealFrom(tmp);
+        }
+
+        return *this;
+    }
+
+    SmallVector& operator=(SmallVector&& rhs) noexcept(std::is_nothrow_move_constructible_v<T>
+                                                       && AllocTraits::is_always_equal::value) {
+        if (this != &rhs) {
+            Clear();
+            StealFrom(rhs);
+        }
+
+        return *this;
+    }
+
+    allocator_type GetAllocator() const noexcept {
+        return heap_.GetAllocator();
+    }
+
+    iterator begin() noexcept {
+        return IsInline() ? InlineData() : heap_.GetAddress();
+    }
+
+    const_iterator begin() const noexcept {
+        return const_cast<SmallVector&>(*this).begin();
+    }
+
+    const_iterator cbegin() const noexcept {
+        return begin();
+    }
+
+    iterator end() noexcept {
+        return begin() + size_;
+    }
+
+    const_iterator end() const noexcept {
+        return begin() + size_;
+    }
+
+    const_iterator cend() const noexcept {
+        return end();
+    }
+
+    T& Front() noexcept {
+        ADVANCED_VECTOR_CHECK_BOUNDS(size_ != 0);
+        return *begin();
+    }
+
+    const T& Front() const noexcept {
+        ADVANCED_VECTOR_CHECK_BOUNDS(size_ != 0);
+        return *begin();
+    }
+
+    T& Back() noexcept {
+        ADVANCED_VECTOR_CHECK_BOUNDS(size_ != 0);
+        return *std::prev(end());
+    }
+
+    const T& Back() const noexcept {
+        ADVANCED_VECTOR_CHECK_BOUNDS(size_ != 0);
+        return *std::prev(end());
+    }
+
+    void Reserve(size_t new_capacity) {
+        if (new_capacity <= Capacity()) {
+            return;
+        }
+
+        RawMemory<T, Allocator> new_heap(new_capacity, heap_.GetAllocator());
+        detail::RelocateData(begin(), end(), new_heap.GetAddress());
+        heap_.Swap(new_heap);
+    }
+
+    // Уменьшает ёмкость до размера, а если элементы помещаются во встроенный буфер - возвращается в него
+    void ShrinkToFit() {
+        if (IsInline() || Capacity() == size_) {
+            return;
+        }
+
+        RawMemory<T, Allocator> new_heap(heap_.GetAllocator());
+        if (size_ > N) {
+            RawMemory<T, Allocator> exact(size_, heap_.GetAllocator());
+            new_heap.Swap(exact);
+        }
+        detail::RelocateData(begin(), end(), size_ > N ? new_heap.GetAddress() : InlineData());
+        heap_.Swap(new_heap);
+    }
+
+    void Resize(size_t new_size) {
+        // Уменьшаем размер
+        if (size_ > new_size) {
+            std::destroy(begin() + new_size, end());
+            size_ = new_size;
+            return;
+        }
+
+        if (new_size > Capacity()) {
+            RawMemory<T, Allocator> new_heap(NextCapacity(new_size), heap_.GetAllocator());
+            std::uninitialized_value_construct(new_heap + size_, new_heap + new_size);
+
+            try {
+                detail::RelocateData(begin(), end(), new_heap.GetAddress());
+            } catch (...) {
+                std::destroy(new_heap + size_, new_heap + new_size);
+                throw;
+            }
+            heap_.Swap(new_heap);
+        } else {
+            std::uninitialized_value_construct(end(), begin() + new_size);
+        }
+        size_ = new_size;
+    }
+
+    template <typename... Args>
+    T& EmplaceBack(Args&&... args) {
+        if (size_ < Capacity()) {
+            std::construct_at(end(), std::forward<Args>(args)...);
+            ++size_;
+            return Back();
+        }
+        return *Emplace(end(), std::forward<Args>(args)...);
+    }
+
+    void PushBack(const T& value) {
+        EmplaceBack(value);
+    }
+
+    void PushBack(T&& value) {
+        EmplaceBack(std::move(value));
+    }
+
+    void PopBack() {
+        ADVANCED_VECTOR_CHECK_BOUNDS(size_ != 0);
+
+        std::destroy_at(&Back());
+        --size_;
+    }
+
+    template <typename... Args>
+    iterator Emplace(const_iterator it, Args&&... args) {
+        ADVANCED_VECTOR_CHECK_BOUNDS(begin() <= it && it <= end());
+        iterator non_const_it = const_cast<iterator>(it);
+        size_t it_pos = std::distance(begin(), non_const_it);
+
+        if (Capacity() == Size()) { // Встроенного места или буфера в куче не хватает
+            RawMemory<T, Allocator> new_heap(NextCapacity(size_ + 1), heap_.GetAllocator());
+            detail::EmplaceRelocating(begin(), non_const_it, end(), new_heap.GetAddress(), std::forward<Args>(args)...);
+            heap_.Swap(new_heap);
+        } else {
+            detail::EmplaceShifting(non_const_it, end(), std::forward<Args>(args)...);
+        }
+        ++size_;
+
+        return std::next(begin(), it_pos);
+    }
+
+    iterator Insert(const_iterator it, const T& val) {
+        return Emplace(it, val);
+    }
+
+    iterator Insert(const_iterator it, T&& val) {
+        return Emplace(it, std::move(val));
+    }
+
+    iterator Erase(const_iterator it) {
+        ADVANCED_VECTOR_CHECK_BOUNDS(begin() <= it && it < end());
+
+        iterator non_const_it = const_cast<iterator>(it);
+        detail::EraseShifting(non_const_it, std::next(non_const_it), end());
+        --size_;
+
+        return non_const_it;
+    }
+
+    iterator Erase(const_iterator first, const_iterator last) {
+        ADVANCED_VECTOR_CHECK_BOUNDS(begin() <= first && first <= last && last <= end());
+
+        iterator non_const_first = const_cast<iterator>(first);
+        iterator new_end = detail::EraseShifting(non_const_first, const_cast<iterator>(last), end());
+        size_ = std::distance(begin(), new_end);
+
+        return non_const_first;
+    }
+
+    void Clear() noexcept {
+        std::destroy_n(begin(), size_);
+        size_ = 0;
+    }
+
+    size_t Size() const noexcept {
+        return size_;
+    }
+
+    size_t Capacity() const noexcept {
+        return IsInline() ? N : heap_.Capacity();
+    }
+
+    // Элементы хранятся во встроенном буфере, без обращений к аллокатору
+    bool IsInline() const noexcept {
+        return heap_.Capacity() == 0;
+    }
+
+    const T& operator[](size_t index) const noexcept {
+        return const_cast<SmallVector&>(*this)[index];
+    }
+
+    T& operator[](size_t index) noexcept {
+        ADVANCED_VECTOR_CHECK_BOUNDS(index < size_);
+        return begin()[index];
+    }
+
+    // Доступ с проверкой индекса при любом уровне проверок
+    T& At(size_t index) {
+        if (index >= size_) [[unlikely]] {
+            throw std::out_of_range("SmallVector index out of range");
+        }
+        return begin()[index];
+    }
+
+    const T& At(size_t index) const {
+        return const_cast<SmallVector&>(*this).At(index);
+    }
+
+    void Swap(SmallVector& rhs) noexcept(std::is_nothrow_move_constructible_v<T>
+                                         && AllocTraits::is_always_equal::value) {
+        SmallVector tmp(std::move(rhs));
+        rhs = std::move(*this);
+        *this = std::move(tmp);
+    }
+
+private:
+    RawMemory<T, Allocator> heap_;
+    size_t size_ = 0;
+    alignas(T) std::byte inline_data_[sizeof(T) * N];
+
+    T* InlineData() noexcept {
+        return reinterpret_cast<T*>(inline_data_);
+    }
+
+    size_t NextCapacity(size_t required) const noexcept {
+        return GrowthPolicy::template NextCapacity<T>(Capacity(), required);
+    }
+
+    // Готовит место ровно под size элементов в пустом векторе
+    void ReserveExact(size_t size) {
+        ADVANCED_VECTOR_CHECK_DEBUG(size_ == 0);
+        if (size > N) {
+            RawMemory<T, Allocator> new_heap(size, heap_.GetAllocator());
+            heap_.Swap(new_heap);
+        }
+    }
+
+    // Забирает элементы other в пустой вектор: буфер в куче - целиком, если его сможет освободить наш аллокатор,
+    // встроенные элементы - переносом по одному. После этого other пуст
+    void StealFrom(SmallVector& other) {
+        ADVANCED_VECTOR_CHECK_DEBUG(size_ == 0);
+
+        if (!other.IsInline() && GetAllocator() == other.GetAllocator()) {
+            RawMemory<T, Allocator> empty(heap_.GetAllocator());
+            heap_.Swap(empty);
+            heap_.Swap(other.heap_);
+        } else {
+            if (other.size_ > Capacity()) {
+                RawMemory<T, Allocator> new_heap(other.size_, heap_.GetAllocator());
+                heap_.Swap(new_heap);
+            }
+            detail::RelocateData(other.begin(), other.end(), begin());
+        }
+        size_ = std::exchange(other.size_, 0);
+    }
+};
@@ -0,0 +1,460 @@
+#pragma once
+
+#include "vector.h"
+
+#include <compare>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <span>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+// Вектор записей из полей Ts..., где каждое поле хранится в собственном буфере RawMemory (structure of arrays).
+// Проход по одному-двум полям читает только их столбцы, а не целые записи. Все столбцы имеют общие размер и ёмкость
+// и растут вместе за одну реаллокацию; гарантии безопасности исключений такие же, как у Vector.
+// Доступ к записи - через прокси std::tuple<Ts&...>, к столбцу целиком - через Column<I>():
+//     SoAVector<int, double> points;
+//     points.EmplaceBack(1, 2.5);
+//     auto [id, weight] = points[0];
+//     double total = std::accumulate(points.Column<1>().begin(), points.Column<1>().end(), 0.0);
+template <typename... Ts>
+class SoAVector {
+    static_assert(sizeof...(Ts) > 0, "SoAVector needs at least one field");
+
+    using Columns = std::tuple<RawMemory<Ts>...>;
+
+    template <bool IsConst>
+    class BasicIterator;
+
+public:
+    using value_type = std::tuple<Ts...>;
+    using reference = std::tuple<Ts&...>;
+    using const_reference = std::tuple<const Ts&...>;
+    using iterator = BasicIterator<false>;
+    using const_iterator = BasicIterator<true>;
+
+    template <size_t I>
+    using Field = std::tuple_element_t<I, value_type>;
+
+    static constexpr size_t FIELDS = sizeof...(Ts);
+
+    SoAVector() = default;
+
+    SoAVector(const SoAVector& other)
+        : columns_(RawMemory<Ts>(other.size_)...) {
+        ConstructColumns(
+            [this, &other]<size_t I>(std::integral_constant<size_t, I>) {
+                std::uninitialized_copy_n(other.template Data<I>(), other.size_, Data<I>());
+            },
+            [this, &other]<size_t I>(std::integral_constant<size_t, I>) {
+                std::destroy_n(Data<I>(), other.size_);
+            });
+        size_ = other.size_;
+    }
+
+    SoAVector(SoAVector&& other) noexcept {
+        Swap(other);
+    }
+
+    ~SoAVector() {
+        DestroyColumns(0, size_);
+    }
+
+    SoAVector& operator=(const SoAVector& rhs) {
+        if (this != &rhs) {
+            SoAVector tmp(rhs);
+            Swap(tmp);
+        }
+        return *this;
+    }
+
+    SoAVector& operator=(SoAVector&& rhs) noexcept {
+        if (this != &rhs) {
+            Clear();
+            Swap(rhs);
+        }
+        return *this;
+    }
+
+    iterator begin() noexcept {
+        return iterator(Pointers(), 0);
+    }
+
+    const_iterator begin() const noexcept {
+        return const_iterator(Pointers(), 0);
+    }
+
+    const_iterator cbegin() const noexcept {
+        return begin();
+    }
+
+    iterator end() noexcept {
+        return iterator(Pointers(), size_);
+    }
+
+    const_iterator end() const noexcept {
+        return const_iterator(Pointers(), size_);
+    }
+
+    const_iterator cend() const noexcept {
+        return end();
+    }
+
+    // Столбец поля I: непрерывный массив из Size() элементов
+    template <size_t I>
+    std::span<Field<I>> Column() noexcept {
+        return {Data<I>(), size_};
+    }
+
+    template <size_t I>
+    std::span<const Field<I>> Column() const noexcept {
+        return {Data<I>(), size_};
+    }
+
+    reference operator[](size_t index) noexcept {
+        ADVANCED_VECTOR_CHECK_BOUNDS(index < size_);
+        return *(begin() + index);
+    }
+
+    const_reference operator[](size_t index) const noexcept {
+        ADVANCED_VECTOR_CHECK_BOUNDS(index < size_);
+        return *(begin() + index);
+    }
+
+    reference Front() noexcept {
+        return (*this)[0];
+    }
+
+    const_reference Front() const noexcept {
+        return (*this)[0];
+    }
+
+    reference Back() noexcept {
+        return (*this)[size_ - 1];
+    }
+
+    const_reference Back() const noexcept {
+        return (*this)[size_ - 1];
+    }
+
+    void Reserve(size_t new_capacity) {
+        if (new_capacity <= Capacity()) {
+            return;
+        }
+
+        Columns new_columns{RawMemory<Ts>(new_capacity)...};
+        RelocateColumns(new_columns);
+        SwapColumns(new_columns);
+    }
+
+    // Добавляет запись, создавая каждое её поле из соответствующего аргумента
+    template <typename... Args>
+        requires(sizeof...(Args) == FIELDS)
+    reference EmplaceBack(Args&&... fields) {
+        auto args = std::forward_as_tuple(std::forward<Args>(fields)...);
+
+        if (size_ == Capacity()) {
+            // Аргументы могут ссылаться на старые элементы, поэтому новая запись создаётся до переноса столбцов
+            Columns new_columns{RawMemory<Ts>(NextCapacity(size_ + 1))...};
+            ConstructRecord(new_columns, std::move(args));
+            try {
+                RelocateColumns(new_columns);
+            } catch (...) {
+                DestroyRecord(new_columns);
+                throw;
+            }
+            SwapColumns(new_columns);
+        } else {
+            ConstructRecord(columns_, std::move(args));
+        }
+        ++size_;
+
+        return Back();
+    }
+
+    void PushBack(const Ts&... fields) {
+        EmplaceBack(fields...);
+    }
+
+    void PopBack() noexcept {
+        ADVANCED_VECTOR_CHECK_BOUNDS(size_ != 0);
+
+        DestroyColumns(size_ - 1, size_);
+        --size_;
+    }
+
+    iterator Erase(const_iterator it) {
+        ADVANCED_VECTOR_CHECK_BOUNDS(begin() <= it && it < end());
+        return Erase(it, std::next(it));
+    }
+
+    // Удаляет записи [first, last), сдвигая хвост каждого столбца один раз.
+    // Сначала выполняются присваивания во всех столбцах, которые могут бросить исключение, и лишь затем
+    // разрушаются освободившиеся хвосты: при исключении все записи остаются живыми, а размер не меняется
+    iterator Erase(const_iterator first, const_iterator last) {
+        ADVANCED_VECTOR_CHECK_BOUNDS(begin() <= first && first <= last && last <= end());
+
+        const size_t first_index = first - begin();
+        const size_t last_index = last - begin();
+        if (first_index == last_index) {
+            return begin() + first_index;
+        }
+        const size_t new_size = size_ - (last_index - first_index);
+
+        ForEachColumn([this, first_index, last_index]<size_t I>(std::integral_constant<size_t, I>) {
+            using T = Field<I>;
+            if constexpr (!IsTriviallyRelocatableV<T>) {
+                T* data = Data<I>();
+                if constexpr (std::is_nothrow_move_constructible_v<T> || !std::is_copy_constructible_v<T>) {
+                    std::move(data + last_index, data + size_, data + first_index);
+                } else {
+                    std::copy(data + last_index, data + size_, data + first_index);
+                }
+            }
+        });
+        ForEachColumn([this, first_index, last_index, new_size]<size_t I>(std::integral_constant<size_t, I>) {
+            using T = Field<I>;
+            T* data = Data<I>();
+            if constexpr (IsTriviallyRelocatableV<T>) {
+                detail::EraseShifting(data + first_index, data + last_index, data + size_);
+            } else {
+                std::destroy(data + new_size, data + size_);
+            }
+        });
+        size_ = new_size;
+
+        return begin() + first_index;
+    }
+
+    void Clear() noexcept {
+        DestroyColumns(0, size_);
+        size_ = 0;
+    }
+
+    size_t Size() const noexcept {
+        return size_;
+    }
+
+    size_t Capacity() const noexcept {
+        return std::get<0>(columns_).Capacity();
+    }
+
+    void Swap(SoAVector& rhs) noexcept {
+        SwapColumns(rhs.columns_);
+        std::swap(size_, rhs.size_);
+    }
+
+private:
+    Columns columns_;
+    size_t size_ = 0;
+
+    // Поле переносится в новый буфер без исключений; остальные перед переносом копируются, а исходники пока живы
+    template <typename T>
+    static constexpr bool RELOCATES_NOTHROW = IsTriviallyRelocatableV<T> || std::is_nothrow_move_constructible_v<T>;
+
+    template <size_t I>
+    Field<I>* Data() noexcept {
+        return std::get<I>(columns_).GetAddress();
+    }
+
+    template <size_t I>
+    const Field<I>* Data() const noexcept {
+        return std::get<I>(columns_).GetAddress();
+    }
+
+    std::tuple<Ts*...> Pointers() noexcept {
+        return std::apply([](RawMemory<Ts>&... columns) { return std::tuple<Ts*...>(columns.GetAddress()...); },
+                          columns_);
+    }
+
+    std::tuple<const Ts*...> Pointers() const noexcept {
+        return std::apply(
+            [](const RawMemory<Ts>&... columns) { return std::tuple<const Ts*...>(columns.GetAddress()...); }, columns_);
+    }
+
+    size_t NextCapacity(size_t required) const noexcept {
+        // Предел ёмкости считается по записи целиком, чтобы суммарный размер столбцов не переполнил size_t
+        return DoublingGrowth::template NextCapacity<value_type>(Capacity(), required);
+    }
+
+    // Вызывает operation(std::integral_constant<size_t, I>) для каждого столбца по порядку
+    template <typename Operation>
+    static void ForEachColumn(Operation&& operation) {
+        [&operation]<size_t... I>(std::index_sequence<I...>) {
+            (operation(std::integral_constant<size_t, I>{}), ...);
+        }(std::index_sequence_for<Ts...>{});
+    }
+
+    // Вызывает construct для каждого столбца по порядку. Если очередной вызов бросил исключение,
+    // для уже обработанных столбцов в обратном порядке вызывается rollback
+    template <size_t I = 0, typename Construct, typename Rollback>
+    static void ConstructColumns(Construct&& construct, Rollback&& rollback) {
+        if constexpr (I < FIELDS) {
+            construct(std::integral_constant<size_t, I>{});
+            try {
+                ConstructColumns<I + 1>(construct, rollback);
+            } catch (...) {
+                rollback(std::integral_constant<size_t, I>{});
+                throw;
+            }
+        }
+    }
+
+    void DestroyColumns(size_t first, size_t last) noexcept {
+        ForEachColumn([this, first, last]<size_t I>(std::integral_constant<size_t, I>) {
+            std::destroy(Data<I>() + first, Data<I>() + last);
+        });
+    }
+
+    // Создаёт в столбцах columns запись с индексом size_ из кортежа аргументов args
+    template <typename Args>
+    void ConstructRecord(Columns& columns, Args&& args) {
+        ConstructColumns(
+            [this, &columns, &args]<size_t I>(std::integral_constant<size_t, I>) {
+                std::construct_at(std::get<I>(columns) + size_, std::get<I>(std::move(args)));
+            },
+            [this, &columns]<size_t I>(std::integral_constant<size_t, I>) {
+                std::destroy_at(std::get<I>(columns) + size_);
+            });
+    }
+
+    void DestroyRecord(Columns& columns) noexcept {
+        ForEachColumn([this, &columns]<size_t I>(std::integral_constant<size_t, I>) {
+            std::destroy_at(std::get<I>(columns) + size_);
+        });
+    }
+
+    // Переносит size_ записей в неинициализированные столбцы new_columns. Сначала копируются поля, которые могут
+    // бросить исключение, и при неудаче исходные столбцы не изменены. Затем без исключений переносятся остальные
+    void RelocateColumns(Columns& new_columns) {
+        ConstructColumns(
+            [this, &new_columns]<size_t I>(std::integral_constant<size_t, I>) {
+                if constexpr (!RELOCATES_NOTHROW<Field<I>>) {
+                    detail::OverwriteData(Data<I>(), Data<I>() + size_, std::get<I>(new_columns).GetAddress());
+                }
+            },
+            [this, &new_columns]<size_t I>(std::integral_constant<size_t, I>) {
+                if constexpr (!RELOCATES_NOTHROW<Field<I>>) {
+                    std::destroy_n(std::get<I>(new_columns).GetAddress(), size_);
+                }
+            });
+
+        ForEachColumn([this, &new_columns]<size_t I>(std::integral_constant<size_t, I>) {
+            if constexpr (RELOCATES_NOTHROW<Field<I>>) {
+                detail::RelocateData(Data<I>(), Data<I>() + size_, std::get<I>(new_columns).GetAddress());
+            } else {
+                std::destroy_n(Data<I>(), size_);
+            }
+        });
+    }
+
+    void SwapColumns(Columns& other) noexcept {
+        ForEachColumn([this, &other]<size_t I>(std::integral_constant<size_t, I>) {
+            std::get<I>(columns_).Swap(std::get<I>(other));
+        });
+    }
+};
+
+// Итератор по записям, одновременно продвигающийся по всем столбцам. Разыменование даёт кортеж ссылок на поля,
+// поэтому итератор годится для стандартных алгоритмов, которые читают и присваивают записи
+template <typename... Ts>
+template <bool IsConst>
+class SoAVector<Ts...>::BasicIterator {
+    template <typename T>
+    using Ptr = std::conditional_t<IsConst, const T*, T*>;
+
+public:
+    using value_type = std::tuple<Ts...>;
+    using reference = std::conditional_t<IsConst, std::tuple<const Ts&...>, std::tuple<Ts&...>>;
+    using pointer = void;
+    using difference_type = std::ptrdiff_t;
+    using iterator_category = std::random_access_iterator_tag;
+
+    BasicIterator() = default;
+
+    // Неконстантный итератор приводится к константному
+    template <bool OtherConst>
+        requires(IsConst && !OtherConst)
+    BasicIterator(const BasicIterator<OtherConst>& other) noexcept
+        : columns_(other.columns_)
+        , index_(other.index_) {
+    }
+
+    reference operator*() const noexcept {
+        return std::apply([this](Ptr<Ts>... columns) { return reference(columns[index_]...); }, columns_);
+    }
+
+    reference operator[](difference_type offset) const noexcept {
+        return *(*this + offset);
+    }
+
+    BasicIterator& operator++() noexcept {
+        ++index_;
+        return *this;
+    }
+
+    BasicIterator operator++(int) noexcept {
+        BasicIterator prev = *this;
+        ++index_;
+        return prev;
+    }
+
+    BasicIterator& operator--() noexcept {
+        --index_;
+        return *this;
+    }
+
+    BasicIterator operator--(int) noexcept {
+        BasicIterator prev = *this;
+        --index_;
+        return prev;
+    }
+
+    BasicIterator& operator+=(difference_type offset) noexcept {
+        index_ += offset;
+        return *this;
+    }
+
+    BasicIterator& operator-=(difference_type offset) noexcept {
+        index_ -= offset;
+        return *this;
+    }
+
+    friend BasicIterator operator+(BasicIterator it, difference_type offset) noexcept {
+        return it += offset;
+    }
+
+    friend BasicIterator operator+(difference_type offset, BasicIterator it) noexcept {
+        return it += offset;
+    }
+
+    friend BasicIterator operator-(BasicIterator it, difference_type offset) noexcept {
+        return it -= offset;
+    }
+
+    friend difference_type operator-(const BasicIterator& lhs, const BasicIterator& rhs) noexcept {
+        return lhs.index_ - rhs.index_;
+    }
+
+    friend bool operator==(const BasicIterator& lhs, const BasicIterator& rhs) noexcept {
+        return lhs.index_ == rhs.index_;
+    }
+
+    friend std::strong_ordering operator<=>(const BasicIterator& lhs, const BasicIterator& rhs) noexcept {
+        return lhs.index_ <=> rhs.index_;
+    }
+
+private:
+    friend class SoAVector;
+    friend class BasicIterator<!IsConst>;
+
+    BasicIterator(std::tuple<Ptr<Ts>...> columns, difference_type index) noexcept
+        : columns_(columns)
+        , index_(index) {
+    }
+
+    std::tuple<Ptr<Ts>...> columns_;
+    difference_type index_ = 0;
+};
@@ -0,0 +1,348 @@
+#pragma once
+
+#include "vector.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+// Политики переполнения StaticVector: что делать, если элемент не помещается в N ячеек.
+// Политика - тип со статической функцией [[noreturn]] Overflow(), как политики роста у Vector
+
+// Переполнение - ошибка программиста: сообщается как нарушение границ (см. checks.h), а без проверок -
+// std::abort, без исключений и без выхода за границы буфера
+struct AssertOnOverflow {
+    [[noreturn]] static void Overflow() noexcept {
+        ADVANCED_VECTOR_CHECK_BOUNDS(false && "StaticVector capacity exceeded");
+        std::abort();
+    }
+};
+
+// Переполнение сообщается исключением std::length_error
+struct ThrowOnOverflow {
+    [[noreturn]] static void Overflow() {
+        throw std::length_error("StaticVector capacity exceeded");
+    }
+};
+
+// Вектор фиксированной ёмкости N с элементами прямо в объекте: ни одного обращения к куче и аллокатору.
+// Семантика Emplace/Erase/Resize и гарантии безопасности исключений такие же, как у Vector, только вместо
+// реаллокации при нехватке места вызывается OverflowPolicy::Overflow() - до того, как вектор изменится.
+// Для горячего пути без исключений и аварий есть TryEmplaceBack, который просто возвращает false.
+// Для тривиально копируемых T сам StaticVector тривиально копируем: копирование, перемещение и разрушение -
+// это копирование байтов объекта без циклов по элементам, а вставки и удаления сдвигают хвост через memmove
+//     StaticVector<Quote, 64> book;
+//     if (!book.TryEmplaceBack(price, volume)) {
+//         ++dropped;
+//     }
+template <typename T, size_t N, typename OverflowPolicy = AssertOnOverflow>
+class StaticVector {
+    static_assert(N > 0, "StaticVector needs at least one slot");
+
+    static constexpr bool TRIVIAL = std::is_trivially_copyable_v<T>;
+
+public:
+    using value_type = T;
+    using iterator = T*;
+    using const_iterator = const T*;
+
+    StaticVector() noexcept {
+    }
+
+    explicit StaticVector(size_t size) {
+        CheckCapacity(size);
+        detail::UninitializedValueConstruct(Data(), Data() + size);
+        size_ = size;
+    }
+
+    explicit StaticVector(size_t size, const T& value) {
+        CheckCapacity(size);
+        detail::UninitializedFill(Data(), Data() + size, value);
+        size_ = size;
+    }
+
+    StaticVector(std::initializer_list<T> values)
+        : StaticVector(values.begin(), values.end()) {
+    }
+
+    template <std::input_iterator Iter>
+    explicit StaticVector(Iter first, Iter last) {
+        if constexpr (detail::MultiPassIterator<Iter>) {
+            const size_t size = std::distance(first, last);
+            CheckCapacity(size);
+            detail::UninitializedCopy(first, last, Data());
+            size_ = size;
+        } else {
+            // Деструктор не вызывается для недостроенного объекта, поэтому созданные элементы разрушаются здесь
+            try {
+                for (; first != last; ++first) {
+                    EmplaceBack(*first);
+                }
+            } catch (...) {
+                Clear();
+                throw;
+            }
+        }
+    }
+
+    // Для тривиально копируемых T копирование и разрушение тривиальны: объект копируется целиком
+    StaticVector(const StaticVector&) requires TRIVIAL = default;
+
+    StaticVector(const StaticVector& other) {
+        detail::UninitializedCopy(other.begin(), other.end(), Data());
+        size_ = other.size_;
+    }
+
+    StaticVector(StaticVector&&) requires TRIVIAL = default;
+
+    // Элементы переносятся по одному, после чего other пуст.
+    // Если перемещение T может бросить, элементы копируются, и при исключении other не меняется
+    StaticVector(StaticVector&& other) noexcept(std::is_nothrow_move_constructible_v<T>) {
+        detail::RelocateData(other.begin(), other.end(), Data());
+        size_ = std::exchange(other.size_, 0);
+    }
+
+    ~StaticVector() requires TRIVIAL = default;
+
+    ~StaticVector() {
+        std::destroy_n(Data(), size_);
+    }
+
+    StaticVector& operator=(const StaticVector&) requires TRIVIAL = default;
+
+    StaticVector& operator=(const StaticVector& rhs) {
+        if (this != &rhs) {
+            AssignRange(rhs.begin(), rhs.end());
+        }
+        return *this;
+    }
+
+    StaticVector& operator=(StaticVector&&) requires TRIVIAL = default;
+
+    StaticVector& operator=(StaticVector&& rhs) noexcept(std::is_nothrow_move_constructible_v<T>
+                                                         && std::is_nothrow_move_assignable_v<T>) {
+        if (this != &rhs) {
+            AssignRange(std::make_move_iterator(rhs.begin()), std::make_move_iterator(rhs.end()));
+            rhs.Clear();
+        }
+        return *this;
+    }
+
+    iterator begin() noexcept {
+        return Data();
+    }
+
+    const_iterator begin() const noexcept {
+        return Data();
+    }
+
+    const_iterator cbegin() const noexcept {
+        return begin();
+    }
+
+    iterator end() noexcept {
+        return Data() + size_;
+    }
+
+    const_iterator end() const noexcept {
+        return Data() + size_;
+    }
+
+    const_iterator cend() const noexcept {
+        return end();
+    }
+
+    T& Front() noexcept {
+        ADVANCED_VECTOR_CHECK_BOUNDS(size_ != 0);
+        return *begin();
+    }
+
+    const T& Front() const noexcept {
+        ADVANCED_VECTOR_CHECK_BOUNDS(size_ != 0);
+        return *begin();
+    }
+
+    T& Back() noexcept {
+        ADVANCED_VECTOR_CHECK_BOUNDS(size_ != 0);
+        return *std::prev(end());
+    }
+
+    const T& Back() const noexcept {
+        ADVANCED_VECTOR_CHECK_BOUNDS(size_ != 0);
+        return *std::prev(end());
+    }
+
+    T& operator[](size_t index) noexcept {
+        ADVANCED_VECTOR_CHECK_BOUNDS(index < size_);
+        return Data()[index];
+    }
+
+    const T& operator[](size_t index) const noexcept {
+        ADVANCED_VECTOR_CHECK_BOUNDS(index < size_);
+        return Data()[index];
+    }
+
+    // Доступ с проверкой индекса при любом уровне проверок
+    T& At(size_t index) {
+        if (index >= size_) [[unlikely]] {
+            throw std::out_of_range("StaticVector index out of range");
+        }
+        return Data()[index];
+    }
+
+    const T& At(size_t index) const {
+        return const_cast<StaticVector&>(*this).At(index);
+    }
+
+    size_t Size() const noexcept {
+        return size_;
+    }
+
+    static constexpr size_t Capacity() noexcept {
+        return N;
+    }
+
+    bool Full() const noexcept {
+        return size_ == N;
+    }
+
+    // Память уже есть: проверяется только, что new_capacity элементов поместятся
+    void Reserve(size_t new_capacity) {
+        CheckCapacity(new_capacity);
+    }
+
+    void Resize(size_t new_size) {
+        if (new_size < size_) {
+            std::destroy(begin() + new_size, end());
+        } else {
+            CheckCapacity(new_size);
+            detail::UninitializedValueConstruct(end(), begin() + new_size);
+        }
+        size_ = new_size;
+    }
+
+    // Буфер никогда не переезжает, поэтому аргументы могут ссылаться на элементы вектора
+    template <typename... Args>
+    T& EmplaceBack(Args&&... args) {
+        CheckCapacity(size_ + 1);
+        T* elem = std::construct_at(end(), std::forward<Args>(args)...);
+        ++size_;
+        return *elem;
+    }
+
+    // Как EmplaceBack, но при заполненном векторе ничего не создаёт и возвращает false вместо вызова политики
+    template <typename... Args>
+    bool TryEmplaceBack(Args&&... args) {
+        if (Full()) {
+            return false;
+        }
+        std::construct_at(end(), std::forward<Args>(args)...);
+        ++size_;
+        return true;
+    }
+
+    void PushBack(const T& value) {
+        EmplaceBack(value);
+    }
+
+    void PushBack(T&& value) {
+        EmplaceBack(std::move(value));
+    }
+
+    void PopBack() noexcept {
+        ADVANCED_VECTOR_CHECK_BOUNDS(size_ != 0);
+        std::destroy_at(&Back());
+        --size_;
+    }
+
+    template <typename... Args>
+    iterator Emplace(const_iterator it, Args&&... args) {
+        ADVANCED_VECTOR_CHECK_BOUNDS(begin() <= it && it <= end());
+        CheckCapacity(size_ + 1);
+        iterator pos = const_cast<iterator>(it);
+        detail::EmplaceShifting(pos, end(), std::forward<Args>(args)...);
+        ++size_;
+        return pos;
+    }
+
+    iterator Insert(const_iterator it, const T& value) {
+        return Emplace(it, value);
+    }
+
+    iterator Insert(const_iterator it, T&& value) {
+        return Emplace(it, std::move(value));
+    }
+
+    iterator Erase(const_iterator it) {
+        ADVANCED_VECTOR_CHECK_BOUNDS(begin() <= it && it < end());
+        iterator pos = const_cast<iterator>(it);
+        detail::EraseShifting(pos, std::next(pos), end());
+        --size_;
+        return pos;
+    }
+
+    iterator Erase(const_iterator first, const_iterator last) {
+        ADVANCED_VECTOR_CHECK_BOUNDS(begin() <= first && first <= last && last <= end());
+        iterator pos = const_cast<iterator>(first);
+        size_ = std::distance(begin(), detail::EraseShifting(pos, const_cast<iterator>(last), end()));
+        return pos;
+    }
+
+    void Clear() noexcept {
+        std::destroy_n(Data(), size_);
+        size_ = 0;
+    }
+
+    // Общая часть обменивается поэлементно, а лишние элементы длинного вектора переносятся в короткий
+    void Swap(StaticVector& rhs) noexcept(std::is_nothrow_swappable_v<T> && std::is_nothrow_move_constructible_v<T>) {
+        if constexpr (TRIVIAL) {
+            std::swap(*this, rhs);
+        } else {
+            StaticVector& longer = size_ >= rhs.size_ ? *this : rhs;
+            StaticVector& shorter = size_ >= rhs.size_ ? rhs : *this;
+            std::swap_ranges(shorter.begin(), shorter.end(), longer.begin());
+            const size_t common = shorter.size_;
+            detail::RelocateData(longer.begin() + common, longer.end(), shorter.end());
+            shorter.size_ = longer.size_;
+            longer.size_ = common;
+        }
+    }
+
+private:
+    alignas(T) std::byte data_[sizeof(T) * N];
+    size_t size_ = 0;
+
+    T* Data() noexcept {
+        return reinterpret_cast<T*>(data_);
+    }
+
+    const T* Data() const noexcept {
+        return reinterpret_cast<const T*>(data_);
+    }
+
+    static void CheckCapacity(size_t required) {
+        if (required > N) {
+            OverflowPolicy::Overflow();
+        }
+    }
+
+    // До min_size - присваивание, после - разрушение лишних или создание недостающих
+    template <typename Iter>
+    void AssignRange(Iter first, Iter last) {
+        const size_t size = std::distance(first, last);
+        const size_t min_size = std::min(size_, size);
+        std::copy_n(first, min_size, begin());
+        if (size_ > size) {
+            std::destroy(begin() + size, end());
+        } else {
+            detail::UninitializedCopy(std::next(first, min_size), last, end());
+        }
+        size_ = size;
+    }
+};
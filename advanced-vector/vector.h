@@ -1,377 +1,1893 @@
 #pragma once
 
+#include "checks.h"
+
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
 #include <iterator>
-#include <cassert>
+#include <limits>
+#include <compare>
+#include <concepts>
+#include <cstring>
+#include <exception>
 #include <memory>
 #include <new>
+#include <ranges>
 #include <type_traits>
 #include <stdexcept>
 #include <utility>
 
+// Признак того, что объект можно перенести в другую память побайтовым копированием,
+// не вызывая конструктор перемещения для нового места и деструктор для старого.
+// По умолчанию это только тривиально копируемые типы; собственный тип можно отметить специализацией:
+//     template <> struct IsTriviallyRelocatable<MyType> : std::true_type {};
+// Типы, хранящие указатель на самих себя (например, std::string с SSO в libstdc++), отмечать нельзя
+template <typename T>
+struct IsTriviallyRelocatable : std::is_trivially_copyable<T> {};
+
+// unique_ptr хранит только указатель и deleter, поэтому переносим побайтово вместе с deleter
+template <typename T, typename Deleter>
+struct IsTriviallyRelocatable<std::unique_ptr<T, Deleter>> : IsTriviallyRelocatable<Deleter> {};
+
+template <typename T>
+inline constexpr bool IsTriviallyRelocatableV = IsTriviallyRelocatable<T>::value;
+
+namespace detail {
+
+// Аналоги std::uninitialized_* для constexpr-вычислений: стандартные алгоритмы станут constexpr только в C++26,
+// поэтому при вычислении во время компиляции элементы создаются по одному через std::construct_at,
+// а во время выполнения вызываются стандартные алгоритмы с их быстрыми путями для тривиальных типов.
+// При исключении созданные элементы разрушаются
+template <typename T, typename Construct>
+constexpr T* ConstructEach(T* first, T* last, Construct construct) {
+    T* current = first;
+    try {
+        for (; current != last; ++current) {
+            construct(current);
+        }
+    } catch (...) {
+        std::destroy(first, current);
+        throw;
+    }
+    return current;
+}
+
+template <typename InputIt, typename T>
+constexpr T* UninitializedCopy(InputIt first, InputIt last, T* dest) {
+    if (std::is_constant_evaluated()) {
+        T* current = dest;
+        try {
+            for (; first != last; ++first, ++current) {
+                std::construct_at(current, *first);
+            }
+        } catch (...) {
+            std::destroy(dest, current);
+            throw;
+        }
+        return current;
+    }
+    return std::uninitialized_copy(first, last, dest);
+}
+
+template <typename InputIt, typename T>
+constexpr T* UninitializedCopyN(InputIt first, size_t count, T* dest) {
+    if (std::is_constant_evaluated()) {
+        return ConstructEach(dest, dest + count, [&first](T* slot) {
+            std::construct_at(slot, *first);
+            ++first;
+        });
+    }
+    return std::ranges::uninitialized_copy_n(first, count, dest, dest + count).out;
+}
+
+template <typename T>
+constexpr T* UninitializedMove(T* first, T* last, T* dest) {
+    return UninitializedCopy(std::make_move_iterator(first), std::make_move_iterator(last), dest);
+}
+
+template <typename T>
+constexpr void UninitializedValueConstruct(T* first, T* last) {
+    if (std::is_constant_evaluated()) {
+        ConstructEach(first, last, [](T* slot) {
+            std::construct_at(slot);
+        });
+    } else {
+        std::uninitialized_value_construct(first, last);
+    }
+}
+
+template <typename T>
+constexpr void UninitializedFill(T* first, T* last, const T& value) {
+    if (std::is_constant_evaluated()) {
+        ConstructEach(first, last, [&value](T* slot) {
+            std::construct_at(slot, value);
+        });
+    } else {
+        std::uninitialized_fill(first, last, value);
+    }
+}
 
+// Перемещает/копирует данные из одного отрезка памяти в другой такого же диапазона (часто в коде нужна операция, метод для избежания дублирования)
 template <typename T>
+constexpr void OverwriteData(T* InpFirst, T* InpLast, T* DestIter) {
+    if constexpr (std::is_nothrow_move_constructible_v<T> || !std::is_copy_constructible_v<T>) {
+        UninitializedMove(InpFirst, InpLast, DestIter);
+    } else {
+        UninitializedCopy(InpFirst, InpLast, DestIter);
+    }
+}
+
+// Побайтовый перенос для тривиально перемещаемых типов. Диапазоны могут перекрываться.
+// При вычислении во время компиляции memmove недоступен, а сравнивать указатели на разные буферы нельзя, поэтому
+// элементы переносятся через временный буфер.
+// GCC 12 после встраивания ложно предупреждает о выходе за границы для пустого диапазона в конце встроенного буфера
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Warray-bounds"
+#endif
+template <typename T>
+constexpr void RelocateBytes(T* InpFirst, T* InpLast, T* DestIter) noexcept {
+    static_assert(IsTriviallyRelocatableV<T>);
+    const size_t count = std::distance(InpFirst, InpLast);
+    if (std::is_constant_evaluated()) {
+        if (count == 0) {
+            return;
+        }
+        std::allocator<T> alloc;
+        T* tmp = alloc.allocate(count);
+        for (size_t i = 0; i < count; ++i) {
+            std::construct_at(tmp + i, std::move(InpFirst[i]));
+            std::destroy_at(InpFirst + i);
+        }
+        for (size_t i = 0; i < count; ++i) {
+            std::construct_at(DestIter + i, std::move(tmp[i]));
+            std::destroy_at(tmp + i);
+        }
+        alloc.deallocate(tmp, count);
+    } else if (count > 0) {
+        std::memmove(static_cast<void*>(DestIter), static_cast<const void*>(InpFirst), count * sizeof(T));
+    }
+}
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+// Переносит элементы в неинициализированную память DestIter, после чего исходные элементы считаются разрушенными.
+// При исключении исходный диапазон остаётся нетронутым
+template <typename T>
+constexpr void RelocateData(T* InpFirst, T* InpLast, T* DestIter) {
+    if constexpr (IsTriviallyRelocatableV<T>) {
+        RelocateBytes(InpFirst, InpLast, DestIter);
+    } else {
+        OverwriteData(InpFirst, InpLast, DestIter);
+        std::destroy(InpFirst, InpLast);
+    }
+}
+
+// Создаёт элемент на позиции pos диапазона [pos, last), сдвигая хвост на одну позицию вправо.
+// По адресу last должна быть неинициализированная память ещё под один элемент.
+// Аргументы могут ссылаться на сдвигаемые элементы, поэтому новый элемент создаётся до сдвига
+template <typename T, typename... Args>
+constexpr void EmplaceShifting(T* pos, T* last, Args&&... args) {
+    if (pos == last) {
+        // Вставка в конец: ничего перемещать не надо, достаточно 1 раз вызвать конструктор
+        std::construct_at(last, std::forward<Args>(args)...);
+        return;
+    }
+
+    if constexpr (IsTriviallyRelocatableV<T>) {
+        if (!std::is_constant_evaluated()) {
+            // Хвост сдвигается одним memmove, а новый элемент переносится в дыру побайтово, без присваиваний
+            alignas(T) std::byte storage[sizeof(T)];
+            T* new_value = std::construct_at(reinterpret_cast<T*>(storage), std::forward<Args>(args)...);
+            RelocateBytes(pos, last, std::next(pos));
+            RelocateBytes(new_value, std::next(new_value), pos);
+            return;
+        }
+    }
+
+    // Нужны перемещения/копирования и 1 присваивание
+    T new_value(std::forward<Args>(args)...);
+
+    if constexpr (std::is_nothrow_move_constructible_v<T> || !std::is_copy_constructible_v<T>) {
+        std::construct_at(last, std::move(*std::prev(last)));
+    } else {
+        std::construct_at(last, *std::prev(last));
+    }
+
+    if constexpr (std::is_nothrow_move_assignable_v<T>) {
+        std::move_backward(pos, std::prev(last), last);
+        *pos = std::move(new_value);
+    } else {
+        // Элемент за старым концом вызывающий ещё не учёл в размере: при исключении его надо разрушить здесь,
+        // остальные элементы остаются живыми (базовая гарантия)
+        try {
+            std::move_backward(pos, std::prev(last), last);
+            *pos = std::move(new_value);
+        } catch (...) {
+            std::destroy_at(last);
+            throw;
+        }
+    }
+}
+
+// То же, что EmplaceShifting, для аргументов, которые не ссылаются на элементы [pos, last): хвост сдвигается первым,
+// а новый элемент создаётся сразу на своём месте, без временного объекта и присваивания.
+// Если конструктор бросил исключение, хвост возвращается на место. Для типов, перемещение которых может бросить,
+// вернуть хвост без риска нельзя, поэтому они создаются через временный объект, как в EmplaceShifting
+template <typename T, typename... Args>
+constexpr void ConstructShifting(T* pos, T* last, Args&&... args) {
+    if (pos == last) {
+        std::construct_at(last, std::forward<Args>(args)...);
+        return;
+    }
+
+    if constexpr (IsTriviallyRelocatableV<T>) {
+        RelocateBytes(pos, last, std::next(pos));
+        try {
+            std::construct_at(pos, std::forward<Args>(args)...);
+        } catch (...) {
+            RelocateBytes(std::next(pos), std::next(last), pos);
+            throw;
+        }
+    } else if constexpr (std::is_nothrow_move_constructible_v<T> && std::is_nothrow_move_assignable_v<T>) {
+        std::construct_at(last, std::move(*std::prev(last)));
+        std::move_backward(pos, std::prev(last), last);
+        std::destroy_at(pos);
+        try {
+            std::construct_at(pos, std::forward<Args>(args)...);
+        } catch (...) {
+            std::construct_at(pos, std::move(*std::next(pos)));
+            std::move(std::next(pos, 2), std::next(last), std::next(pos));
+            std::destroy_at(last);
+            throw;
+        }
+    } else {
+        EmplaceShifting(pos, last, std::forward<Args>(args)...);
+    }
+}
+
+// Аргументы - только числа и перечисления, которые конструктор не может изменить через ссылку.
+// Их копии не ссылаются на элементы вектора, поэтому с ними можно создавать элемент сразу на месте
+template <typename Arg>
+concept ScalarArgument = (std::is_arithmetic_v<std::remove_cvref_t<Arg>> || std::is_enum_v<std::remove_cvref_t<Arg>>)
+    && (!std::is_lvalue_reference_v<Arg> || std::is_const_v<std::remove_reference_t<Arg>>);
+
+template <typename... Args>
+concept ScalarArguments = (ScalarArgument<Args> && ...);
+
+// Переносит элементы [first, last) в неинициализированную память dest, оставляя после pos дыру под gap элементов,
+// которые вызывающий уже создал в dest. Старые элементы разрушаются только после того, как обе части успешно перенесены,
+// а при исключении разрушаются и элементы в дыре
+template <typename T>
+constexpr void RelocateAround(T* first, T* pos, T* last, T* dest, size_t gap) {
+    T* pos_in_dest = std::next(dest, std::distance(first, pos));
+
+    if constexpr (IsTriviallyRelocatableV<T>) {
+        RelocateBytes(first, pos, dest);
+        RelocateBytes(pos, last, pos_in_dest + gap);
+    } else {
+        try {
+            OverwriteData(first, pos, dest);
+        } catch (...) {
+            std::destroy(pos_in_dest, pos_in_dest + gap);
+            throw;
+        }
+        try {
+            OverwriteData(pos, last, pos_in_dest + gap);
+        } catch (...) {
+            std::destroy(dest, pos_in_dest + gap);
+            throw;
+        }
+        std::destroy(first, last);
+    }
+}
+
+// Собирает в неинициализированной памяти dest элементы [first, last) и новый элемент на месте pos.
+// Аргументы могут ссылаться на старые элементы, поэтому новый элемент создаётся первым
+template <typename T, typename... Args>
+constexpr void EmplaceRelocating(T* first, T* pos, T* last, T* dest, Args&&... args) {
+    std::construct_at(std::next(dest, std::distance(first, pos)), std::forward<Args>(args)...);
+    RelocateAround(first, pos, last, dest, 1);
+}
+
+// Собирает в неинициализированной памяти dest элементы [first, last) и count элементов из src на месте pos.
+// Источник может указывать на старые элементы, поэтому вставляемые элементы копируются первыми
+template <typename T, typename SrcIt>
+constexpr void InsertRelocating(T* first, T* pos, T* last, T* dest, SrcIt src, size_t count) {
+    T* pos_in_dest = std::next(dest, std::distance(first, pos));
+    UninitializedCopyN(src, count, pos_in_dest);
+    RelocateAround(first, pos, last, dest, count);
+}
+
+// Итератор по копиям одного значения (аналог std::views::repeat из C++23)
+template <typename T>
+class RepeatIterator {
+public:
+    using value_type = T;
+    using difference_type = std::ptrdiff_t;
+    using reference = const T&;
+    using pointer = const T*;
+    using iterator_category = std::forward_iterator_tag;
+
+    RepeatIterator() = default;
+
+    constexpr RepeatIterator(const T& value, difference_type index) noexcept
+        : value_(&value)
+        , index_(index) {
+    }
+
+    constexpr reference operator*() const noexcept {
+        return *value_;
+    }
+
+    constexpr RepeatIterator& operator++() noexcept {
+        ++index_;
+        return *this;
+    }
+
+    constexpr RepeatIterator operator++(int) noexcept {
+        RepeatIterator prev = *this;
+        ++index_;
+        return prev;
+    }
+
+    constexpr bool operator==(const RepeatIterator& other) const noexcept {
+        return index_ == other.index_;
+    }
+
+private:
+    const T* value_ = nullptr;
+    difference_type index_ = 0;
+};
+
+// Удаляет элементы [first, erase_last) из диапазона [first, last), сдвигая хвост влево один раз.
+// Возвращает новый конец диапазона
+template <typename T>
+constexpr T* EraseShifting(T* first, T* erase_last, T* last) {
+    if (first == erase_last) {
+        return last;
+    }
+
+    if constexpr (IsTriviallyRelocatableV<T>) {
+        // Удаляемые элементы разрушаются, а хвост сдвигается одним memmove без присваиваний и деструкторов
+        std::destroy(first, erase_last);
+        RelocateBytes(erase_last, last, first);
+        return std::next(first, std::distance(erase_last, last));
+    } else {
+        T* new_last;
+        if constexpr (std::is_nothrow_move_constructible_v<T> || !std::is_copy_constructible_v<T>) {
+            new_last = std::move(erase_last, last, first);
+        } else {
+            new_last = std::copy(erase_last, last, first);
+        }
+        std::destroy(new_last, last);
+        return new_last;
+    }
+}
+
+// Итератор, по диапазону которого можно пройти несколько раз.
+// Сюда же относится move_iterator, который в C++20 формально моделирует лишь input_iterator
+template <typename Iter>
+concept MultiPassIterator = std::forward_iterator<Iter>
+    || std::derived_from<typename std::iterator_traits<Iter>::iterator_category, std::forward_iterator_tag>;
+
+}  // namespace detail
+
+// Аллокатор, умеющий менять размер выделенного буфера с сохранением его байтов (см. MallocAllocator)
+template <typename Allocator, typename T>
+concept ReallocatingAllocator = requires(Allocator& alloc, T* buf, size_t n) {
+    { alloc.reallocate(buf, n, n) } -> std::same_as<T*>;
+};
+
+// Почему вектор сменил буфер
+enum class ReallocationReason {
+    GROWTH,  // не хватило места при вставке или Resize
+    RESERVE, // явный Reserve
+    SHRINK,  // ShrinkToFit
+};
+
+// Сведения о смене буфера вектора: relocated элементов перенесены перемещением или побайтово,
+// copied - копированием (конструктор перемещения может бросить исключение)
+struct ReallocationEvent {
+    size_t old_capacity = 0;
+    size_t new_capacity = 0;
+    size_t relocated = 0;
+    size_t copied = 0;
+    ReallocationReason reason = ReallocationReason::GROWTH;
+};
+
+// Политика инструментирования RawMemory и Vector: статические функции, которые вызываются при выделении
+// и освобождении памяти и при смене буфера. Эта политика ничего не делает и полностью исчезает после встраивания;
+// собирающая статистику реализация - NamedStats из instrumentation.h
+struct NoInstrumentation {
+    static constexpr void OnAllocate(size_t /*bytes*/) noexcept {
+    }
+
+    static constexpr void OnDeallocate(size_t /*bytes*/) noexcept {
+    }
+
+    static constexpr void OnReallocate(const ReallocationEvent& /*event*/) noexcept {
+    }
+};
+
+// Освобождает буфер, память которого не принадлежит аллокатору вектора (см. Vector::Adopt и Vector::Release).
+// Хранит любой вызываемый объект deleter(T* buffer, size_t capacity) и сам занимает один указатель.
+// Владеющий указатель хранится без std::unique_ptr, деструктор которого в C++20 не constexpr: пустой BufferDeleter
+// есть в каждой RawMemory, в том числе в создаваемых во время компиляции
+template <typename T>
+class BufferDeleter {
+public:
+    BufferDeleter() = default;
+
+    template <typename Deleter>
+        requires std::is_invocable_v<Deleter&, T*, size_t> && (!std::is_same_v<std::remove_cvref_t<Deleter>, BufferDeleter>)
+    explicit BufferDeleter(Deleter deleter)
+        : impl_(new Model<Deleter>(std::move(deleter))) {
+    }
+
+    constexpr BufferDeleter(BufferDeleter&& other) noexcept
+        : impl_(std::exchange(other.impl_, nullptr)) {
+    }
+
+    constexpr BufferDeleter& operator=(BufferDeleter&& rhs) noexcept {
+        if (this != &rhs) {
+            delete impl_;
+            impl_ = std::exchange(rhs.impl_, nullptr);
+        }
+        return *this;
+    }
+
+    constexpr ~BufferDeleter() {
+        delete impl_;
+    }
+
+    constexpr explicit operator bool() const noexcept {
+        return impl_ != nullptr;
+    }
+
+    void operator()(T* buffer, size_t capacity) const noexcept {
+        ADVANCED_VECTOR_CHECK_DEBUG(impl_ != nullptr);
+        impl_->Free(buffer, capacity);
+    }
+
+private:
+    struct Concept {
+        constexpr virtual ~Concept() = default;
+        virtual void Free(T* buffer, size_t capacity) noexcept = 0;
+    };
+
+    template <typename Deleter>
+    struct Model final : Concept {
+        explicit Model(Deleter deleter)
+            : deleter(std::move(deleter)) {
+        }
+
+        void Free(T* buffer, size_t capacity) noexcept override {
+            deleter(buffer, capacity);
+        }
+
+        Deleter deleter;
+    };
+
+    Concept* impl_ = nullptr;
+};
+
+#if ADVANCED_VECTOR_DEBUG_ITERATORS
+namespace detail {
+
+// Поколение буфера для отладочных итераторов. Блок создаётся вместе с буфером и переезжает с ним при перемещении
+// и обмене RawMemory, а номер меняется, только когда буфер освобождён или заменён. Итераторы держат ссылку на блок,
+// поэтому проверка работает и после разрушения вектора. Счётчик ссылок атомарный: итераторы одного вектора
+// можно создавать и копировать в разных потоках
+class BufferGeneration {
+public:
+    static constexpr BufferGeneration* Create() {
+        return new BufferGeneration();
+    }
+
+    static constexpr void Ref(BufferGeneration* generation) noexcept {
+        if (generation == nullptr) {
+            return;
+        }
+        if (std::is_constant_evaluated()) {
+            ++generation->refs_;
+        } else {
+            std::atomic_ref<size_t>(generation->refs_).fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    static constexpr void Unref(BufferGeneration* generation) noexcept {
+        if (generation == nullptr) {
+            return;
+        }
+        const bool last = std::is_constant_evaluated()
+                              ? --generation->refs_ == 0
+                              : std::atomic_ref<size_t>(generation->refs_).fetch_sub(1, std::memory_order_acq_rel) == 1;
+        if (last) {
+            Destroy(generation);
+        }
+    }
+
+    constexpr size_t Value() const noexcept {
+        return value_;
+    }
+
+    // Буфер освобождён или заменён: итераторы, полученные раньше, становятся недействительными
+    constexpr void Bump() noexcept {
+        ++value_;
+    }
+
+private:
+    size_t value_ = 0;
+    size_t refs_ = 1;
+
+    // Вне строки: иначе GCC, не видя связи счётчика с копиями итераторов, ложно предупреждает о use-after-free
+    [[gnu::noinline]] static constexpr void Destroy(BufferGeneration* generation) noexcept {
+        delete generation;
+    }
+};
+
+}  // namespace detail
+#endif
+
+template <typename T, typename Allocator = std::allocator<T>, typename Instrumentation = NoInstrumentation>
 class RawMemory {
+    using AllocTraits = std::allocator_traits<Allocator>;
+
+    static_assert(std::is_same_v<typename AllocTraits::value_type, T>, "Allocator::value_type must be T");
+    static_assert(std::is_same_v<typename AllocTraits::pointer, T*>, "Fancy pointers are not supported");
+
 public:
-    RawMemory() = default;
+    using allocator_type = Allocator;
 
-    explicit RawMemory(size_t capacity)
-        : buffer_(Allocate(capacity))
+    constexpr RawMemory() = default;
+
+    constexpr explicit RawMemory(const Allocator& alloc) noexcept
+        : alloc_(alloc) {
+    }
+
+    constexpr explicit RawMemory(size_t capacity, const Allocator& alloc = Allocator())
+        : alloc_(alloc)
+        , buffer_(Allocate(capacity))
         , capacity_(capacity) {
+#if ADVANCED_VECTOR_DEBUG_ITERATORS
+        try {
+            CreateGeneration();
+        } catch (...) {
+            Deallocate(buffer_, capacity_);
+            throw;
+        }
+#endif
     }
 
     RawMemory(const RawMemory&) = delete;
 
-    RawMemory(RawMemory&& other) noexcept
-        : buffer_(std::exchange(other.buffer_, nullptr)),
-          capacity_(std::exchange(other.capacity_, 0)) {}
+    constexpr RawMemory(RawMemory&& other) noexcept
+        : alloc_(std::move(other.alloc_)),
+          buffer_(std::exchange(other.buffer_, nullptr)),
+          capacity_(std::exchange(other.capacity_, 0)),
+          foreign_deleter_(std::move(other.foreign_deleter_)) {
+        TakeGeneration(other);
+    }
 
     RawMemory& operator=(const RawMemory&) = delete;
 
-    RawMemory& operator=(RawMemory&& rhs) noexcept {
+    // Аллокатор переезжает вместе с буфером, только если этого требует propagate_on_container_move_assignment,
+    // иначе аллокаторы обязаны быть равны: чужой буфер будет освобождён своим аллокатором
+    constexpr RawMemory& operator=(RawMemory&& rhs) noexcept {
         if (this != &rhs) {
-            Swap(rhs);
+            if constexpr (AllocTraits::propagate_on_container_move_assignment::value) {
+                Deallocate(buffer_, capacity_);
+                alloc_ = std::move(rhs.alloc_);
+            } else {
+                ADVANCED_VECTOR_CHECK_DEBUG(alloc_ == rhs.alloc_);
+                Deallocate(buffer_, capacity_);
+            }
+            buffer_ = std::exchange(rhs.buffer_, nullptr);
+            capacity_ = std::exchange(rhs.capacity_, 0);
+            foreign_deleter_ = std::move(rhs.foreign_deleter_);
+            TakeGeneration(rhs);
         }
 
         return *this;
     }
 
-    ~RawMemory() {
-        Deallocate(buffer_);
+    constexpr ~RawMemory() {
+        Deallocate(buffer_, capacity_);
+#if ADVANCED_VECTOR_DEBUG_ITERATORS
+        Invalidate();
+        detail::BufferGeneration::Unref(generation_);
+#endif
     }
 
-    T* operator+(size_t offset) noexcept {
+    constexpr T* operator+(size_t offset) noexcept {
         // Разрешается получать адрес ячейки памяти, следующей за последним элементом массива
-        assert(offset <= capacity_);
+        ADVANCED_VECTOR_CHECK_BOUNDS(offset <= capacity_);
         return buffer_ + offset;
     }
 
-    const T* operator+(size_t offset) const noexcept {
+    constexpr const T* operator+(size_t offset) const noexcept {
         return const_cast<RawMemory&>(*this) + offset;
     }
 
-    const T& operator[](size_t index) const noexcept {
+    constexpr const T& operator[](size_t index) const noexcept {
         return const_cast<RawMemory&>(*this)[index];
     }
 
-    T& operator[](size_t index) noexcept {
-        assert(index < capacity_);
+    constexpr T& operator[](size_t index) noexcept {
+        ADVANCED_VECTOR_CHECK_BOUNDS(index < capacity_);
         return buffer_[index];
     }
 
-    operator T*() noexcept {
+    constexpr operator T*() noexcept {
         return buffer_;
     }
 
-    operator const T*() const noexcept {
+    constexpr operator const T*() const noexcept {
         return buffer_;
     }
 
-    void Swap(RawMemory& other) noexcept {
+    // Аллокаторы обмениваются, только если этого требует propagate_on_container_swap, иначе они обязаны быть равны
+    constexpr void Swap(RawMemory& other) noexcept {
+        if constexpr (AllocTraits::propagate_on_container_swap::value) {
+            using std::swap;
+            swap(alloc_, other.alloc_);
+        } else {
+            ADVANCED_VECTOR_CHECK_DEBUG(alloc_ == other.alloc_);
+        }
         std::swap(buffer_, other.buffer_);
         std::swap(capacity_, other.capacity_);
+        std::swap(foreign_deleter_, other.foreign_deleter_);
+#if ADVANCED_VECTOR_DEBUG_ITERATORS
+        std::swap(generation_, other.generation_);
+#endif
+    }
+
+    // Освобождает свою память и забирает буфер other вместе с его аллокатором независимо от propagate_* признаков
+    constexpr void Replace(RawMemory&& other) noexcept {
+        Deallocate(buffer_, capacity_);
+        alloc_ = std::move(other.alloc_);
+        buffer_ = std::exchange(other.buffer_, nullptr);
+        capacity_ = std::exchange(other.capacity_, 0);
+        foreign_deleter_ = std::move(other.foreign_deleter_);
+        TakeGeneration(other);
     }
 
-    const T* GetAddress() const noexcept {
+    // Освобождает свою память и забирает чужой буфер. С пустым deleter буфер считается выделенным своим аллокатором.
+    // В сборке с отладочными итераторами может понадобиться блок поколения, и его нехватка памяти завершит программу
+    void Adopt(T* buffer, size_t capacity, BufferDeleter<T> deleter) noexcept {
+        Deallocate(buffer_, capacity_);
+        buffer_ = buffer;
+        capacity_ = capacity;
+        foreign_deleter_ = std::move(deleter);
+        if (!foreign_deleter_ && buffer_ != nullptr) {
+            Instrumentation::OnAllocate(capacity_ * sizeof(T));
+        }
+        Invalidate();
+#if ADVANCED_VECTOR_DEBUG_ITERATORS
+        CreateGeneration();
+#endif
+    }
+
+    // Отдаёт буфер вызывающему и становится пустой. Возвращает функцию, освобождающую буфер
+    // (для пустой RawMemory она тоже пуста). При исключении буфер остаётся на месте
+    BufferDeleter<T> Release() {
+        BufferDeleter<T> deleter;
+        if (foreign_deleter_) {
+            deleter = std::move(foreign_deleter_);
+        } else if (buffer_ != nullptr) {
+            deleter = BufferDeleter<T>([alloc = alloc_](T* buffer, size_t capacity) mutable {
+                AllocTraits::deallocate(alloc, buffer, capacity);
+            });
+            Instrumentation::OnDeallocate(capacity_ * sizeof(T));
+        }
+        buffer_ = nullptr;
+        capacity_ = 0;
+        Invalidate();
+        return deleter;
+    }
+
+    // Буфер пришёл извне и будет освобождён не аллокатором
+    constexpr bool IsAdopted() const noexcept {
+        return static_cast<bool>(foreign_deleter_);
+    }
+
+    constexpr const Allocator& GetAllocator() const noexcept {
+        return alloc_;
+    }
+
+    // Меняет ёмкость буфера, сохраняя его байты. Адрес буфера может измениться, а конструкторы и деструкторы
+    // не вызываются, поэтому годится только для тривиально перемещаемых T. При исключении буфер не меняется
+    void Reallocate(size_t new_capacity) requires ReallocatingAllocator<Allocator, T> {
+#if ADVANCED_VECTOR_DEBUG_ITERATORS
+        CreateGeneration();
+#endif
+        if (IsAdopted()) {
+            // Чужой буфер аллокатор расширить не может: байты переносятся в новый, а старый освобождает его deleter
+            T* new_buffer = Allocate(new_capacity);
+            if (new_buffer != nullptr) {
+                std::memcpy(static_cast<void*>(new_buffer), static_cast<const void*>(buffer_),
+                            std::min(capacity_, new_capacity) * sizeof(T));
+            }
+            Deallocate(buffer_, capacity_);
+            buffer_ = new_buffer;
+        } else if (new_capacity == 0) {
+            Deallocate(buffer_, capacity_);
+            buffer_ = nullptr;
+        } else {
+            buffer_ = alloc_.reallocate(buffer_, capacity_, new_capacity);
+            if (capacity_ > 0) {
+                Instrumentation::OnDeallocate(capacity_ * sizeof(T));
+            }
+            Instrumentation::OnAllocate(new_capacity * sizeof(T));
+        }
+        capacity_ = new_capacity;
+        Invalidate();
+    }
+
+    constexpr const T* GetAddress() const noexcept {
         return buffer_;
     }
 
-    T* GetAddress() noexcept {
+    constexpr T* GetAddress() noexcept {
         return buffer_;
     }
 
-    size_t Capacity() const {
+    constexpr size_t Capacity() const {
         return capacity_;
     }
 
+#if ADVANCED_VECTOR_DEBUG_ITERATORS
+    // Поколение текущего буфера; у пустой RawMemory, которая ещё не владела буфером, его нет (nullptr)
+    constexpr detail::BufferGeneration* Generation() const noexcept {
+        return generation_;
+    }
+#endif
+
 private:
     // Выделяет сырую память под n элементов и возвращает указатель на неё
-    static T* Allocate(size_t n) {
-        return n > 0 ? static_cast<T*>(operator new(n * sizeof(T))) : nullptr;
+    constexpr T* Allocate(size_t n) {
+        if (n == 0) {
+            return nullptr;
+        }
+        T* buf = AllocTraits::allocate(alloc_, n);
+        Instrumentation::OnAllocate(n * sizeof(T));
+        return buf;
     }
 
-    // Освобождает сырую память, выделенную ранее по адресу buf при помощи Allocate
-    static void Deallocate(T* buf) noexcept {
-        operator delete(buf);
+    // Освобождает сырую память под n элементов, выделенную ранее по адресу buf при помощи Allocate или переданную в Adopt
+    constexpr void Deallocate(T* buf, size_t n) noexcept {
+        if (foreign_deleter_) {
+            if (buf != nullptr) {
+                foreign_deleter_(buf, n);
+            }
+            foreign_deleter_ = {};
+        } else if (buf != nullptr) {
+            AllocTraits::deallocate(alloc_, buf, n);
+            Instrumentation::OnDeallocate(n * sizeof(T));
+        }
     }
 
+    [[no_unique_address]] Allocator alloc_ = Allocator();
     T* buffer_ = nullptr;
     size_t capacity_ = 0;
+    BufferDeleter<T> foreign_deleter_;
+#if ADVANCED_VECTOR_DEBUG_ITERATORS
+    detail::BufferGeneration* generation_ = nullptr;
+
+    // Блок поколения нужен, как только появляется буфер, на который могут указывать итераторы
+    constexpr void CreateGeneration() {
+        if (generation_ == nullptr) {
+            generation_ = detail::BufferGeneration::Create();
+        }
+    }
+#endif
+
+    // Буфер освобождён или заменён на месте: итераторы на прежний становятся недействительными
+    constexpr void Invalidate() noexcept {
+#if ADVANCED_VECTOR_DEBUG_ITERATORS
+        if (generation_ != nullptr) {
+            generation_->Bump();
+        }
+#endif
+    }
+
+    // Прежний буфер уже освобождён, а поколение other переезжает сюда вместе с его буфером,
+    // поэтому итераторы на буфер other остаются действительными
+    constexpr void TakeGeneration([[maybe_unused]] RawMemory& other) noexcept {
+#if ADVANCED_VECTOR_DEBUG_ITERATORS
+        Invalidate();
+        detail::BufferGeneration::Unref(generation_);
+        generation_ = std::exchange(other.generation_, nullptr);
+#endif
+    }
+};
+
+// Политика роста ёмкости, когда в векторе заканчивается место:
+// * ёмкость умножается на Num / Den (но не меньше, чем на один элемент);
+// * первая ёмкость занимает не меньше MinInitialBytes (например, кэш-линию), чтобы не было серии крошечных реаллокаций;
+// * при RoundToSizeClass размер буфера округляется вверх до класса размеров jemalloc, и остаток класса не пропадает;
+// * шаг роста ограничен MaxStepBytes (0 - без ограничения), чтобы огромные буферы не росли сразу на гигабайты.
+// В любом случае новая ёмкость не меньше требуемой
+template <size_t Num = 2, size_t Den = 1, size_t MinInitialBytes = 0, size_t MaxStepBytes = 0, bool RoundToSizeClass = false>
+struct BasicGrowthPolicy {
+    static_assert(Den > 0 && Num > Den, "Growth factor must be greater than 1");
+
+    template <typename T>
+    static constexpr size_t NextCapacity(size_t capacity, size_t required) noexcept {
+        constexpr size_t MAX_CAPACITY = std::numeric_limits<size_t>::max() / sizeof(T);
+
+        size_t grown = capacity > MAX_CAPACITY / Num ? MAX_CAPACITY : std::max(capacity * Num / Den, capacity + 1);
+        if constexpr (MinInitialBytes > 0) {
+            grown = std::max(grown, (MinInitialBytes + sizeof(T) - 1) / sizeof(T));
+        }
+        if constexpr (RoundToSizeClass) {
+            if (grown <= MAX_CAPACITY / 2) {
+                grown = RoundUpToSizeClass(grown * sizeof(T)) / sizeof(T);
+            }
+        }
+        if constexpr (MaxStepBytes > 0) {
+            constexpr size_t MAX_STEP = std::max<size_t>(MaxStepBytes / sizeof(T), 1);
+            grown = std::min(grown, capacity > MAX_CAPACITY - MAX_STEP ? MAX_CAPACITY : capacity + MAX_STEP);
+        }
+        return std::max(grown, required);
+    }
+
+private:
+    // Классы размеров jemalloc: 8, затем шаг 16 до 128, затем по 4 класса на каждое удвоение
+    static constexpr size_t RoundUpToSizeClass(size_t bytes) noexcept {
+        if (bytes <= 8) {
+            return 8;
+        }
+        if (bytes <= 128) {
+            return (bytes + 15) / 16 * 16;
+        }
+        const int log2 = std::numeric_limits<size_t>::digits - 1 - std::countl_zero(bytes - 1);
+        const size_t spacing = size_t{1} << (log2 - 2);
+        return (bytes + spacing - 1) / spacing * spacing;
+    }
+};
+
+// Удвоение ёмкости: 1, 2, 4, 8...
+using DoublingGrowth = BasicGrowthPolicy<>;
+
+// Рост в 1.5 раза, начиная с кэш-линии, с округлением до классов jemalloc и шагом не больше 64 МиБ
+using CompactGrowth = BasicGrowthPolicy<3, 2, 64, size_t{64} << 20, true>;
+
+// Буфер, отданный вектором через Release: элементы [data, data + size) остаются живыми,
+// а deleter(data, capacity) освобождает память после того, как их разрушит новый владелец
+template <typename T>
+struct ReleasedBuffer {
+    T* data = nullptr;
+    size_t size = 0;
+    size_t capacity = 0;
+    BufferDeleter<T> deleter;
+};
+
+// Исполнитель параллельных операций Vector: Run(tasks, task) вызывает task(0), ..., task(tasks - 1), возможно
+// одновременно из разных потоков, и возвращается, когда все вызовы завершились. Ни task, ни Run не бросают исключений.
+// Concurrency() - сколько задач имеет смысл выполнять одновременно. Готовая реализация - ThreadExecutor из parallel.h
+template <typename Executor>
+concept ChunkExecutor = requires(Executor& executor, size_t tasks, void (&task)(size_t)) {
+    { executor.Concurrency() } -> std::convertible_to<size_t>;
+    executor.Run(tasks, task);
 };
 
+// Тег параллельных перегрузок Vector, например Vector(Parallel(pool), other)
+template <ChunkExecutor Executor>
+struct ParallelPolicy {
+    Executor& executor;
+};
+
+template <ChunkExecutor Executor>
+ParallelPolicy<Executor> Parallel(Executor& executor) noexcept {
+    return {executor};
+}
+
+namespace detail {
+
+// Меньшие куски не окупают передачу в другой поток, поэтому короткие массивы обрабатываются одним куском
+inline constexpr size_t PARALLEL_MIN_CHUNK_BYTES = size_t{1} << 18;
+
+template <typename T, typename Executor>
+size_t ParallelChunks(Executor& executor, size_t count) noexcept {
+    const size_t by_size = count * sizeof(T) / PARALLEL_MIN_CHUNK_BYTES;
+    return std::max<size_t>(1, std::min<size_t>(executor.Concurrency(), by_size));
+}
+
+// Начало куска chunk, когда count элементов делятся на chunks почти равных кусков
+inline size_t ChunkBegin(size_t count, size_t chunks, size_t chunk) noexcept {
+    return count / chunks * chunk + std::min(count % chunks, chunk);
+}
+
+// Создаёт элементы в неинициализированной памяти [first, first + count) по кускам: construct(chunk_first, chunk_last, offset)
+// выполняется в задачах executor и при исключении сам разрушает созданное в своём куске. Если хоть один кусок
+// не удался, разрушаются и удавшиеся, а наружу пробрасывается исключение первого из неудавшихся
+template <typename T, typename Executor, typename Construct>
+void ParallelConstruct(Executor& executor, T* first, size_t count, Construct construct) {
+    const size_t chunks = ParallelChunks<T>(executor, count);
+    if (chunks == 1) {
+        construct(first, first + count, 0);
+        return;
+    }
+
+    const auto bound = [count, chunks](size_t chunk) {
+        return ChunkBegin(count, chunks, chunk);
+    };
+    std::unique_ptr<std::exception_ptr[]> errors(new std::exception_ptr[chunks]);
+    const auto task = [&](size_t chunk) noexcept {
+        try {
+            construct(first + bound(chunk), first + bound(chunk + 1), bound(chunk));
+        } catch (...) {
+            errors[chunk] = std::current_exception();
+        }
+    };
+    executor.Run(chunks, task);
+
+    for (size_t chunk = 0; chunk < chunks; ++chunk) {
+        if (errors[chunk]) {
+            for (size_t built = 0; built < chunks; ++built) {
+                if (!errors[built]) {
+                    std::destroy(first + bound(built), first + bound(built + 1));
+                }
+            }
+            std::rethrow_exception(errors[chunk]);
+        }
+    }
+}
+
+// Разрушает элементы [first, first + count) по кускам в задачах executor
+template <typename T, typename Executor>
+void ParallelDestroy(Executor& executor, T* first, size_t count) noexcept {
+    if constexpr (!std::is_trivially_destructible_v<T>) {
+        const size_t chunks = ParallelChunks<T>(executor, count);
+        if (chunks == 1) {
+            std::destroy_n(first, count);
+            return;
+        }
+        const auto task = [first, count, chunks](size_t chunk) noexcept {
+            std::destroy(first + ChunkBegin(count, chunks, chunk), first + ChunkBegin(count, chunks, chunk + 1));
+        };
+        executor.Run(chunks, task);
+    }
+}
+
+}  // namespace detail
+
+// Тег конструктора Vector(size, DefaultInit): элементы инициализируются по умолчанию, а не значением
+struct DefaultInitTag {
+    explicit DefaultInitTag() = default;
+};
+
+inline constexpr DefaultInitTag DefaultInit{};
+
+// Instrumentation получает события выделения памяти и смены буфера (см. NoInstrumentation)
+#if ADVANCED_VECTOR_DEBUG_ITERATORS
+namespace detail {
+
+// Итератор отладочной сборки: указатель вместе со ссылкой на блок поколения буфера и номером поколения,
+// при котором итератор получен. Пока буфер не освобождён и не заменён, ведёт себя как T*, в том числе после
+// перемещения и обмена векторов: блок переезжает вместе с буфером. Сравнивать можно только итераторы одного буфера,
+// а пустые (созданные по умолчанию или полученные от вектора без буфера) - только между собой
 template <typename T>
+class CheckedIterator {
+public:
+    using value_type = std::remove_cv_t<T>;
+    using element_type = T;
+    using difference_type = std::ptrdiff_t;
+    using pointer = T*;
+    using reference = T&;
+    using iterator_category = std::random_access_iterator_tag;
+    using iterator_concept = std::contiguous_iterator_tag;
+
+    CheckedIterator() = default;
+
+    constexpr CheckedIterator(T* ptr, BufferGeneration* generation) noexcept
+        : ptr_(ptr)
+        , generation_(generation)
+        , expected_(generation == nullptr ? 0 : generation->Value()) {
+        BufferGeneration::Ref(generation_);
+    }
+
+    constexpr CheckedIterator(const CheckedIterator& other) noexcept
+        : ptr_(other.ptr_)
+        , generation_(other.generation_)
+        , expected_(other.expected_) {
+        BufferGeneration::Ref(generation_);
+    }
+
+    // Неконстантный итератор приводится к константному
+    template <typename U>
+        requires(std::is_same_v<const U, T> && !std::is_same_v<U, T>)
+    constexpr CheckedIterator(const CheckedIterator<U>& other) noexcept
+        : ptr_(other.ptr_)
+        , generation_(other.generation_)
+        , expected_(other.expected_) {
+        BufferGeneration::Ref(generation_);
+    }
+
+    constexpr CheckedIterator& operator=(const CheckedIterator& rhs) noexcept {
+        BufferGeneration::Ref(rhs.generation_);
+        BufferGeneration::Unref(generation_);
+        ptr_ = rhs.ptr_;
+        generation_ = rhs.generation_;
+        expected_ = rhs.expected_;
+        return *this;
+    }
+
+    constexpr ~CheckedIterator() {
+        BufferGeneration::Unref(generation_);
+    }
+
+    // Адрес, на который указывает итератор, полученный от текущего буфера вектора с этим блоком поколения.
+    // Итераторы вектора без буфера блока не имеют, и им соответствует только такой же вектор
+    constexpr T* Address(const BufferGeneration* generation) const noexcept {
+        ADVANCED_VECTOR_CHECK_IMPL(generation_ == generation && (generation_ == nullptr || IsValid()));
+        return ptr_;
+    }
+
+    constexpr reference operator*() const noexcept {
+        ADVANCED_VECTOR_CHECK_IMPL(IsValid());
+        return *ptr_;
+    }
+
+    constexpr pointer operator->() const noexcept {
+        ADVANCED_VECTOR_CHECK_IMPL(IsValid());
+        return ptr_;
+    }
+
+    constexpr reference operator[](difference_type offset) const noexcept {
+        ADVANCED_VECTOR_CHECK_IMPL(IsValid());
+        return ptr_[offset];
+    }
+
+    constexpr CheckedIterator& operator++() noexcept {
+        ++ptr_;
+        return *this;
+    }
+
+    constexpr CheckedIterator operator++(int) noexcept {
+        CheckedIterator prev = *this;
+        ++ptr_;
+        return prev;
+    }
+
+    constexpr CheckedIterator& operator--() noexcept {
+        --ptr_;
+        return *this;
+    }
+
+    constexpr CheckedIterator operator--(int) noexcept {
+        CheckedIterator prev = *this;
+        --ptr_;
+        return prev;
+    }
+
+    constexpr CheckedIterator& operator+=(difference_type offset) noexcept {
+        ptr_ += offset;
+        return *this;
+    }
+
+    constexpr CheckedIterator& operator-=(difference_type offset) noexcept {
+        ptr_ -= offset;
+        return *this;
+    }
+
+    friend constexpr CheckedIterator operator+(CheckedIterator it, difference_type offset) noexcept {
+        return it += offset;
+    }
+
+    friend constexpr CheckedIterator operator+(difference_type offset, CheckedIterator it) noexcept {
+        return it += offset;
+    }
+
+    friend constexpr CheckedIterator operator-(CheckedIterator it, difference_type offset) noexcept {
+        return it -= offset;
+    }
+
+    friend constexpr difference_type operator-(const CheckedIterator& lhs, const CheckedIterator& rhs) noexcept {
+        CheckComparable(lhs, rhs);
+        return lhs.ptr_ - rhs.ptr_;
+    }
+
+    friend constexpr bool operator==(const CheckedIterator& lhs, const CheckedIterator& rhs) noexcept {
+        CheckComparable(lhs, rhs);
+        return lhs.ptr_ == rhs.ptr_;
+    }
+
+    friend constexpr std::strong_ordering operator<=>(const CheckedIterator& lhs, const CheckedIterator& rhs) noexcept {
+        CheckComparable(lhs, rhs);
+        return lhs.ptr_ <=> rhs.ptr_;
+    }
+
+private:
+    template <typename U>
+    friend class CheckedIterator;
+
+    T* ptr_ = nullptr;
+    BufferGeneration* generation_ = nullptr;
+    size_t expected_ = 0;
+
+    constexpr bool IsValid() const noexcept {
+        return generation_ != nullptr && generation_->Value() == expected_;
+    }
+
+    static constexpr void CheckComparable(const CheckedIterator& lhs, const CheckedIterator& rhs) noexcept {
+        ADVANCED_VECTOR_CHECK_IMPL(lhs.generation_ == rhs.generation_
+                                   && (lhs.generation_ == nullptr || (lhs.IsValid() && rhs.IsValid())));
+    }
+};
+
+}  // namespace detail
+#endif
+
+template <typename T, typename Allocator = std::allocator<T>, typename GrowthPolicy = DoublingGrowth,
+          typename Instrumentation = NoInstrumentation>
 class Vector {
+    using AllocTraits = std::allocator_traits<Allocator>;
+
 public:
+    using value_type = T;
+#if ADVANCED_VECTOR_DEBUG_ITERATORS
+    using iterator = detail::CheckedIterator<T>;
+    using const_iterator = detail::CheckedIterator<const T>;
+#else
     using iterator = T*;
     using const_iterator = const T*;
+#endif
+    using allocator_type = Allocator;
+
+    constexpr Vector() = default;
+
+    constexpr explicit Vector(const Allocator& alloc) noexcept
+        : data_(alloc) {
+    }
+
+    constexpr explicit Vector(size_t size, const Allocator& alloc = Allocator())
+    : data_(size, alloc), size_(size) {
+        detail::UninitializedValueConstruct(data_.GetAddress(), data_.GetAddress() + size);
+    }
 
-    Vector() = default;
+    // Элементы инициализируются по умолчанию: память под тривиальные типы не обнуляется
+    Vector(size_t size, DefaultInitTag, const Allocator& alloc = Allocator())
+    : data_(size, alloc), size_(size) {
+        std::uninitialized_default_construct_n(data_.GetAddress(), size);
+    }
 
-    explicit Vector(size_t size) : data_(size), size_(size) {
-        std::uninitialized_value_construct_n(data_.GetAddress(), size);
+    constexpr explicit Vector(size_t size, const T& value, const Allocator& alloc = Allocator())
+    : data_(size, alloc), size_(size) {
+        detail::UninitializedFill(data_.GetAddress(), data_.GetAddress() + size, value);
     }
 
-    explicit Vector(size_t size, const T& value)
-    : data_(size), size_(size) {
-        std::uninitialized_fill_n(data_.GetAddress(), size, value);
+    constexpr Vector(std::initializer_list<T> values, const Allocator& alloc = Allocator())
+    : data_(values.size(), alloc), size_(data_.Capacity()) {
+        detail::UninitializedCopy(values.begin(), values.end(), data_.GetAddress());
     }
 
-    Vector(std::initializer_list<T> values)
-    : data_(values.size()), size_(data_.Capacity()) {
-        std::uninitialized_copy(values.begin(), values.end(), data_.GetAddress());
+    template <std::input_iterator Iter>
+    constexpr explicit Vector(Iter first, Iter last, const Allocator& alloc = Allocator())
+    : data_(alloc) {
+        if constexpr (detail::MultiPassIterator<Iter>) {
+            RawMemory<T, Allocator, Instrumentation> new_data(std::distance(first, last), alloc);
+            detail::UninitializedCopy(first, last, new_data.GetAddress());
+            data_.Swap(new_data);
+            size_ = data_.Capacity();
+        } else {
+            AppendOneByOne(first, last);
+        }
     }
 
-    template <typename Iter>
-    explicit Vector(Iter first, Iter last)
-    : data_(std::distance(first, last)), size_(data_.Capacity()) {
-        std::uninitialized_copy(first, last, data_.GetAddress());
+    constexpr Vector(const Vector& other)
+    : Vector(other, AllocTraits::select_on_container_copy_construction(other.GetAllocator())) {
     }
 
-    Vector(const Vector& other) : data_(other.size_), size_(other.size_) {
-        std::uninitialized_copy(other.begin(), other.end(), data_.GetAddress());
+    constexpr Vector(const Vector& other, const Allocator& alloc)
+    : data_(other.size_, alloc), size_(other.size_) {
+        detail::UninitializedCopy(other.begin(), other.end(), data_.GetAddress());
     }
 
-    Vector(Vector&& other)
-        : data_(std::exchange(other.data_, {})),
+    // Параллельные варианты конструкторов: элементы создаются кусками в задачах executor (см. ChunkExecutor).
+    // Если хоть один элемент не создался, уже созданные разрушаются, а память освобождается
+    template <ChunkExecutor Executor>
+    Vector(ParallelPolicy<Executor> policy, size_t size, const Allocator& alloc = Allocator())
+    : data_(size, alloc) {
+        detail::ParallelConstruct(policy.executor, data_.GetAddress(), size, [](T* first, T* last, size_t) {
+            std::uninitialized_value_construct(first, last);
+        });
+        size_ = size;
+    }
+
+    template <ChunkExecutor Executor>
+    Vector(ParallelPolicy<Executor> policy, size_t size, const T& value, const Allocator& alloc = Allocator())
+    : data_(size, alloc) {
+        detail::ParallelConstruct(policy.executor, data_.GetAddress(), size, [&value](T* first, T* last, size_t) {
+            std::uninitialized_fill(first, last, value);
+        });
+        size_ = size;
+    }
+
+    template <ChunkExecutor Executor>
+    Vector(ParallelPolicy<Executor> policy, const Vector& other)
+    : Vector(policy, other, AllocTraits::select_on_container_copy_construction(other.GetAllocator())) {
+    }
+
+    template <ChunkExecutor Executor>
+    Vector(ParallelPolicy<Executor> policy, const Vector& other, const Allocator& alloc)
+    : data_(other.size_, alloc) {
+        const T* source = other.Data();
+        detail::ParallelConstruct(policy.executor, data_.GetAddress(), other.size_,
+                                  [source](T* first, T* last, size_t offset) {
+            std::uninitialized_copy(source + offset, source + offset + (last - first), first);
+        });
+        size_ = other.size_;
+    }
+
+    constexpr Vector(Vector&& other) noexcept
+        : data_(std::move(other.data_)),
           size_(std::exchange(other.size_, 0)) {}
 
-    ~Vector() noexcept {
+    // Буфер можно забрать, только если его сможет освободить alloc, иначе элементы перемещаются по одному
+    constexpr Vector(Vector&& other, const Allocator& alloc)
+    : data_(alloc) {
+        if (alloc == other.GetAllocator()) {
+            data_ = std::move(other.data_);
+            size_ = std::exchange(other.size_, 0);
+        } else {
+            RawMemory<T, Allocator, Instrumentation> new_data(other.size_, alloc);
+            detail::UninitializedMove(other.Data(), other.DataEnd(), new_data.GetAddress());
+            data_.Swap(new_data);
+            size_ = other.size_;
+        }
+    }
+
+    constexpr ~Vector() noexcept {
         if (data_.GetAddress()) {
             std::destroy_n(data_.GetAddress(), size_);
         }
     }
 
-    Vector& operator=(const Vector& rhs) {
+    constexpr Vector& operator=(const Vector& rhs) {
         if (this == &rhs) {
             return *this;
         }
 
-        if (Capacity() >= rhs.size_) {
-            // До этой позиции будет присваивание, а после - разрушение или инициализация
-            size_t min_size = std::min(size_, rhs.size_);
-            std::copy_n(rhs.begin(), min_size, begin());
-
-            if (size_ > rhs.size_) {
-                std::destroy(begin() + min_size, begin() + size_);
-            } else {
-                std::uninitialized_copy(rhs.begin() + min_size, rhs.end(), begin() + min_size);
+        if constexpr (AllocTraits::propagate_on_container_copy_assignment::value) {
+            if (GetAllocator() != rhs.GetAllocator()) {
+                // Текущий буфер может освободить только старый аллокатор, поэтому копия строится сразу на новом
+                Vector tmp(rhs, rhs.GetAllocator());
+                std::destroy_n(Data(), size_);
+                data_.Replace(std::move(tmp.data_));
+                size_ = std::exchange(tmp.size_, 0);
+                return *this;
             }
-            size_ = rhs.size_;
-        } else {
-            Vector tmp(rhs);
-            Swap(tmp);
         }
 
+        AssignRange(rhs.begin(), rhs.end());
+
         return *this;
     }
 
-    Vector& operator=(Vector&& rhs) noexcept {
-        if (this != &rhs) {
-            Swap(rhs);
+    constexpr Vector& operator=(Vector&& rhs) noexcept(AllocTraits::propagate_on_container_move_assignment::value
+                                             || AllocTraits::is_always_equal::value) {
+        if (this == &rhs) {
+            return *this;
+        }
+
+        if constexpr (AllocTraits::propagate_on_container_move_assignment::value
+                      || AllocTraits::is_always_equal::value) {
+            StealFrom(rhs);
+        } else if (GetAllocator() == rhs.GetAllocator()) {
+            StealFrom(rhs);
+        } else {
+            // Чужой буфер нельзя освободить своим аллокатором, поэтому элементы перемещаются по одному
+            AssignRange(std::make_move_iterator(rhs.begin()), std::make_move_iterator(rhs.end()));
         }
 
         return *this;
     }
 
-    iterator begin() noexcept {
-        return data_;
+    constexpr allocator_type GetAllocator() const noexcept {
+        return data_.GetAllocator();
     }
 
-    const_iterator begin() const noexcept {
-        return data_;
+    constexpr iterator begin() noexcept {
+        return MakeIterator(Data());
     }
 
-    const_iterator cbegin() const noexcept {
+    constexpr const_iterator begin() const noexcept {
+        return MakeIterator(Data());
+    }
+
+    constexpr const_iterator cbegin() const noexcept {
         return begin();
     }
 
-    iterator end() noexcept {
-        return data_ + size_;
+    constexpr iterator end() noexcept {
+        return MakeIterator(DataEnd());
     }
 
-    const_iterator end() const noexcept {
-        return data_ + size_;
+    constexpr const_iterator end() const noexcept {
+        return MakeIterator(DataEnd());
     }
 
-    const_iterator cend() const noexcept {
+    constexpr const_iterator cend() const noexcept {
         return end();
     }
 
-    T& Front() noexcept {
+    // Адрес первого элемента; при отладочных итераторах - единственный способ получить T* без проверок
+    constexpr T* Data() noexcept {
+        return data_.GetAddress();
+    }
+
+    constexpr const T* Data() const noexcept {
+        return data_.GetAddress();
+    }
+
+    constexpr T& Front() noexcept {
+        ADVANCED_VECTOR_CHECK_BOUNDS(size_ != 0);
         return *begin();
     }
 
-    const T& Front() const noexcept {
+    constexpr const T& Front() const noexcept {
+        ADVANCED_VECTOR_CHECK_BOUNDS(size_ != 0);
         return *begin();
     }
 
-    T& Back() noexcept {
+    constexpr T& Back() noexcept {
+        ADVANCED_VECTOR_CHECK_BOUNDS(size_ != 0);
         return *std::prev(end());
     }
 
-    const T& Back() const noexcept {
+    constexpr const T& Back() const noexcept {
+        ADVANCED_VECTOR_CHECK_BOUNDS(size_ != 0);
         return *std::prev(end());
     }
 
-    void Reserve(size_t new_capacity) {
+    constexpr void Reserve(size_t new_capacity) {
         if (new_capacity <= data_.Capacity()) {
             return;
         }
 
-        RawMemory<T> new_data(new_capacity);
-    
-        OverwriteData(begin(), end(), new_data);
+        ReallocateData(new_capacity, ReallocationReason::RESERVE);
+    }
 
-        std::destroy_n(begin(), size_);
-        data_.Swap(new_data);
+    // Уменьшает ёмкость до размера. Использует те же быстрые пути переноса, что и Reserve
+    constexpr void ShrinkToFit() {
+        if (Capacity() > size_) {
+            ReallocateData(size_, ReallocationReason::SHRINK);
+        }
     }
 
-    void Resize(size_t new_size) {
-        // Уменьшаем размер
-        if (size_ > new_size) {
-            std::destroy(begin() + new_size, end());
-            size_ = new_size;
+    // Разрушает элементы, сохраняя ёмкость
+    constexpr void Clear() noexcept {
+        std::destroy_n(Data(), size_);
+        size_ = 0;
+    }
+
+    // Разрушает элементы и возвращает буфер аллокатору
+    constexpr void ReleaseMemory() noexcept {
+        Clear();
+        RawMemory<T, Allocator, Instrumentation> empty(data_.GetAllocator());
+        data_.Swap(empty);
+    }
+
+    // Параллельный вариант копирующего присваивания со строгой гарантией: копия строится в новом буфере,
+    // и только потом старые элементы разрушаются. Аллокатор выбирается так же, как при обычном присваивании
+    template <ChunkExecutor Executor>
+    void Assign(ParallelPolicy<Executor> policy, const Vector& rhs) {
+        if (this == &rhs) {
             return;
         }
 
-        // Размер надо увеличить, но увеличение начинаем с проверки capacity
-        if (new_size > Capacity()) {
-            RawMemory<T> new_data(new_size);
-            std::uninitialized_value_construct(new_data + size_, new_data + new_size);
-            
-            OverwriteData(begin(), end(), new_data);
+        Vector tmp(policy, rhs,
+                   AllocTraits::propagate_on_container_copy_assignment::value ? rhs.GetAllocator() : GetAllocator());
+        Clear(policy);
+        data_.Replace(std::move(tmp.data_));
+        size_ = std::exchange(tmp.size_, 0);
+    }
 
-            std::destroy(begin(), end());
-            data_.Swap(new_data);
+    template <ChunkExecutor Executor>
+    void Clear(ParallelPolicy<Executor> policy) noexcept {
+        detail::ParallelDestroy(policy.executor, Data(), size_);
+        size_ = 0;
+    }
+
+    // Замена деструктору для больших векторов: элементы разрушаются параллельно, а буфер возвращается аллокатору
+    template <ChunkExecutor Executor>
+    void ReleaseMemory(ParallelPolicy<Executor> policy) noexcept {
+        Clear(policy);
+        ReleaseMemory();
+    }
+
+    // Забирает без копирования буфер ptr на capacity элементов, в начале которого уже созданы size элементов.
+    // Прежние элементы разрушаются, а память освобождается. Забранный буфер вектор освободит вызовом
+    // deleter(ptr, capacity), а когда deleter не передан - своим аллокатором
+    template <typename Deleter>
+    void Adopt(T* ptr, size_t size, size_t capacity, Deleter deleter) {
+        // Если deleter не удалось сохранить, вектор и буфер остаются как были
+        BufferDeleter<T> erased(std::move(deleter));
+        AdoptBuffer(ptr, size, capacity, std::move(erased));
+    }
+
+    void Adopt(T* ptr, size_t size, size_t capacity) noexcept {
+        AdoptBuffer(ptr, size, capacity, {});
+    }
+
+    // Отдаёт буфер вместе с живыми элементами и функцией его освобождения, после чего вектор пуст и без памяти
+    ReleasedBuffer<T> Release() {
+        T* data = data_.GetAddress();
+        const size_t capacity = Capacity();
+        BufferDeleter<T> deleter = data_.Release();
+        return {.data = data, .size = std::exchange(size_, 0), .capacity = capacity, .deleter = std::move(deleter)};
+    }
+
+    constexpr void Resize(size_t new_size) {
+        ResizeWith(new_size, [](T* first, T* last) {
+            detail::UninitializedValueConstruct(first, last);
+        });
+    }
+
+    // Как Resize, но новые элементы инициализируются по умолчанию: тривиальные типы не обнуляются
+    void ResizeDefaultInit(size_t new_size) {
+        ResizeWith(new_size, [](T* first, T* last) {
+            std::uninitialized_default_construct(first, last);
+        });
+    }
+
+    // Меняет размер на не больше чем count, позволяя заполнить память напрямую (как std::string::resize_and_overwrite).
+    // op(data, count) получает count элементов, из которых новые инициализированы по умолчанию
+    // (для тривиальных типов это неинициализированная память), и возвращает итоговый размер, не больший count
+    template <typename Operation>
+    void ResizeAndOverwrite(size_t count, Operation op) {
+        if (count > Capacity()) {
+            ReallocateData(NextCapacity(count), ReallocationReason::GROWTH);
+        }
+
+        const size_t old_size = size_;
+        if (count > size_) {
+            std::uninitialized_default_construct(DataEnd(), Data() + count);
         } else {
-            std::uninitialized_value_construct(end(), begin() + new_size);
+            std::destroy(Data() + count, DataEnd());
+        }
+        size_ = count;
+
+        size_t new_size;
+        try {
+            new_size = std::move(op)(data_.GetAddress(), count);
+        } catch (...) {
+            // Добавленные элементы удаляются, а прежние остаются в том состоянии, в котором их оставила op
+            if (count > old_size) {
+                std::destroy(Data() + old_size, DataEnd());
+                size_ = old_size;
+            }
+            throw;
         }
+
+        ADVANCED_VECTOR_CHECK_DEBUG(new_size <= count);
+        std::destroy(Data() + new_size, DataEnd());
         size_ = new_size;
     }
-
     template <typename... Args>
-    T& EmplaceBack(Args&&... args) {
+    constexpr T& EmplaceBack(Args&&... args) {
+        if (size_ < Capacity()) {
+            // Место есть: ни реаллокации, ни сдвигов не нужно
+            std::construct_at(DataEnd(), std::forward<Args>(args)...);
+            ++size_;
+            return Back();
+        }
         return *Emplace(end(), std::forward<Args>(args)...);
     }
 
-    void PushBack(const T& value) {
+    constexpr void PushBack(const T& value) {
         EmplaceBack(value);
     }
 
-    void PushBack(T&& value) {
+    constexpr void PushBack(T&& value) {
         EmplaceBack(std::move(value));
     }
 
-    void PopBack() {
-        assert(size_ != 0);
+    constexpr void PopBack() {
+        ADVANCED_VECTOR_CHECK_BOUNDS(size_ != 0);
 
         std::destroy_at(&Back());
         --size_;
     }
 
     template <typename... Args>
-    iterator Emplace(const_iterator it, Args&& ... args) {
-        assert(begin() <= it && it <= end());
-        // Метод должен принимать константные и неконстантные итераторы, но для работы метода итератор должен быть неконстантным
-        iterator non_const_it = const_cast<iterator>(it);
-        // Позиция, в которой будет произведена вставка
-        size_t it_pos = std::distance(begin(), non_const_it);
-
-        if (Capacity() == Size()) { // Нужна реаллокация
-            RawMemory<T> new_data(size_ == 0 ? 1 : size_ * 2);
-            iterator it_in_new_data = std::next(new_data.GetAddress(), it_pos);
-            
-            std::construct_at(it_in_new_data, std::forward<Args>(args)...);
-            
-            OverwriteData(begin(), non_const_it, new_data.GetAddress());
-            OverwriteData(non_const_it, end(), it_in_new_data + 1);
-            
-            std::destroy(begin(), end());
-            data_.Swap(new_data);
-        } else { // Реаллокация не нужна, памяти хватает
-            if (it_pos == size_) {
-                // Итератор указывает на end(), ничего перемещать не надо, достаточно 1 раз вызвать конструктор
-                std::construct_at(end(), std::forward<Args>(args)...);
-            } else { // Нужны перемещения/копирования и 1 присваивание
-                T new_value(std::forward<Args>(args)...);
-
-                if constexpr (std::is_nothrow_move_constructible_v<T> || !std::is_copy_constructible_v<T>) {
-                    std::construct_at(end(), std::move(Back()));
-                } else {
-                    std::construct_at(end(), Back());
-                }
-
-                std::move_backward(non_const_it, std::prev(end()), end());
-                *non_const_it = std::move(new_value);
-            }
+    constexpr iterator Emplace(const_iterator it, Args&& ... args) {
+        if constexpr (detail::ScalarArguments<Args...>) {
+            // Копии чисел не ссылаются на элементы, поэтому новый элемент создаётся сразу на своём месте
+            return EmplaceImpl<true>(it, std::remove_cvref_t<Args>(args)...);
+        } else {
+            return EmplaceImpl<false>(it, std::forward<Args>(args)...);
         }
-        ++size_;
+    }
 
-        return std::next(begin(), it_pos);
+    // Emplace без временного объекта: при вставке без реаллокации хвост сдвигается первым, а элемент создаётся
+    // сразу на своём месте. Аргументы не должны ссылаться на элементы вектора начиная с it
+    template <typename... Args>
+    constexpr iterator EmplaceNoAlias(const_iterator it, Args&&... args) {
+        return EmplaceImpl<true>(it, std::forward<Args>(args)...);
     }
 
-    iterator Insert(const_iterator it, const T& val) {
+    constexpr iterator Insert(const_iterator it, const T& val) {
         return Emplace(it, val);
     }
 
-    iterator Insert(const_iterator it, T&& val) {
+    constexpr iterator Insert(const_iterator it, T&& val) {
         return Emplace(it, std::move(val));
     }
 
-    iterator Erase(const_iterator it) {
-        assert(begin() <= it && it < end());
- 
-        iterator non_const_it = const_cast<iterator>(it);
+    // Вставляет элементы диапазона перед it. Память выделяется не больше одного раза, а хвост сдвигается один раз.
+    // Диапазон не должен указывать на элементы самого вектора
+    template <std::input_iterator Iter>
+    constexpr iterator Insert(const_iterator it, Iter first, Iter last) {
+        if constexpr (detail::MultiPassIterator<Iter>) {
+            return InsertRange(it, first, static_cast<size_t>(std::distance(first, last)));
+        } else {
+            // Длина однопроходного диапазона заранее неизвестна: элементы добавляются в конец и поворачиваются на место
+            const size_t it_pos = std::distance(cbegin(), it);
+            const size_t old_size = size_;
+            AppendOneByOne(first, last);
+            std::rotate(begin() + it_pos, begin() + old_size, end());
+            return begin() + it_pos;
+        }
+    }
 
-        if constexpr (std::is_nothrow_move_constructible_v<T> || !std::is_copy_constructible_v<T>) {
-            std::move(std::next(non_const_it), end(), non_const_it);
+    // Вставляет count копий value перед it. value может быть элементом самого вектора
+    constexpr iterator Insert(const_iterator it, size_t count, const T& value) {
+        if (count > 0 && size_ + count <= Capacity()) {
+            // Сдвиг хвоста может затронуть value, поэтому вставляется его копия
+            const T value_copy(value);
+            return InsertRange(it, detail::RepeatIterator<T>(value_copy, 0), count);
+        }
+        // При реаллокации старые элементы живы, пока копии не созданы
+        return InsertRange(it, detail::RepeatIterator<T>(value, 0), count);
+    }
+
+    template <std::input_iterator Iter>
+    constexpr void Append(Iter first, Iter last) {
+        Insert(cend(), first, last);
+    }
+
+    template <std::ranges::input_range Range>
+    constexpr void AppendRange(Range&& range) {
+        if constexpr (std::ranges::forward_range<Range> || std::ranges::sized_range<Range>) {
+            // Вставка в конец проходит по источнику один раз, поэтому подходит и однопроходный диапазон с известной длиной
+            InsertRange(cend(), std::ranges::begin(range), static_cast<size_t>(std::ranges::distance(range)));
         } else {
-            std::copy(std::next(non_const_it), end(), non_const_it);
+            AppendOneByOne(std::ranges::begin(range), std::ranges::end(range));
         }
+    }
 
-        std::destroy_at(&Back());
+    constexpr iterator Erase(const_iterator it) {
+        T* pos = Position(it);
+        ADVANCED_VECTOR_CHECK_BOUNDS(Data() <= pos && pos < DataEnd());
+
+        detail::EraseShifting(pos, std::next(pos), DataEnd());
         --size_;
 
-        return non_const_it;
+        return MakeIterator(pos);
     }
 
-    size_t Size() const noexcept {
+    // Удаляет элементы [first, last): хвост сдвигается один раз, а освободившиеся элементы разрушаются один раз
+    constexpr iterator Erase(const_iterator first, const_iterator last) {
+        T* pos = Position(first);
+        T* erase_last = Position(last);
+        ADVANCED_VECTOR_CHECK_BOUNDS(Data() <= pos && pos <= erase_last && erase_last <= DataEnd());
+
+        T* new_end = detail::EraseShifting(pos, erase_last, DataEnd());
+        size_ = std::distance(Data(), new_end);
+
+        return MakeIterator(pos);
+    }
+
+    constexpr size_t Size() const noexcept {
         return size_;
     }
 
-    size_t Capacity() const noexcept {
+    constexpr size_t Capacity() const noexcept {
         return data_.Capacity();
     }
 
-    const T& operator[](size_t index) const noexcept {
+    constexpr const T& operator[](size_t index) const noexcept {
         return const_cast<Vector&>(*this)[index];
     }
 
-    T& operator[](size_t index) noexcept {
-        assert(index < size_);
+    constexpr T& operator[](size_t index) noexcept {
+        ADVANCED_VECTOR_CHECK_BOUNDS(index < size_);
+        return data_[index];
+    }
+
+    // Доступ с проверкой индекса при любом уровне проверок
+    constexpr T& At(size_t index) {
+        if (index >= size_) [[unlikely]] {
+            throw std::out_of_range("Vector index out of range");
+        }
         return data_[index];
     }
 
-    void Swap(Vector& rhs) noexcept {
-        std::swap(data_, rhs.data_);
+    constexpr const T& At(size_t index) const {
+        return const_cast<Vector&>(*this).At(index);
+    }
+
+    // Без propagate_on_container_swap аллокаторы обязаны быть равны, как и у std::vector
+    constexpr void Swap(Vector& rhs) noexcept {
+        data_.Swap(rhs.data_);
         std::swap(size_, rhs.size_);
     }
 
 private:
-    RawMemory<T> data_;
+    // Буфер растёт через Allocator::reallocate, а элементы сохраняются без поэлементного переноса
+    static constexpr bool REALLOCATE_IN_PLACE = IsTriviallyRelocatableV<T> && ReallocatingAllocator<Allocator, T>;
+
+    RawMemory<T, Allocator, Instrumentation> data_;
     size_t size_ = 0;
 
+    constexpr T* DataEnd() noexcept {
+        return data_ + size_;
+    }
 
-    // Перемещает/копирует данные из одного отрезка памяти в другой такого же диапазона (часто в коде нужна операция, метод для избежания дублирования)
-    static void OverwriteData(iterator InpFirst, iterator InpLast, iterator DestIter) {
-        if constexpr (std::is_nothrow_move_constructible_v<T> || !std::is_copy_constructible_v<T>) {
-            std::uninitialized_move(InpFirst, InpLast, DestIter);
+    constexpr const T* DataEnd() const noexcept {
+        return data_ + size_;
+    }
+
+    constexpr iterator MakeIterator(T* ptr) noexcept {
+#if ADVANCED_VECTOR_DEBUG_ITERATORS
+        return iterator(ptr, data_.Generation());
+#else
+        return ptr;
+#endif
+    }
+
+    constexpr const_iterator MakeIterator(const T* ptr) const noexcept {
+#if ADVANCED_VECTOR_DEBUG_ITERATORS
+        return const_iterator(ptr, data_.Generation());
+#else
+        return ptr;
+#endif
+    }
+
+    // Адрес, на который указывает итератор. Методы принимают и константные итераторы, но меняют элементы,
+    // поэтому константность снимается. Отладочный итератор должен принадлежать текущему буферу этого вектора
+    constexpr T* Position(const_iterator it) noexcept {
+#if ADVANCED_VECTOR_DEBUG_ITERATORS
+        return const_cast<T*>(it.Address(data_.Generation()));
+#else
+        return const_cast<T*>(it);
+#endif
+    }
+
+    // Ёмкость, до которой нужно вырасти, чтобы вместить required элементов
+    constexpr size_t NextCapacity(size_t required) const noexcept {
+        return GrowthPolicy::template NextCapacity<T>(Capacity(), required);
+    }
+
+    // Меняет ёмкость буфера, перенося в него все элементы
+    constexpr void ReallocateData(size_t new_capacity, ReallocationReason reason) {
+        const size_t old_capacity = Capacity();
+        if constexpr (REALLOCATE_IN_PLACE) {
+            data_.Reallocate(new_capacity);
         } else {
-            std::uninitialized_copy(InpFirst, InpLast, DestIter);
+            RawMemory<T, Allocator, Instrumentation> new_data(new_capacity, data_.GetAllocator());
+            detail::RelocateData(Data(), DataEnd(), new_data.GetAddress());
+            data_.Swap(new_data);
+        }
+        NoteReallocation(old_capacity, reason);
+    }
+
+    // Сообщает Instrumentation, что все size_ элементов переехали из буфера old_capacity в текущий
+    constexpr void NoteReallocation(size_t old_capacity, ReallocationReason reason) const noexcept {
+        // Так же, как решает detail::OverwriteData
+        constexpr bool COPIES = !IsTriviallyRelocatableV<T> && !std::is_nothrow_move_constructible_v<T>
+                                && std::is_copy_constructible_v<T>;
+        Instrumentation::OnReallocate({
+            .old_capacity = old_capacity,
+            .new_capacity = Capacity(),
+            .relocated = COPIES ? 0 : size_,
+            .copied = COPIES ? size_ : 0,
+            .reason = reason,
+        });
+    }
+
+    // Меняет размер, создавая новые элементы при помощи construct(first, last) для неинициализированной памяти
+    template <typename Construct>
+    constexpr void ResizeWith(size_t new_size, Construct construct) {
+        // Уменьшаем размер
+        if (size_ > new_size) {
+            std::destroy(Data() + new_size, DataEnd());
+            size_ = new_size;
+            return;
+        }
+
+        // Размер надо увеличить, но увеличение начинаем с проверки capacity
+        if (new_size > Capacity() && !REALLOCATE_IN_PLACE) {
+            RawMemory<T, Allocator, Instrumentation> new_data(NextCapacity(new_size), data_.GetAllocator());
+            construct(new_data + size_, new_data + new_size);
+
+            try {
+                detail::RelocateData(Data(), DataEnd(), new_data.GetAddress());
+            } catch (...) {
+                std::destroy(new_data + size_, new_data + new_size);
+                throw;
+            }
+            data_.Swap(new_data);
+            NoteReallocation(new_data.Capacity(), ReallocationReason::GROWTH);
+        } else {
+            // Буфер, растущий на месте, сначала расширяется: существующие элементы при этом не трогаются
+            if (new_size > Capacity()) {
+                ReallocateData(NextCapacity(new_size), ReallocationReason::GROWTH);
+            }
+            construct(DataEnd(), Data() + new_size);
+        }
+        size_ = new_size;
+    }
+
+    template <bool NoAlias, typename... Args>
+    constexpr iterator EmplaceImpl(const_iterator it, Args&&... args) {
+        T* pos = Position(it);
+        ADVANCED_VECTOR_CHECK_BOUNDS(Data() <= pos && pos <= DataEnd());
+        // Позиция, в которой будет произведена вставка
+        size_t it_pos = std::distance(Data(), pos);
+
+        if (Capacity() == Size()) { // Нужна реаллокация
+            if constexpr (REALLOCATE_IN_PLACE) { // Буфер растёт на месте
+                // Аргументы могут ссылаться на элементы вектора, поэтому новый элемент создаётся до реаллокации
+                alignas(T) std::byte storage[sizeof(T)];
+                T* new_value = std::construct_at(reinterpret_cast<T*>(storage), std::forward<Args>(args)...);
+
+                try {
+                    ReallocateData(NextCapacity(size_ + 1), ReallocationReason::GROWTH);
+                } catch (...) {
+                    std::destroy_at(new_value);
+                    throw;
+                }
+                detail::RelocateBytes(Data() + it_pos, DataEnd(), Data() + it_pos + 1);
+                detail::RelocateBytes(new_value, new_value + 1, Data() + it_pos);
+            } else {
+                RawMemory<T, Allocator, Instrumentation> new_data(NextCapacity(size_ + 1), data_.GetAllocator());
+                detail::EmplaceRelocating(Data(), pos, DataEnd(), new_data.GetAddress(), std::forward<Args>(args)...);
+                data_.Swap(new_data);
+                NoteReallocation(new_data.Capacity(), ReallocationReason::GROWTH);
+            }
+        } else if constexpr (NoAlias) { // Реаллокация не нужна, аргументы не ссылаются на сдвигаемые элементы
+            detail::ConstructShifting(pos, DataEnd(), std::forward<Args>(args)...);
+        } else { // Реаллокация не нужна, памяти хватает
+            detail::EmplaceShifting(pos, DataEnd(), std::forward<Args>(args)...);
+        }
+        ++size_;
+
+        return MakeIterator(Data() + it_pos);
+    }
+
+    void AdoptBuffer(T* ptr, size_t size, size_t capacity, BufferDeleter<T> deleter) noexcept {
+        ADVANCED_VECTOR_CHECK_DEBUG(size <= capacity && (ptr != nullptr || capacity == 0));
+        Clear();
+        data_.Adopt(ptr, capacity, std::move(deleter));
+        size_ = size;
+    }
+
+    // Разрушает свои элементы и забирает буфер rhs (аллокатор переезжает по правилам RawMemory)
+    constexpr void StealFrom(Vector& rhs) noexcept {
+        std::destroy_n(Data(), size_);
+        size_ = 0;
+        data_ = std::move(rhs.data_);
+        size_ = std::exchange(rhs.size_, 0);
+    }
+
+    // Вставляет count элементов, копируя их из src: память выделяется не больше одного раза, хвост сдвигается один раз
+    template <typename SrcIt>
+    constexpr iterator InsertRange(const_iterator it, SrcIt src, size_t count) {
+        T* pos = Position(it);
+        ADVANCED_VECTOR_CHECK_BOUNDS(Data() <= pos && pos <= DataEnd());
+        const size_t it_pos = std::distance(Data(), pos);
+
+        if (count == 0) {
+            return MakeIterator(pos);
+        }
+
+        if (size_ + count > Capacity()) {
+            RawMemory<T, Allocator, Instrumentation> new_data(NextCapacity(size_ + count), data_.GetAllocator());
+            detail::InsertRelocating(Data(), pos, DataEnd(), new_data.GetAddress(), src, count);
+            data_.Swap(new_data);
+            NoteReallocation(new_data.Capacity(), ReallocationReason::GROWTH);
+            size_ += count;
+        } else if constexpr (IsTriviallyRelocatableV<T>) {
+            // Хвост сдвигается одним memmove, а при исключении возвращается на место
+            detail::RelocateBytes(pos, DataEnd(), pos + count);
+            try {
+                detail::UninitializedCopyN(src, count, pos);
+            } catch (...) {
+                detail::RelocateBytes(pos + count, DataEnd() + count, pos);
+                throw;
+            }
+            size_ += count;
+        } else {
+            const size_t tail = size_ - it_pos;
+            T* old_end = DataEnd();
+
+            if (count < tail) {
+                // Последние count элементов переезжают в неинициализированную память, остальные сдвигаются присваиванием
+                detail::OverwriteData(old_end - count, old_end, old_end);
+                size_ += count;
+                std::move_backward(pos, old_end - count, old_end);
+                std::ranges::copy_n(src, count, pos);
+            } else {
+                // Часть вставки, выходящая за старый конец, и весь хвост создаются в неинициализированной памяти
+                detail::UninitializedCopyN(std::ranges::next(src, tail), count - tail, old_end);
+                try {
+                    detail::OverwriteData(pos, old_end, pos + count);
+                } catch (...) {
+                    std::destroy(old_end, pos + count);
+                    throw;
+                }
+                size_ += count;
+                std::ranges::copy_n(src, tail, pos);
+            }
+        }
+
+        return MakeIterator(Data() + it_pos);
+    }
+
+    // Добавляет элементы однопроходного диапазона по одному. При исключении добавленные элементы удаляются
+    template <typename Iter, typename Sentinel>
+    constexpr void AppendOneByOne(Iter first, Sentinel last) {
+        const size_t old_size = size_;
+        try {
+            for (; first != last; ++first) {
+                EmplaceBack(*first);
+            }
+        } catch (...) {
+            std::destroy(Data() + old_size, DataEnd());
+            size_ = old_size;
+            throw;
+        }
+    }
+
+    // Присваивает вектору содержимое диапазона, по возможности переиспользуя уже созданные элементы
+    template <typename InputIt>
+    constexpr void AssignRange(InputIt first, InputIt last) {
+        const size_t count = std::distance(first, last);
+
+        if (Capacity() >= count) {
+            // До этой позиции будет присваивание, а после - разрушение или инициализация
+            size_t min_size = std::min(size_, count);
+            InputIt mid = std::next(first, min_size);
+            std::copy(first, mid, Data());
+
+            if (size_ > count) {
+                std::destroy(Data() + min_size, DataEnd());
+            } else {
+                detail::UninitializedCopy(mid, last, Data() + min_size);
+            }
+            size_ = count;
+        } else {
+            Vector tmp(first, last, GetAllocator());
+            Swap(tmp);
         }
     }
 };
 
+// Удаляет все элементы, для которых pred возвращает true, за один проход: оставшиеся элементы сдвигаются по одному разу,
+// а хвост разрушается одним вызовом. Возвращает число удалённых элементов
+template <typename T, typename Allocator, typename GrowthPolicy, typename Instrumentation, typename Predicate>
+constexpr size_t EraseIf(Vector<T, Allocator, GrowthPolicy, Instrumentation>& v, Predicate pred) {
+    const size_t old_size = v.Size();
+    v.Erase(std::remove_if(v.begin(), v.end(), pred), v.end());
+    return old_size - v.Size();
+}
+
+// Удаляет все элементы, равные value, за один проход. value не должен ссылаться на элемент самого вектора
+template <typename T, typename Allocator, typename GrowthPolicy, typename Instrumentation, typename U>
+constexpr size_t Remove(Vector<T, Allocator, GrowthPolicy, Instrumentation>& v, const U& value) {
+    return EraseIf(v, [&value](const T& elem) {
+        return elem == value;
+    });
+}
+
 template <typename T>
 Vector(size_t, T) -> Vector<T>;
 
@@ -379,4 +1895,30 @@ template <typename T>
 Vector(std::initializer_list<T>) -> Vector<T>;
 
 template <typename Iter>
-Vector(Iter, Iter) -> Vector<typename std::iterator_traits<Iter>::value_type>;
\ No newline at end of file
+Vector(Iter, Iter) -> Vector<typename std::iterator_traits<Iter>::value_type>;
+
+template <typename Iter, typename Allocator>
+Vector(Iter, Iter, Allocator) -> Vector<typename std::iterator_traits<Iter>::value_type, Allocator>;
+
+// Переносит в std::array вектор, который функция make строит во время компиляции. Память, выделенная при
+// constexpr-вычислении, не может дожить до выполнения программы, поэтому готовая таблица замораживается в массив:
+// он вычисляется компилятором и ложится в секцию только для чтения, общую для всех процессов с этим исполняемым файлом
+//     constexpr auto SQUARES = FreezeToArray<[] {
+//         Vector<int> v;
+//         for (int i = 0; i < 100; ++i) {
+//             v.PushBack(i * i);
+//         }
+//         return v;
+//     }>();
+template <auto Make>
+constexpr auto FreezeToArray() {
+    using VectorType = decltype(Make());
+    using T = typename VectorType::value_type;
+    static_assert(std::is_default_constructible_v<T>, "Elements of a frozen table must be default constructible");
+
+    constexpr size_t SIZE = Make().Size();
+    const VectorType v = Make();
+    std::array<T, SIZE> result{};
+    std::copy(v.begin(), v.end(), result.begin());
+    return result;
+}
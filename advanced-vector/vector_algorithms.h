@@ -0,0 +1,552 @@
+#pragma once
+
+#include "checks.h"
+
+#include <algorithm>
+#include <atomic>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <numeric>
+#include <ranges>
+#include <type_traits>
+
+// Векторизованные алгоритмы над непрерывными массивами арифметических типов: Fill, Find, Count, Min, Max, Sum, Equal.
+// Работают прямо по begin()/end() Vector (или по указателям), без проверок operator[].
+// Ядра написаны один раз на векторных расширениях GCC/Clang и собираются под несколько наборов инструкций:
+// AVX-512 и AVX2 выбираются во время выполнения через __builtin_cpu_supports, 128-битные векторы (SSE2 на x86-64,
+// NEON на AArch64) доступны всегда, для остальных платформ и типов остаётся скалярный код.
+// Основной цикл начинается с границы вектора, поэтому буферы из AlignedAllocator/CacheAlignedAllocator
+// (allocators.h) обрабатываются выровненными загрузками без скалярной головы
+namespace simd {
+
+enum class Level {
+    SCALAR,
+    VECTOR128, // SSE2 или NEON
+    AVX2,
+    AVX512,    // AVX-512F, AVX-512BW и AVX-512DQ
+};
+
+// Типы, для которых есть векторные ядра. Остальные T обрабатываются стандартными алгоритмами
+template <typename T>
+concept Vectorizable = (std::integral<T> && !std::same_as<T, bool>) || std::same_as<T, float> || std::same_as<T, double>;
+
+// Sum целых копит в 64 битах (с переполнением по модулю 2^64), вещественных - в самом T
+template <typename T>
+using SumResult = std::conditional_t<std::integral<T>, std::conditional_t<std::is_signed_v<T>, int64_t, uint64_t>, T>;
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define ADVANCED_VECTOR_SIMD_X86 1
+#elif defined(__GNUC__) && (defined(__aarch64__) || defined(__ARM_NEON))
+#define ADVANCED_VECTOR_SIMD_NEON 1
+#endif
+
+// Лучший уровень, который поддерживает процессор
+inline Level DetectLevel() noexcept {
+#if defined(ADVANCED_VECTOR_SIMD_X86)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw") && __builtin_cpu_supports("avx512dq")) {
+        return Level::AVX512;
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        return Level::AVX2;
+    }
+    return Level::VECTOR128;
+#elif defined(ADVANCED_VECTOR_SIMD_NEON)
+    return Level::VECTOR128;
+#else
+    return Level::SCALAR;
+#endif
+}
+
+namespace detail {
+
+inline std::atomic<Level> active_level = DetectLevel();
+
+}  // namespace detail
+
+inline Level ActiveLevel() noexcept {
+    return detail::active_level.load(std::memory_order_relaxed);
+}
+
+// Ограничивает используемый уровень (для тестов и сравнения реализаций). Выше поддерживаемого процессором не поднимается
+inline void SetLevel(Level level) noexcept {
+    detail::active_level.store(std::min(level, DetectLevel()), std::memory_order_relaxed);
+}
+
+namespace detail {
+
+// Скалярные версии: обрабатывают хвосты векторных циклов, уровень SCALAR и типы без векторных ядер
+
+template <typename T>
+void FillScalar(T* first, size_t n, T value) {
+    std::fill_n(first, n, value);
+}
+
+template <typename T>
+size_t FindScalar(const T* first, size_t n, T value) {
+    return std::find(first, first + n, value) - first;
+}
+
+template <typename T>
+size_t CountScalar(const T* first, size_t n, T value) {
+    return std::count(first, first + n, value);
+}
+
+template <typename T>
+T MinScalar(const T* first, size_t n) {
+    return *std::min_element(first, first + n);
+}
+
+template <typename T>
+T MaxScalar(const T* first, size_t n) {
+    return *std::max_element(first, first + n);
+}
+
+template <typename T>
+SumResult<T> SumScalar(const T* first, size_t n) {
+    if constexpr (std::integral<T>) {
+        uint64_t sum = 0;
+        for (size_t i = 0; i < n; ++i) {
+            sum += static_cast<uint64_t>(static_cast<SumResult<T>>(first[i]));
+        }
+        return static_cast<SumResult<T>>(sum);
+    } else {
+        return std::accumulate(first, first + n, T{});
+    }
+}
+
+template <typename T>
+bool EqualScalar(const T* first1, size_t n, const T* first2) {
+    return std::equal(first1, first1 + n, first2);
+}
+
+#if defined(ADVANCED_VECTOR_SIMD_X86) || defined(ADVANCED_VECTOR_SIMD_NEON)
+
+// Векторные ядра. Все вспомогательные функции встраиваются принудительно: так они компилируются с набором инструкций
+// вызывающей функции. Векторы передаются только по ссылке, чтобы не зависеть от ABI передачи AVX-регистров
+#define ADVANCED_VECTOR_SIMD_INLINE inline __attribute__((always_inline))
+
+template <typename T, size_t Bytes>
+struct VecOf {
+    typedef T Type __attribute__((vector_size(Bytes)));
+};
+
+template <typename T, size_t Bytes>
+using Vec = typename VecOf<T, Bytes>::Type;
+
+// Беззнаковое целое того же размера, что и дорожка маски сравнения
+template <size_t Size>
+using UnsignedOfSize = std::conditional_t<Size == 1, uint8_t,
+                       std::conditional_t<Size == 2, uint16_t,
+                       std::conditional_t<Size == 4, uint32_t, uint64_t>>>;
+
+// Элементов до границы Bytes байт (но не больше n)
+template <size_t Bytes, typename T>
+ADVANCED_VECTOR_SIMD_INLINE size_t HeadToAlignment(const T* first, size_t n) {
+    const size_t misalignment = reinterpret_cast<uintptr_t>(first) % Bytes;
+    return std::min(n, misalignment == 0 ? 0 : (Bytes - misalignment) / sizeof(T));
+}
+
+template <size_t Bytes, typename V, typename T>
+ADVANCED_VECTOR_SIMD_INLINE void LoadAligned(V& out, const T* src) {
+    __builtin_memcpy(&out, __builtin_assume_aligned(src, Bytes), sizeof(V));
+}
+
+template <typename V, typename T>
+ADVANCED_VECTOR_SIMD_INLINE void LoadUnaligned(V& out, const T* src) {
+    __builtin_memcpy(&out, src, sizeof(V));
+}
+
+template <size_t Bytes, typename V, typename T>
+ADVANCED_VECTOR_SIMD_INLINE void StoreAligned(T* dest, const V& value) {
+    __builtin_memcpy(__builtin_assume_aligned(dest, Bytes), &value, sizeof(V));
+}
+
+template <typename V, typename T>
+ADVANCED_VECTOR_SIMD_INLINE void Broadcast(V& out, T value) {
+    for (size_t i = 0; i < sizeof(V) / sizeof(T); ++i) {
+        out[i] = value;
+    }
+}
+
+// Сколько векторов обрабатывается за шаг развёрнутого цикла: независимые цепочки min/max и сумм не ждут друг друга,
+// а маски Find/Equal сворачиваются в одну проверку на четыре вектора
+inline constexpr size_t UNROLL = 4;
+
+// Есть ли в маске сравнения хоть одна истинная дорожка
+template <typename M>
+ADVANCED_VECTOR_SIMD_INLINE bool AnyTrue(const M& mask) {
+    constexpr size_t WORDS = sizeof(M) / sizeof(uint64_t);
+    const auto words = __builtin_bit_cast(Vec<uint64_t, sizeof(M)>, mask);
+    uint64_t any = 0;
+    for (size_t i = 0; i < WORDS; ++i) {
+        any |= words[i];
+    }
+    return any != 0;
+}
+
+struct FillKernel {
+    template <size_t Bytes, typename T>
+    ADVANCED_VECTOR_SIMD_INLINE static void Run(T* first, size_t n, T value) {
+        using V = Vec<T, Bytes>;
+        constexpr size_t LANES = Bytes / sizeof(T);
+
+        size_t i = HeadToAlignment<Bytes>(first, n);
+        FillScalar(first, i, value);
+        V block;
+        Broadcast(block, value);
+        for (; i + LANES <= n; i += LANES) {
+            StoreAligned<Bytes>(first + i, block);
+        }
+        FillScalar(first + i, n - i, value);
+    }
+};
+
+struct FindKernel {
+    template <size_t Bytes, typename T>
+    ADVANCED_VECTOR_SIMD_INLINE static size_t Run(const T* first, size_t n, T value) {
+        using V = Vec<T, Bytes>;
+        using Mask = Vec<UnsignedOfSize<sizeof(T)>, Bytes>;
+        constexpr size_t LANES = Bytes / sizeof(T);
+
+        size_t i = HeadToAlignment<Bytes>(first, n);
+        if (const size_t found = FindScalar(first, i, value); found < i) {
+            return found;
+        }
+        V needle;
+        Broadcast(needle, value);
+        for (; i + UNROLL * LANES <= n; i += UNROLL * LANES) {
+            // Маски сразу приводятся к беззнаковым векторам: OR самих результатов сравнения GCC, встраивая ядро
+            // в функцию с target AVX-512, разбирает на скалярные сравнения
+            Mask found{};
+            for (size_t k = 0; k < UNROLL; ++k) {
+                V block;
+                LoadAligned<Bytes>(block, first + i + k * LANES);
+                found |= __builtin_bit_cast(Mask, block == needle);
+            }
+            if (AnyTrue(found)) {
+                return i + FindScalar(first + i, UNROLL * LANES, value);
+            }
+        }
+        return i + FindScalar(first + i, n - i, value);
+    }
+};
+
+struct CountKernel {
+    template <size_t Bytes, typename T>
+    ADVANCED_VECTOR_SIMD_INLINE static size_t Run(const T* first, size_t n, T value) {
+        using V = Vec<T, Bytes>;
+        using Lane = UnsignedOfSize<sizeof(T)>;
+        using Counters = Vec<Lane, Bytes>;
+        constexpr size_t LANES = Bytes / sizeof(T);
+        // Счётчики дорожек сбрасываются в общий итог раньше, чем могут переполниться
+        constexpr size_t FLUSH_BLOCKS = std::min<size_t>(std::numeric_limits<Lane>::max(), size_t{1} << 16);
+
+        size_t i = HeadToAlignment<Bytes>(first, n);
+        size_t count = CountScalar(first, i, value);
+        V needle;
+        Broadcast(needle, value);
+        while (i + LANES <= n) {
+            Counters counters{};
+            for (size_t blocks = 0; blocks < FLUSH_BLOCKS && i + LANES <= n; ++blocks, i += LANES) {
+                V block;
+                LoadAligned<Bytes>(block, first + i);
+                // Истинная дорожка маски - это все единицы, то есть -1
+                counters -= __builtin_bit_cast(Counters, block == needle);
+            }
+            for (size_t lane = 0; lane < LANES; ++lane) {
+                count += counters[lane];
+            }
+        }
+        return count + CountScalar(first + i, n - i, value);
+    }
+};
+
+template <bool IsMin>
+struct MinMaxKernel {
+    template <size_t Bytes, typename T>
+    ADVANCED_VECTOR_SIMD_INLINE static T Run(const T* first, size_t n) {
+        using V = Vec<T, Bytes>;
+        constexpr size_t LANES = Bytes / sizeof(T);
+
+        const size_t head = HeadToAlignment<Bytes>(first, n);
+        if (n - head < LANES) {
+            return IsMin ? MinScalar(first, n) : MaxScalar(first, n);
+        }
+
+        size_t i = head;
+        V bests[UNROLL];
+        // Пока данных меньше, чем на все цепочки, они начинаются с одного и того же вектора
+        for (size_t k = 0; k < UNROLL; ++k) {
+            LoadAligned<Bytes>(bests[k], first + i + (i + (k + 1) * LANES <= n ? k * LANES : 0));
+        }
+        i += std::min(UNROLL, (n - i) / LANES) * LANES;
+        for (; i + UNROLL * LANES <= n; i += UNROLL * LANES) {
+            for (size_t k = 0; k < UNROLL; ++k) {
+                V block;
+                LoadAligned<Bytes>(block, first + i + k * LANES);
+                bests[k] = IsMin ? (block < bests[k] ? block : bests[k]) : (bests[k] < block ? block : bests[k]);
+            }
+        }
+        for (; i + LANES <= n; i += LANES) {
+            V block;
+            LoadAligned<Bytes>(block, first + i);
+            bests[0] = IsMin ? (block < bests[0] ? block : bests[0]) : (bests[0] < block ? block : bests[0]);
+        }
+
+        V best = bests[0];
+        for (size_t k = 1; k < UNROLL; ++k) {
+            best = IsMin ? (bests[k] < best ? bests[k] : best) : (best < bests[k] ? bests[k] : best);
+        }
+        const auto pick = [](T lhs, T rhs) {
+            return IsMin ? std::min(lhs, rhs) : std::max(lhs, rhs);
+        };
+        T result = best[0];
+        for (size_t lane = 1; lane < LANES; ++lane) {
+            result = pick(result, best[lane]);
+        }
+        if (head > 0) {
+            result = pick(result, IsMin ? MinScalar(first, head) : MaxScalar(first, head));
+        }
+        if (i < n) {
+            result = pick(result, IsMin ? MinScalar(first + i, n - i) : MaxScalar(first + i, n - i));
+        }
+        return result;
+    }
+};
+
+struct SumKernel {
+    template <size_t Bytes, typename T>
+    ADVANCED_VECTOR_SIMD_INLINE static SumResult<T> Run(const T* first, size_t n) {
+        // Целые за один шаг берут столько элементов, сколько 64-битных дорожек в векторе, и расширяют их до 64 бит
+        // одной инструкцией; дальше складываются без знака, чтобы переполнение было определено, как в скалярной версии
+        using Acc = std::conditional_t<std::integral<T>, uint64_t, T>;
+        using AccVec = Vec<Acc, Bytes>;
+        constexpr size_t STEP = Bytes / sizeof(Acc);
+        using Block = Vec<T, STEP * sizeof(T)>;
+        constexpr size_t CHAINS = UNROLL;
+
+        size_t i = HeadToAlignment<Bytes>(first, n);
+        const SumResult<T> head = SumScalar(first, i);
+        AccVec sums[CHAINS] = {};
+        for (; i + CHAINS * STEP <= n; i += CHAINS * STEP) {
+            for (size_t k = 0; k < CHAINS; ++k) {
+                Block block;
+                LoadUnaligned(block, first + i + k * STEP);
+                if constexpr (std::integral<T>) {
+                    sums[k] += __builtin_bit_cast(AccVec, __builtin_convertvector(block, Vec<SumResult<T>, Bytes>));
+                } else {
+                    sums[k] += block;
+                }
+            }
+        }
+
+        const AccVec total = (sums[0] + sums[1]) + (sums[2] + sums[3]);
+        Acc sum = 0;
+        for (size_t lane = 0; lane < STEP; ++lane) {
+            sum += total[lane];
+        }
+        const SumResult<T> tail = SumScalar(first + i, n - i);
+        if constexpr (std::integral<T>) {
+            return static_cast<SumResult<T>>(sum + static_cast<uint64_t>(head) + static_cast<uint64_t>(tail));
+        } else {
+            return head + sum + tail;
+        }
+    }
+};
+
+struct EqualKernel {
+    template <size_t Bytes, typename T>
+    ADVANCED_VECTOR_SIMD_INLINE static bool Run(const T* first1, size_t n, const T* first2) {
+        using V = Vec<T, Bytes>;
+        using Mask = Vec<UnsignedOfSize<sizeof(T)>, Bytes>;
+        constexpr size_t LANES = Bytes / sizeof(T);
+
+        size_t i = HeadToAlignment<Bytes>(first1, n);
+        if (!EqualScalar(first1, i, first2)) {
+            return false;
+        }
+        for (; i + UNROLL * LANES <= n; i += UNROLL * LANES) {
+            Mask differs{};
+            for (size_t k = 0; k < UNROLL; ++k) {
+                V lhs;
+                V rhs;
+                LoadAligned<Bytes>(lhs, first1 + i + k * LANES);
+                LoadUnaligned(rhs, first2 + i + k * LANES);
+                differs |= __builtin_bit_cast(Mask, lhs != rhs);
+            }
+            if (AnyTrue(differs)) {
+                return false;
+            }
+        }
+        return EqualScalar(first1 + i, n - i, first2 + i);
+    }
+};
+
+// Точки входа под конкретные наборы инструкций: ядро встраивается и компилируется с их target
+#if defined(ADVANCED_VECTOR_SIMD_X86)
+template <typename Kernel, typename... Args>
+__attribute__((target("avx512f,avx512bw,avx512dq"))) auto RunAvx512(Args... args) {
+    return Kernel::template Run<64>(args...);
+}
+
+template <typename Kernel, typename... Args>
+__attribute__((target("avx2"))) auto RunAvx2(Args... args) {
+    return Kernel::template Run<32>(args...);
+}
+#endif
+
+template <typename Kernel, typename... Args>
+auto RunVector128(Args... args) {
+    return Kernel::template Run<16>(args...);
+}
+
+#undef ADVANCED_VECTOR_SIMD_INLINE
+
+#endif
+
+// Выбирает реализацию по ActiveLevel(); scalar вызывается на уровне SCALAR
+template <typename Kernel, typename Scalar, typename... Args>
+auto Dispatch([[maybe_unused]] Scalar scalar, Args... args) {
+#if defined(ADVANCED_VECTOR_SIMD_X86) || defined(ADVANCED_VECTOR_SIMD_NEON)
+    switch (ActiveLevel()) {
+#if defined(ADVANCED_VECTOR_SIMD_X86)
+        case Level::AVX512:
+            return RunAvx512<Kernel>(args...);
+        case Level::AVX2:
+            return RunAvx2<Kernel>(args...);
+#endif
+        case Level::VECTOR128:
+            return RunVector128<Kernel>(args...);
+        default:
+            break;
+    }
+#endif
+    return scalar(args...);
+}
+
+}  // namespace detail
+
+template <typename T>
+void Fill(T* first, T* last, const std::type_identity_t<T>& value) {
+    if constexpr (Vectorizable<T>) {
+        detail::Dispatch<detail::FillKernel>(detail::FillScalar<T>, first, static_cast<size_t>(last - first), value);
+    } else {
+        std::fill(first, last, value);
+    }
+}
+
+// Первый элемент, равный value, или last
+template <typename T>
+T* Find(T* first, T* last, const std::remove_const_t<T>& value) {
+    using U = std::remove_const_t<T>;
+    if constexpr (Vectorizable<U>) {
+        const size_t n = last - first;
+        return first + detail::Dispatch<detail::FindKernel>(detail::FindScalar<U>, static_cast<const U*>(first), n, value);
+    } else {
+        return std::find(first, last, value);
+    }
+}
+
+template <typename T>
+size_t Count(const T* first, const T* last, const std::type_identity_t<T>& value) {
+    if constexpr (Vectorizable<T>) {
+        return detail::Dispatch<detail::CountKernel>(detail::CountScalar<T>, first, static_cast<size_t>(last - first), value);
+    } else {
+        return std::count(first, last, value);
+    }
+}
+
+// Наименьший элемент непустого диапазона. Если в диапазоне есть NaN, результат не определён
+template <typename T>
+T Min(const T* first, const T* last) {
+    ADVANCED_VECTOR_CHECK_BOUNDS(first != last);
+    if constexpr (Vectorizable<T>) {
+        return detail::Dispatch<detail::MinMaxKernel<true>>(detail::MinScalar<T>, first, static_cast<size_t>(last - first));
+    } else {
+        return *std::min_element(first, last);
+    }
+}
+
+// Наибольший элемент непустого диапазона. Если в диапазоне есть NaN, результат не определён
+template <typename T>
+T Max(const T* first, const T* last) {
+    ADVANCED_VECTOR_CHECK_BOUNDS(first != last);
+    if constexpr (Vectorizable<T>) {
+        return detail::Dispatch<detail::MinMaxKernel<false>>(detail::MaxScalar<T>, first, static_cast<size_t>(last - first));
+    } else {
+        return *std::max_element(first, last);
+    }
+}
+
+// Сумма элементов. Векторные версии складывают вещественные числа в другом порядке, чем последовательный цикл,
+// поэтому результат может отличаться в последних битах
+template <typename T>
+auto Sum(const T* first, const T* last) {
+    if constexpr (Vectorizable<T>) {
+        return detail::Dispatch<detail::SumKernel>(detail::SumScalar<T>, first, static_cast<size_t>(last - first));
+    } else {
+        return std::accumulate(first, last, T{});
+    }
+}
+
+// Поэлементное сравнение [first1, last1) с диапазоном той же длины, начинающимся в first2
+template <typename T>
+bool Equal(const T* first1, const T* last1, const T* first2) {
+    if constexpr (Vectorizable<T>) {
+        return detail::Dispatch<detail::EqualKernel>(detail::EqualScalar<T>, first1, static_cast<size_t>(last1 - first1), first2);
+    } else {
+        return std::equal(first1, last1, first2);
+    }
+}
+
+// Те же алгоритмы для непрерывных контейнеров целиком, например Vector<float>
+
+template <std::ranges::contiguous_range Range>
+void Fill(Range&& range, const std::ranges::range_value_t<Range>& value) {
+    auto* first = std::ranges::data(range);
+    Fill(first, first + std::ranges::size(range), value);
+}
+
+template <std::ranges::contiguous_range Range>
+auto Find(Range&& range, const std::ranges::range_value_t<Range>& value) {
+    auto* first = std::ranges::data(range);
+    return Find(first, first + std::ranges::size(range), value);
+}
+
+template <std::ranges::contiguous_range Range>
+size_t Count(const Range& range, const std::ranges::range_value_t<Range>& value) {
+    const auto* first = std::ranges::data(range);
+    return Count(first, first + std::ranges::size(range), value);
+}
+
+template <std::ranges::contiguous_range Range>
+auto Min(const Range& range) {
+    const auto* first = std::ranges::data(range);
+    return Min(first, first + std::ranges::size(range));
+}
+
+template <std::ranges::contiguous_range Range>
+auto Max(const Range& range) {
+    const auto* first = std::ranges::data(range);
+    return Max(first, first + std::ranges::size(range));
+}
+
+template <std::ranges::contiguous_range Range>
+auto Sum(const Range& range) {
+    const auto* first = std::ranges::data(range);
+    return Sum(first, first + std::ranges::size(range));
+}
+
+template <std::ranges::contiguous_range Lhs, std::ranges::contiguous_range Rhs>
+bool Equal(const Lhs& lhs, const Rhs& rhs) {
+    const auto* first = std::ranges::data(lhs);
+    const size_t size = std::ranges::size(lhs);
+    return size == static_cast<size_t>(std::ranges::size(rhs)) && Equal(first, first + size, std::ranges::data(rhs));
+}
+
+}  // namespace simd
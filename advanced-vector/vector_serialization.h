@@ -0,0 +1,267 @@
+#pragma once
+
+#include "vector.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <limits>
+#include <ostream>
+#include <span>
+#include <stdexcept>
+#include <system_error>
+#include <type_traits>
+
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+// Двоичный формат Vector<T> для тривиально копируемых T: заголовок на SERIALIZED_HEADER_BYTES байт, за которым
+// без промежутков идут байты элементов. Запись и чтение обходятся одним системным вызовом на весь массив
+// (writev заголовка и данных, read прямо в память вектора), а уже загруженный буфер можно читать без копирования
+// через ViewSerializedVector. Формат не переносим между платформами с разным порядком байтов или размером T:
+// такие файлы отвергаются при чтении
+
+// Заголовок сериализованного вектора
+struct SerializedVectorHeader {
+    uint64_t magic;
+    uint32_t byte_order;
+    uint32_t version;
+    uint64_t element_size;
+    uint64_t element_alignment;
+    uint64_t count;
+};
+
+// Элементы начинаются с этого смещения, поэтому выровнены не хуже кэш-линии
+inline constexpr size_t SERIALIZED_HEADER_BYTES = 64;
+// Если длина источника неизвестна, память под элементы выделяется порциями такого размера по мере чтения,
+// чтобы испорченный заголовок с огромным числом элементов не заставил выделить её всю заранее
+inline constexpr size_t SERIALIZED_READ_CHUNK_BYTES = size_t{1} << 20;
+inline constexpr uint64_t SERIALIZED_VECTOR_MAGIC = 0x314345564c525353; // "SSRLVEC1"
+inline constexpr uint32_t SERIALIZED_BYTE_ORDER = 0x01020304;
+inline constexpr uint32_t SERIALIZED_VERSION = 1;
+
+static_assert(sizeof(SerializedVectorHeader) <= SERIALIZED_HEADER_BYTES);
+
+// Данные не являются сериализованным вектором нужного типа или оборвались раньше времени
+class SerializationError : public std::runtime_error {
+public:
+    using std::runtime_error::runtime_error;
+};
+
+namespace detail {
+
+template <typename T>
+concept Serializable = std::is_trivially_copyable_v<T> && alignof(T) <= SERIALIZED_HEADER_BYTES;
+
+// Заголовок, дополненный нулями до SERIALIZED_HEADER_BYTES
+template <typename T>
+struct PaddedHeader {
+    explicit PaddedHeader(size_t count) noexcept {
+        const SerializedVectorHeader header{
+            .magic = SERIALIZED_VECTOR_MAGIC,
+            .byte_order = SERIALIZED_BYTE_ORDER,
+            .version = SERIALIZED_VERSION,
+            .element_size = sizeof(T),
+            .element_alignment = alignof(T),
+            .count = count,
+        };
+        std::memcpy(bytes, &header, sizeof(header));
+    }
+
+    std::byte bytes[SERIALIZED_HEADER_BYTES] = {};
+};
+
+// Проверяет заголовок и возвращает число элементов
+template <typename T>
+size_t ParseHeader(const std::byte* bytes) {
+    SerializedVectorHeader header;
+    std::memcpy(&header, bytes, sizeof(header));
+
+    if (header.magic != SERIALIZED_VECTOR_MAGIC) {
+        throw SerializationError("Not a serialized vector");
+    }
+    if (header.byte_order != SERIALIZED_BYTE_ORDER) {
+        throw SerializationError("Serialized vector has a different byte order");
+    }
+    if (header.version != SERIALIZED_VERSION) {
+        throw SerializationError("Unsupported serialized vector version");
+    }
+    if (header.element_size != sizeof(T) || header.element_alignment != alignof(T)) {
+        throw SerializationError("Serialized vector has a different element type");
+    }
+    if (header.count > std::numeric_limits<size_t>::max() / sizeof(T)) {
+        throw SerializationError("Serialized vector is too large");
+    }
+    return static_cast<size_t>(header.count);
+}
+
+[[noreturn]] inline void ThrowSystemError(const char* what) {
+    throw std::system_error(errno, std::generic_category(), what);
+}
+
+// Пишет все буферы parts, повторяя writev после частичной записи
+inline void WriteAll(int fd, iovec* parts, int count) {
+    while (count > 0) {
+        ssize_t written = ::writev(fd, parts, count);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            ThrowSystemError("writev");
+        }
+        while (count > 0 && static_cast<size_t>(written) >= parts->iov_len) {
+            written -= static_cast<ssize_t>(parts->iov_len);
+            ++parts;
+            --count;
+        }
+        if (count > 0) {
+            parts->iov_base = static_cast<std::byte*>(parts->iov_base) + written;
+            parts->iov_len -= static_cast<size_t>(written);
+        }
+    }
+}
+
+// Читает ровно size байт, повторяя read после частичного чтения
+inline void ReadAll(int fd, void* dest, size_t size) {
+    auto* bytes = static_cast<std::byte*>(dest);
+    while (size > 0) {
+        const ssize_t received = ::read(fd, bytes, size);
+        if (received < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            ThrowSystemError("read");
+        }
+        if (received == 0) {
+            throw SerializationError("Serialized vector is truncated");
+        }
+        bytes += received;
+        size -= static_cast<size_t>(received);
+    }
+}
+
+// Читает count элементов в конец пустого v порциями по SERIALIZED_READ_CHUNK_BYTES: вектор растёт, только когда
+// предыдущая порция уже прочитана. read(dest, bytes) читает ровно bytes байт или бросает исключение.
+// При исключении v остаётся пустым
+template <typename Vec, typename Read>
+void ReadInChunks(Vec& v, size_t count, Read read) {
+    using T = typename Vec::value_type;
+    const size_t chunk = std::max<size_t>(1, SERIALIZED_READ_CHUNK_BYTES / sizeof(T));
+    try {
+        while (v.Size() < count) {
+            const size_t done = v.Size();
+            v.ResizeDefaultInit(done + std::min(chunk, count - done));
+            read(v.Data() + done, (v.Size() - done) * sizeof(T));
+        }
+    } catch (...) {
+        v.Clear();
+        throw;
+    }
+}
+
+}  // namespace detail
+
+template <typename T, typename Allocator, typename GrowthPolicy, typename Instrumentation>
+size_t SerializedSize(const Vector<T, Allocator, GrowthPolicy, Instrumentation>& v) noexcept {
+    return SERIALIZED_HEADER_BYTES + v.Size() * sizeof(T);
+}
+
+// Пишет вектор в файловый дескриптор одним writev. Ошибки записи - std::system_error
+template <detail::Serializable T, typename Allocator, typename GrowthPolicy, typename Instrumentation>
+void WriteVector(int fd, const Vector<T, Allocator, GrowthPolicy, Instrumentation>& v) {
+    detail::PaddedHeader<T> header(v.Size());
+    iovec parts[] = {
+        {.iov_base = header.bytes, .iov_len = sizeof(header.bytes)},
+        {.iov_base = const_cast<T*>(v.Data()), .iov_len = v.Size() * sizeof(T)},
+    };
+    detail::WriteAll(fd, parts, v.Size() == 0 ? 1 : 2);
+}
+
+template <detail::Serializable T, typename Allocator, typename GrowthPolicy, typename Instrumentation>
+void WriteVector(std::ostream& out, const Vector<T, Allocator, GrowthPolicy, Instrumentation>& v) {
+    const detail::PaddedHeader<T> header(v.Size());
+    out.write(reinterpret_cast<const char*>(header.bytes), sizeof(header.bytes));
+    out.write(reinterpret_cast<const char*>(v.Data()), static_cast<std::streamsize>(v.Size() * sizeof(T)));
+    if (!out) {
+        throw SerializationError("Failed to write serialized vector");
+    }
+}
+
+// Заменяет содержимое v вектором, прочитанным из дескриптора: память выделяется через ResizeDefaultInit без обнуления
+// (уже имеющаяся ёмкость переиспользуется), а элементы читаются в неё напрямую. Для обычного файла число элементов
+// из заголовка сначала сверяется с остатком файла, и всё читается одним read; из канала или сокета - порциями
+// по SERIALIZED_READ_CHUNK_BYTES. При исключении v остаётся пустым
+template <detail::Serializable T, typename Allocator, typename GrowthPolicy, typename Instrumentation>
+void ReadVector(int fd, Vector<T, Allocator, GrowthPolicy, Instrumentation>& v) {
+    v.Clear();
+    std::byte header[SERIALIZED_HEADER_BYTES];
+    detail::ReadAll(fd, header, sizeof(header));
+    const size_t count = detail::ParseHeader<T>(header);
+
+    struct stat info {};
+    if (::fstat(fd, &info) != 0) {
+        detail::ThrowSystemError("fstat");
+    }
+    if (!S_ISREG(info.st_mode)) {
+        detail::ReadInChunks(v, count, [fd](void* dest, size_t bytes) {
+            detail::ReadAll(fd, dest, bytes);
+        });
+        return;
+    }
+
+    const off_t position = ::lseek(fd, 0, SEEK_CUR);
+    if (position < 0) {
+        detail::ThrowSystemError("lseek");
+    }
+    const size_t remaining = info.st_size > position ? static_cast<size_t>(info.st_size - position) : 0;
+    if (remaining < count * sizeof(T)) {
+        throw SerializationError("Serialized vector is truncated");
+    }
+    v.ResizeDefaultInit(count);
+    try {
+        detail::ReadAll(fd, v.Data(), count * sizeof(T));
+    } catch (...) {
+        v.Clear();
+        throw;
+    }
+}
+
+// Длина потока заранее неизвестна, поэтому элементы читаются порциями по SERIALIZED_READ_CHUNK_BYTES
+template <detail::Serializable T, typename Allocator, typename GrowthPolicy, typename Instrumentation>
+void ReadVector(std::istream& in, Vector<T, Allocator, GrowthPolicy, Instrumentation>& v) {
+    v.Clear();
+    std::byte header[SERIALIZED_HEADER_BYTES];
+    if (!in.read(reinterpret_cast<char*>(header), sizeof(header))) {
+        throw SerializationError("Serialized vector is truncated");
+    }
+    const size_t count = detail::ParseHeader<T>(header);
+
+    detail::ReadInChunks(v, count, [&in](void* dest, size_t bytes) {
+        if (!in.read(static_cast<char*>(dest), static_cast<std::streamsize>(bytes))) {
+            throw SerializationError("Serialized vector is truncated");
+        }
+    });
+}
+
+// Элементы сериализованного вектора прямо в buffer, без копирования (например, в отображённом в память файле).
+// Буфер должен быть выровнен не хуже alignof(T) и жить, пока используется результат
+template <detail::Serializable T>
+std::span<const T> ViewSerializedVector(std::span<const std::byte> buffer) {
+    if (buffer.size() < SERIALIZED_HEADER_BYTES) {
+        throw SerializationError("Serialized vector is truncated");
+    }
+    const size_t count = detail::ParseHeader<T>(buffer.data());
+    if (buffer.size() - SERIALIZED_HEADER_BYTES < count * sizeof(T)) {
+        throw SerializationError("Serialized vector is truncated");
+    }
+
+    const std::byte* payload = buffer.data() + SERIALIZED_HEADER_BYTES;
+    if (reinterpret_cast<uintptr_t>(payload) % alignof(T) != 0) {
+        throw std::invalid_argument("Serialized vector buffer is misaligned");
+    }
+    return {reinterpret_cast<const T*>(payload), count};
+}